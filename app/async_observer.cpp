@@ -0,0 +1,231 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "async_observer.h"
+
+#include <boost/log/trivial.hpp>
+
+namespace MouseTrack {
+
+AsyncObserver::AsyncObserver(PipelineObserver *observer, Policy policy,
+                             size_t capacity)
+    : _observer(observer), _policy(policy),
+      _capacity(capacity == 0 ? 1 : capacity), _busy(false), _shouldRun(true),
+      _dropped(0) {
+  if (_observer == nullptr) {
+    throw "AsyncObserver needs an observer to forward to.";
+  }
+  _worker = std::thread([this]() { run(); });
+}
+
+AsyncObserver::~AsyncObserver() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _shouldRun = false;
+  }
+  _changed.notify_all();
+  _worker.join();
+}
+
+void AsyncObserver::flush() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _changed.wait(lock, [this]() { return _queue.empty() && !_busy; });
+}
+
+size_t AsyncObserver::dropped() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _dropped;
+}
+
+PipelineObserver *AsyncObserver::observer() const { return _observer; }
+
+AsyncObserver::Policy AsyncObserver::policy() const { return _policy; }
+
+size_t AsyncObserver::capacity() const { return _capacity; }
+
+void AsyncObserver::enqueue(Kind kind,
+                            std::function<void(PipelineObserver *)> call) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (_queue.size() >= _capacity && !makeRoom(kind)) {
+    _changed.wait(lock);
+  }
+  _queue.push_back(Event{kind, std::move(call)});
+  lock.unlock();
+  _changed.notify_all();
+}
+
+bool AsyncObserver::droppable(Kind kind) {
+  return kind != LIFECYCLE && kind != RAW_POINT_CLOUD &&
+         kind != FILTERED_POINT_CLOUD;
+}
+
+bool AsyncObserver::makeRoom(Kind kind) {
+  if (_policy == BLOCK) {
+    return false;
+  }
+  auto victim = _queue.end();
+  if (_policy == COALESCE && droppable(kind)) {
+    // replace an older result of the same step
+    for (auto e = _queue.begin(); e != _queue.end(); ++e) {
+      if (e->kind == kind) {
+        victim = e;
+        break;
+      }
+    }
+  }
+  if (victim == _queue.end()) {
+    // drop oldest result
+    for (auto e = _queue.begin(); e != _queue.end(); ++e) {
+      if (droppable(e->kind)) {
+        victim = e;
+        break;
+      }
+    }
+  }
+  if (victim == _queue.end()) {
+    return false;
+  }
+  _queue.erase(victim);
+  _dropped += 1;
+  return true;
+}
+
+void AsyncObserver::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _changed.wait(lock, [this]() { return !_queue.empty() || !_shouldRun; });
+    if (_queue.empty()) {
+      // asked to stop and everything is delivered
+      break;
+    }
+    Event event = std::move(_queue.front());
+    _queue.pop_front();
+    _busy = true;
+    lock.unlock();
+    _changed.notify_all();
+    try {
+      event.call(_observer);
+    } catch (const std::string &e) {
+      BOOST_LOG_TRIVIAL(warning) << "Exception in asynchronous observer: " << e;
+    } catch (const char *e) {
+      BOOST_LOG_TRIVIAL(warning) << "Exception in asynchronous observer: " << e;
+    } catch (const std::exception &e) {
+      BOOST_LOG_TRIVIAL(warning) << "Exception in asynchronous observer: "
+                                 << e.what();
+    }
+    lock.lock();
+    _busy = false;
+    _changed.notify_all();
+  }
+}
+
+// forwarded calls
+
+void AsyncObserver::pipelineStarted() {
+  enqueue(LIFECYCLE, [=](PipelineObserver *o) { o->pipelineStarted(); });
+}
+
+void AsyncObserver::pipelineTerminated() {
+  enqueue(LIFECYCLE, [=](PipelineObserver *o) { o->pipelineTerminated(); });
+}
+
+void AsyncObserver::newClusterChains(
+    std::shared_ptr<const std::vector<ClusterChain>> chains) {
+  enqueue(LIFECYCLE, [=](PipelineObserver *o) { o->newClusterChains(chains); });
+}
+
+void AsyncObserver::frameStart(FrameNumber frame) {
+  enqueue(LIFECYCLE, [=](PipelineObserver *o) { o->frameStart(frame); });
+}
+
+void AsyncObserver::frameEnd(FrameNumber frame) {
+  enqueue(LIFECYCLE, [=](PipelineObserver *o) { o->frameEnd(frame); });
+}
+
+void AsyncObserver::startFrameWindow(FrameNumber f) {
+  enqueue(LIFECYCLE, [=](PipelineObserver *o) { o->startFrameWindow(f); });
+}
+
+void AsyncObserver::newFrameWindow(FrameNumber f,
+                                   std::shared_ptr<const FrameWindow> window) {
+  enqueue(FRAME_WINDOW,
+          [=](PipelineObserver *o) { o->newFrameWindow(f, window); });
+}
+
+void AsyncObserver::startFrameWindowFiltering(FrameNumber f) {
+  enqueue(LIFECYCLE,
+          [=](PipelineObserver *o) { o->startFrameWindowFiltering(f); });
+}
+
+void AsyncObserver::newFilteredFrameWindow(
+    FrameNumber f, std::shared_ptr<const FrameWindow> window) {
+  enqueue(FILTERED_FRAME_WINDOW,
+          [=](PipelineObserver *o) { o->newFilteredFrameWindow(f, window); });
+}
+
+void AsyncObserver::startRegistration(FrameNumber f) {
+  enqueue(LIFECYCLE, [=](PipelineObserver *o) { o->startRegistration(f); });
+}
+
+void AsyncObserver::newRawPointCloud(FrameNumber f,
+                                     std::shared_ptr<const PointCloud> cloud) {
+  enqueue(RAW_POINT_CLOUD,
+          [=](PipelineObserver *o) { o->newRawPointCloud(f, cloud); });
+}
+
+void AsyncObserver::startPointCloudFiltering(FrameNumber f) {
+  enqueue(LIFECYCLE,
+          [=](PipelineObserver *o) { o->startPointCloudFiltering(f); });
+}
+
+void AsyncObserver::newFilteredPointCloud(
+    FrameNumber f, std::shared_ptr<const PointCloudView> cloud) {
+  enqueue(FILTERED_POINT_CLOUD,
+          [=](PipelineObserver *o) { o->newFilteredPointCloud(f, cloud); });
+}
+
+void AsyncObserver::startClustering(FrameNumber f) {
+  enqueue(LIFECYCLE, [=](PipelineObserver *o) { o->startClustering(f); });
+}
+
+void AsyncObserver::newClusters(
+    FrameNumber f, std::shared_ptr<const std::vector<Cluster>> clusters) {
+  enqueue(CLUSTERS, [=](PipelineObserver *o) { o->newClusters(f, clusters); });
+}
+
+void AsyncObserver::startDescripting(FrameNumber f) {
+  enqueue(LIFECYCLE, [=](PipelineObserver *o) { o->startDescripting(f); });
+}
+
+void AsyncObserver::newDescriptors(
+    FrameNumber f,
+    std::shared_ptr<
+        const std::vector<std::shared_ptr<const ClusterDescriptor>>>
+        descriptors) {
+  enqueue(DESCRIPTORS,
+          [=](PipelineObserver *o) { o->newDescriptors(f, descriptors); });
+}
+
+void AsyncObserver::startMatching(FrameNumber f) {
+  enqueue(LIFECYCLE, [=](PipelineObserver *o) { o->startMatching(f); });
+}
+
+void AsyncObserver::newMatches(
+    FrameNumber f, std::shared_ptr<const std::vector<long>> matches) {
+  enqueue(MATCHES, [=](PipelineObserver *o) { o->newMatches(f, matches); });
+}
+
+void AsyncObserver::startControlPoints(FrameNumber f) {
+  enqueue(LIFECYCLE, [=](PipelineObserver *o) { o->startControlPoints(f); });
+}
+
+void AsyncObserver::newControlPoints(
+    FrameNumber f,
+    std::shared_ptr<const std::vector<Eigen::Vector3d>> controlPoints) {
+  enqueue(CONTROL_POINTS,
+          [=](PipelineObserver *o) { o->newControlPoints(f, controlPoints); });
+}
+
+} // namespace MouseTrack
@@ -0,0 +1,140 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#pragma once
+
+#include "pipeline_observer.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace MouseTrack {
+
+/// Decorator that forwards all calls to another observer on its own thread.
+///
+/// Each call is recorded as an event in a queue and returns immediately, a
+/// worker thread delivers the events to the wrapped observer in the same
+/// order. The guarantees of PipelineObserver still hold for the wrapped
+/// observer, but it may be called after the pipeline finished: use `flush()`
+/// to wait for it (Pipeline does this in `join()` for observers added with a
+/// dispatch policy).
+///
+/// If the queue is full, the policy decides:
+///
+/// - BLOCK: the caller waits until there's room, no event gets lost.
+/// - DROP_OLDEST: the oldest pending result (`new*` calls) is dropped.
+/// - COALESCE: a pending result of the same kind is replaced by the new one,
+///   so only the most recent result of each step is kept. If there is none,
+///   the oldest result is dropped.
+///
+/// Lifecycle events (`pipelineStarted`, `frameStart`, `start*`, `frameEnd`,
+/// `newClusterChains`, ...) are never dropped, the caller blocks if the queue
+/// holds nothing else. Neither are point clouds (`newRawPointCloud`,
+/// `newFilteredPointCloud`): clusters index into the filtered cloud of their
+/// frame, an observer receiving the clusters also needs the clouds.
+class AsyncObserver : public PipelineObserver {
+public:
+  enum Policy { BLOCK, DROP_OLDEST, COALESCE };
+
+  /// `observer` must outlive this object
+  AsyncObserver(PipelineObserver *observer, Policy policy = BLOCK,
+                size_t capacity = 32);
+
+  /// Delivers all pending events, then stops the worker thread
+  ~AsyncObserver();
+
+  /// Blocks until all pending events are delivered
+  void flush();
+
+  /// Number of events lost due to the policy
+  size_t dropped() const;
+
+  PipelineObserver *observer() const;
+  Policy policy() const;
+  size_t capacity() const;
+
+  virtual void pipelineStarted();
+  virtual void pipelineTerminated();
+  virtual void
+  newClusterChains(std::shared_ptr<const std::vector<ClusterChain>> chains);
+  virtual void frameStart(FrameNumber frame);
+  virtual void frameEnd(FrameNumber frame);
+
+  // clang-format off
+  virtual void startFrameWindow     (FrameNumber f);
+  virtual void newFrameWindow       (FrameNumber f, std::shared_ptr<const FrameWindow> window);
+
+  virtual void startFrameWindowFiltering(FrameNumber f);
+  virtual void newFilteredFrameWindow(FrameNumber f, std::shared_ptr<const FrameWindow> window);
+
+  virtual void startRegistration    (FrameNumber f);
+  virtual void newRawPointCloud     (FrameNumber f, std::shared_ptr<const PointCloud> cloud);
+
+  virtual void startPointCloudFiltering(FrameNumber f);
+  virtual void newFilteredPointCloud(FrameNumber f, std::shared_ptr<const PointCloudView> cloud);
+
+  virtual void startClustering      (FrameNumber f);
+  virtual void newClusters          (FrameNumber f, std::shared_ptr<const std::vector<Cluster>> clusters);
+
+  virtual void startDescripting     (FrameNumber f);
+  virtual void newDescriptors       (FrameNumber f, std::shared_ptr<const std::vector<std::shared_ptr<const ClusterDescriptor>>> descriptors);
+
+  virtual void startMatching        (FrameNumber f);
+  virtual void newMatches           (FrameNumber f, std::shared_ptr<const std::vector<long>> matches);
+
+  virtual void startControlPoints   (FrameNumber f);
+  virtual void newControlPoints     (FrameNumber f, std::shared_ptr<const std::vector<Eigen::Vector3d>> controlPoints);
+  // clang-format on
+
+private:
+  /// Kinds of results, see `droppable()` for those that may be dropped or
+  /// coalesced
+  enum Kind {
+    LIFECYCLE,
+    FRAME_WINDOW,
+    FILTERED_FRAME_WINDOW,
+    RAW_POINT_CLOUD,
+    FILTERED_POINT_CLOUD,
+    CLUSTERS,
+    DESCRIPTORS,
+    MATCHES,
+    CONTROL_POINTS
+  };
+
+  struct Event {
+    Kind kind;
+    std::function<void(PipelineObserver *)> call;
+  };
+
+  PipelineObserver *_observer;
+  const Policy _policy;
+  const size_t _capacity;
+
+  mutable std::mutex _mutex;
+  std::condition_variable _changed;
+  std::deque<Event> _queue;
+  /// the worker is delivering an event right now
+  bool _busy;
+  bool _shouldRun;
+  size_t _dropped;
+  std::thread _worker;
+
+  void enqueue(Kind kind, std::function<void(PipelineObserver *)> call);
+
+  /// True if events of `kind` may be dropped or coalesced
+  static bool droppable(Kind kind);
+
+  /// Tries to make room according to the policy, returns true on success.
+  /// Requires a lock on `_mutex`.
+  bool makeRoom(Kind kind);
+
+  /// Loop of the worker thread
+  void run();
+};
+
+} // namespace MouseTrack
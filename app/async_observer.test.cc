@@ -0,0 +1,84 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "async_observer.h"
+
+#include <chrono>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+namespace utf = boost::unit_test;
+
+namespace MouseTrack {
+namespace {
+
+/// Records frameStart/frameEnd and newMatches calls, slow on newMatches
+class RecordingObserver : public PipelineObserver {
+public:
+  void frameStart(FrameNumber f) { starts.push_back(f); }
+  void frameEnd(FrameNumber f) { ends.push_back(f); }
+  void newMatches(FrameNumber f, std::shared_ptr<const std::vector<long>>) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    matches.push_back(f);
+  }
+  std::vector<FrameNumber> starts;
+  std::vector<FrameNumber> ends;
+  std::vector<FrameNumber> matches;
+};
+
+void sendFrames(AsyncObserver &async, int count) {
+  auto matches = std::make_shared<const std::vector<long>>();
+  for (FrameNumber f = 0; f < count; ++f) {
+    async.frameStart(f);
+    async.newMatches(f, matches);
+    async.frameEnd(f);
+  }
+}
+
+} // namespace
+} // namespace MouseTrack
+
+using MouseTrack::AsyncObserver;
+using MouseTrack::RecordingObserver;
+
+BOOST_AUTO_TEST_CASE(async_observer_block_delivers_everything) {
+  RecordingObserver recorder;
+  AsyncObserver async(&recorder, AsyncObserver::BLOCK, 4);
+  MouseTrack::sendFrames(async, 20);
+  async.flush();
+
+  BOOST_CHECK_EQUAL(async.dropped(), 0);
+  BOOST_REQUIRE_EQUAL(recorder.matches.size(), 20);
+  for (int f = 0; f < 20; ++f) {
+    BOOST_CHECK_EQUAL(recorder.starts[f], f);
+    BOOST_CHECK_EQUAL(recorder.matches[f], f);
+    BOOST_CHECK_EQUAL(recorder.ends[f], f);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(async_observer_drop_oldest_keeps_lifecycle) {
+  RecordingObserver recorder;
+  AsyncObserver async(&recorder, AsyncObserver::DROP_OLDEST, 4);
+  MouseTrack::sendFrames(async, 50);
+  async.flush();
+
+  BOOST_CHECK_EQUAL(recorder.starts.size(), 50);
+  BOOST_CHECK_EQUAL(recorder.ends.size(), 50);
+  BOOST_CHECK_EQUAL(recorder.matches.size() + async.dropped(), 50);
+  for (size_t i = 1; i < recorder.matches.size(); ++i) {
+    BOOST_CHECK(recorder.matches[i - 1] < recorder.matches[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(async_observer_destructor_drains) {
+  RecordingObserver recorder;
+  {
+    AsyncObserver async(&recorder, AsyncObserver::COALESCE, 64);
+    MouseTrack::sendFrames(async, 10);
+  }
+  BOOST_CHECK_EQUAL(recorder.matches.size(), 10);
+  BOOST_CHECK_EQUAL(recorder.ends.size(), 10);
+}
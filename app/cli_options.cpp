@@ -18,6 +18,12 @@ op::options_description cli_options() {
   ad("cli,c", "Don't start the Graphical User Interface, run on command line.");
   ad("pipeline-timer", "Measures the execution time of each pipeline step end sends it's output to the log with debug priority.");
   ad("pipeline-timer-log", op::value<std::string>(), "If set, the pipeline times will be written to this file in csv format. (frame number, total frame time, READ_FRAME_WINDOW,FRAME_WINDOW_FILTERING,REGISTRATION,POINT_CLOUD_FILTERING,CLUSTERING,DESCRIPTING,MATCHING,CONTROL_POINTS)");
+  ad("pipeline-mode", op::value<std::string>()->default_value("sequential"), "How frames are scheduled through the pipeline. Valid values: sequential, staged, frame-parallel; staged runs reading/window filtering, registration/cloud filtering, clustering/descripting and matching on separate threads connected by bounded queues; frame-parallel processes multiple frames at once up to descripting and matches them in order.");
+  ad("pipeline-queue-size", op::value<int>()->default_value(2), "Maximum number of frames waiting between two pipeline stages in staged mode, or for matching in frame-parallel mode.");
+  ad("pipeline-workers", op::value<unsigned int>()->default_value(0), "Number of frames processed concurrently in frame-parallel mode. Default: number of hardware threads.");
+  ad("pipeline-writer-dispatch", op::value<std::string>()->default_value("sync"), "How results are handed to the writer (see out-dir). Valid values: sync, block, drop-oldest, coalesce; all but sync write on a separate thread, if its queue is full, block waits, drop-oldest drops the oldest pending result, coalesce replaces an older result of the same step. Point clouds are never dropped.");
+  ad("pipeline-writer-queue-size", op::value<int>()->default_value(32), "Number of pending writer events if pipeline-writer-dispatch is not sync.");
+  ad("pipeline-writer-ply", op::value<std::string>()->default_value("binary"), "Encoding of point clouds written to out-dir. Valid values: binary, binary-float, ascii; binary and binary-float write little endian PLY files with double or float coordinates.");
   ad("log,l", op::value<std::string>()->default_value("info"), "Set lowest log level to show. Possible options: trace, debug, info, warning, error, fatal, none. Default: info");
   ad("first-frame", op::value<int>(), "Desired lowest start frame (inclusive).");
   ad("last-frame", op::value<int>(), "Desired highest end frame (inclusive).");
@@ -26,9 +32,12 @@ op::options_description cli_options() {
 
   // pipeline modules
   ad("pipeline-reader", op::value<std::string>()->default_value("auto"), "Which reader module to use. Valid values: auto, matlab, matlab-concurrent, ros-bag; auto picks 'matlab-concurrent' for source directories and 'ros-bag' in case a bag file is given");
+  ad("reader-prefetch", op::value<int>()->default_value(0), "Number of frame windows the reader reads ahead on a background thread. 0 disables prefetching.");
+  ad("reader-prefetch-memory", op::value<int>()->default_value(1024), "Upper bound for the memory occupied by prefetched frame windows in MiB.");
   ad("pipeline-frame-window-filtering", op::value<std::vector<std::string>>()->multitoken(), "Which filtering modules to apply to a frame window. Valid values: none, disparity-gauss, disparity-median, disparity-bilateral, disparity-morph-open, disparity-morph-close, background-subtraction, hog-labeling, strict-labeling");
-  ad("pipeline-registration", op::value<std::string>()->default_value("disparity-cpu-optimized"), "Which registration module to use. Valid values: none, disparity, disparity-cpu-optimized");
-  ad("pipeline-point-cloud-filtering", op::value<std::vector<std::string>>()->multitoken(), "Which filtering modules to use. Valid values: none, subsample, statistical-outlier-removal");
+  ad("frame-window-filtering-parallel", "Filters the streams of a frame window concurrently, each stream passes through all frame window filters on its own thread.");
+  ad("pipeline-registration", op::value<std::string>()->default_value("disparity-cpu-optimized"), "Which registration module to use. Valid values: none, disparity, disparity-cpu-optimized, disparity-cached; disparity-cached reuses lookup tables as long as the calibration stays the same");
+  ad("pipeline-point-cloud-filtering", op::value<std::vector<std::string>>()->multitoken(), "Which filtering modules to use. Valid values: none, subsample, statistical-outlier-removal, morton-order (sorts points along a Z-order curve for memory locality, put it last)");
   ad("pipeline-clustering", op::value<std::string>()->default_value("mean-shift"), "Which clustering module to use. Valid values: none, single-cluster, mean-shift, mean-shift-cpu-optimized, kmeans, label-clustering");
   ad("pipeline-descripting", op::value<std::string>()->default_value("cog"), "Which descripting module to use. Valid values: none, cog");
   ad("pipeline-matching", op::value<std::string>()->default_value("nearest-neighbor"), "Which matching module to use. Valid values: none, nearest-neighbor");
@@ -66,6 +75,7 @@ op::options_description cli_options() {
   // statistical outlier removal
   ad("statistical-outlier-removal-alpha", op::value<double>()->default_value(1.0), "Range within which points are inliers: [-alpha * stddev, alpha * stddev]");
   ad("statistical-outlier-removal-k", op::value<int>()->default_value(30), "K neighbors to take into account.");
+  ad("statistical-outlier-removal-oracle", op::value<std::string>()->default_value("kd-tree"), "Which spatial acceleration should be used? valid values: brute-force, kd-tree, flann, autotune");
 
   // clustering
   
@@ -74,13 +84,13 @@ op::options_description cli_options() {
   ad("mean-shift-max-iterations", op::value<int>()->default_value(1000), "Maximum number of iterations for a point before it should converge.");
   ad("mean-shift-merge-threshold", op::value<double>()->default_value(0.01), "Maximum distance of two clusters such that they can still merge");
   ad("mean-shift-convergence-threshold", op::value<double>()->default_value(0.0001), "Maximum distance a point is allowed to travel in an iteration and still being classified as converged.");
-  ad("mean-shift-oracle", op::value<std::string>()->default_value("uniform-grid"), "Which spatial acceleration should be used? valid values: brute-force, uniform-grid, flann");
+  ad("mean-shift-oracle", op::value<std::string>()->default_value("flat-grid"), "Which spatial acceleration should be used? valid values: brute-force, uniform-grid, flat-grid, hybrid-grid, kd-tree, flann, autotune");
 
   // k-means
   ad("kmeans-k", op::value<unsigned int>()->default_value(15), "Number of expected clusters.");
   ad("kmeans-centroid-threshold", op::value<double>()->default_value(0.01), "Total movement of cluster centers that should be classified as 'converged'.");
   ad("kmeans-assignment-threshold", op::value<double>()->default_value(0.02), "Percentage of points that changed clusters: if the percentage is below this threshold, convergence is assumed.");
-  ad("kmeans-oracle", op::value<std::string>()->default_value("flann"), "Which spatial acceleration should be used? valid values: brute-force, uniform-grid, flann");
+  ad("kmeans-oracle", op::value<std::string>()->default_value("flann"), "Which spatial acceleration should be used? valid values: brute-force, uniform-grid, flat-grid, hybrid-grid, kd-tree, flann, autotune");
 
   // clang-format on
   return desc;
@@ -43,6 +43,32 @@ void setLogLevel(const std::string &level) {
   boost::log::core::get()->set_filter(log::severity >= logFilter);
 }
 
+/// Adds `observer` to `pipeline` with the dispatch policy given by `dispatch`,
+/// valid values: sync, block, drop-oldest, coalesce
+/// Unknown values default to sync
+void addObserver(Pipeline &pipeline, PipelineObserver *observer,
+                 const std::string &dispatch, int queueSize) {
+  if (dispatch == "block") {
+    pipeline.addObserver(observer, AsyncObserver::BLOCK, queueSize);
+  } else if (dispatch == "drop-oldest") {
+    pipeline.addObserver(observer, AsyncObserver::DROP_OLDEST, queueSize);
+  } else if (dispatch == "coalesce") {
+    pipeline.addObserver(observer, AsyncObserver::COALESCE, queueSize);
+  } else {
+    pipeline.addObserver(observer);
+  }
+}
+
+/// Translates the pipeline-writer-ply option, valid values: binary,
+/// binary-float, ascii
+/// Unknown values default to binary
+PlyOptions plyOptions(const std::string &format) {
+  PlyOptions options;
+  options.binary = format != "ascii";
+  options.singlePrecision = format == "binary-float";
+  return options;
+}
+
 /// Adds some additional settings to the command line options and parses the passed arguments.
 op::variables_map parseCli(int argc, char *argv[],
                            const op::options_description &option_desc) {
@@ -144,7 +170,11 @@ int main(int argc, char *argv[]) {
     if (cli_options.count("out-dir")) {
       writer = std::make_unique<PipelineWriter>(
           cli_options["out-dir"].as<std::string>());
-      controller->pipeline().addObserver(writer.get());
+      addObserver(controller->pipeline(), writer.get(),
+                  cli_options["pipeline-writer-dispatch"].as<std::string>(),
+                  cli_options["pipeline-writer-queue-size"].as<int>());
+      writer->plyOptions =
+          plyOptions(cli_options["pipeline-writer-ply"].as<std::string>());
       // TODO: we should make this configurable at some points
       writer->writeRawFrameWindow = false;
       // by default, remove label 5, which in our case is background
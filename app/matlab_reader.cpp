@@ -395,7 +395,7 @@ Eigen::MatrixXd MatlabReader::channelParameters(FrameNumber f) const {
   return readChannelParameters(f);
 }
 
-PictureD MatlabReader::picture(StreamNumber s, FrameNumber f) const {
+Picture MatlabReader::picture(StreamNumber s, FrameNumber f) const {
   return readPicture(s, f);
 }
 
@@ -426,7 +426,7 @@ DisparityMap MatlabReader::readNormalizedDisparityMap(StreamNumber s,
   }
   fs::path p = chooseCandidate(candidatesPtr->second);
   BOOST_LOG_TRIVIAL(trace) << "readNormalizedDisparityMap: " << p.string();
-  PictureD map = read_png_normalized(p.string());
+  DisparityMap map = read_png_normalized(p.string());
   DisparityMap result{std::move(map)};
   return result;
 }
@@ -447,7 +447,7 @@ DisparityMap MatlabReader::readRawDisparityMap(StreamNumber s,
   }
   fs::path p = chooseCandidate(candidatesPtr->second);
   BOOST_LOG_TRIVIAL(trace) << "readRawDisparityMap: " << p.string();
-  PictureD map = read_png_normalized(p.string());
+  DisparityMap map = read_png_normalized(p.string());
   DisparityMap result{std::move(map)};
   return result;
 }
@@ -470,7 +470,7 @@ Eigen::MatrixXd MatlabReader::readChannelParameters(FrameNumber f) const {
 }
 
 /// read left camera picture for frame f and stream s
-PictureD MatlabReader::readPicture(StreamNumber s, FrameNumber f) const {
+Picture MatlabReader::readPicture(StreamNumber s, FrameNumber f) const {
   const auto candidatesPtr =
       _files.frames.find(ElementKey(s, f, REFERENCE_PICTURE_KEY));
   if (candidatesPtr == _files.frames.end()) {
@@ -479,7 +479,7 @@ PictureD MatlabReader::readPicture(StreamNumber s, FrameNumber f) const {
                               << f << " and stream " << s;
       throw "No reference picture file found.";
     }
-    return PictureD{};
+    return Picture{};
   }
   fs::path p = chooseCandidate(candidatesPtr->second);
   BOOST_LOG_TRIVIAL(trace) << "readPicture: " << p.string();
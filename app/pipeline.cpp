@@ -5,14 +5,16 @@
 
 #include "pipeline.h"
 #include "generic/cluster_chain_accumulator.h"
+#include <algorithm>
 #include <boost/log/trivial.hpp>
 #include <iostream>
 
 namespace MouseTrack {
 
 Pipeline::Pipeline()
-    : _controller_should_run(false), _controller_running(false),
-      _controller_terminated(true) {
+    : _delegate(nullptr), _controller_should_run(false),
+      _controller_running(false), _controller_terminated(true),
+      _executionMode(SEQUENTIAL), _queueCapacity(2), _workerCount(0) {
   BOOST_LOG_TRIVIAL(debug) << "Constructing pipeline.";
 }
 
@@ -37,7 +39,10 @@ Pipeline::Pipeline(std::unique_ptr<Reader> reader,
       _clustering(std::move(clustering)),
       _descripting(std::move(descripting)),
       _matching(std::move(matching)),
-      _trajectoryBuilder(std::move(trajectoryBuilder)) {
+      _trajectoryBuilder(std::move(trajectoryBuilder)),
+      _executionMode(SEQUENTIAL),
+      _queueCapacity(2),
+      _workerCount(0) {
   // clang-format on
   // empty
 }
@@ -50,6 +55,7 @@ Pipeline::~Pipeline() noexcept(true) {
 void Pipeline::moveMembersFrom(Pipeline &p) {
   _delegate = std::move(p._delegate);
   _observers = std::move(p._observers);
+  _asyncObservers = std::move(p._asyncObservers);
   _reader = std::move(p._reader);
   _frameWindowFiltering = std::move(p._frameWindowFiltering);
   _registration = std::move(p._registration);
@@ -58,9 +64,15 @@ void Pipeline::moveMembersFrom(Pipeline &p) {
   _descripting = std::move(p._descripting);
   _matching = std::move(p._matching);
   _trajectoryBuilder = std::move(p._trajectoryBuilder);
+  _executionMode = p._executionMode;
+  _queueCapacity = p._queueCapacity;
+  _workerCount = p._workerCount;
 }
 
-Pipeline::Pipeline(MouseTrack::Pipeline &&p) {
+Pipeline::Pipeline(MouseTrack::Pipeline &&p)
+    : _delegate(nullptr), _controller_should_run(false),
+      _controller_running(false), _controller_terminated(true),
+      _executionMode(SEQUENTIAL), _queueCapacity(2), _workerCount(0) {
   BOOST_LOG_TRIVIAL(trace) << "Move-constructing pipeline";
   if (this == &p) {
     return;
@@ -139,6 +151,12 @@ void Pipeline::_join() {
   BOOST_LOG_TRIVIAL(debug) << "Joining controller thread.";
   _controller.join();
   _controller_terminated = true;
+
+  // asynchronous observers might still be busy
+  std::lock_guard<std::mutex> lock(_observer_mutex);
+  for (auto &async : _asyncObservers) {
+    async.second->flush();
+  }
 }
 
 // delegate handling
@@ -154,6 +172,38 @@ void Pipeline::setDelegate(PipelineDelegate *delegate) {
   _delegate = delegate;
 }
 
+// execution settings
+
+void Pipeline::setExecutionMode(ExecutionMode mode) {
+  std::lock_guard<std::mutex> lock(_controller_mutex);
+  _executionMode = mode;
+}
+
+Pipeline::ExecutionMode Pipeline::executionMode() const {
+  std::lock_guard<std::mutex> lock(_controller_mutex);
+  return _executionMode;
+}
+
+void Pipeline::setQueueCapacity(size_t capacity) {
+  std::lock_guard<std::mutex> lock(_controller_mutex);
+  _queueCapacity = capacity;
+}
+
+size_t Pipeline::queueCapacity() const {
+  std::lock_guard<std::mutex> lock(_controller_mutex);
+  return _queueCapacity;
+}
+
+void Pipeline::setWorkerCount(unsigned int workers) {
+  std::lock_guard<std::mutex> lock(_controller_mutex);
+  _workerCount = workers;
+}
+
+unsigned int Pipeline::workerCount() const {
+  std::lock_guard<std::mutex> lock(_controller_mutex);
+  return _workerCount;
+}
+
 // observer handling
 
 void Pipeline::addObserver(PipelineObserver *observer) {
@@ -161,9 +211,28 @@ void Pipeline::addObserver(PipelineObserver *observer) {
   _observers.insert(observer);
 }
 
+void Pipeline::addObserver(PipelineObserver *observer,
+                           AsyncObserver::Policy policy, size_t capacity) {
+  std::unique_ptr<AsyncObserver> async{
+      new AsyncObserver(observer, policy, capacity)};
+  std::lock_guard<std::mutex> lock(_observer_mutex);
+  auto existing = _asyncObservers.find(observer);
+  if (existing != _asyncObservers.end()) {
+    _observers.erase(existing->second.get());
+  }
+  _observers.insert(async.get());
+  _asyncObservers[observer] = std::move(async);
+}
+
 void Pipeline::removeObserver(PipelineObserver *observer) {
   std::lock_guard<std::mutex> lock(_observer_mutex);
   _observers.erase(observer);
+  auto async = _asyncObservers.find(observer);
+  if (async != _asyncObservers.end()) {
+    _observers.erase(async->second.get());
+    // the destructor delivers all pending events
+    _asyncObservers.erase(async);
+  }
 }
 
 // controller thread
@@ -192,25 +261,17 @@ void Pipeline::runPipeline() {
 
   _clusterChains.clear();
 
-  if (_delegate != nullptr) {
-    // we have a delegate, use it
-    while (askDelegate([](PipelineDelegate *d) { return d->hasNextFrame(); })) {
-      FrameNumber f =
-          askDelegate([](PipelineDelegate *d) { return d->nextFrame(); });
-      if (terminateEarly()) {
-        break;
-      }
-      processFrameSafe(f);
-    }
-  } else {
-    // no delegate set, fall back to reader
-    while (_reader->hasNextFrame()) {
-      FrameNumber f = _reader->nextFrame();
-      if (terminateEarly()) {
-        break;
-      }
-      processFrameSafe(f);
-    }
+  switch (_executionMode) {
+  case STAGED:
+    runPipelineStaged();
+    break;
+  case FRAME_PARALLEL:
+    runPipelineFrameParallel();
+    break;
+  case SEQUENTIAL:
+  default:
+    forallFrames([this](FrameNumber f) { processFrameSafe(f); });
+    break;
   }
 
   if (!_clusterChains.empty()) {
@@ -225,6 +286,119 @@ void Pipeline::runPipeline() {
   }
 }
 
+void Pipeline::runPipelineStaged() {
+  BOOST_LOG_TRIVIAL(debug) << "Running staged pipeline, queue capacity: "
+                           << _queueCapacity;
+  typedef BoundedQueue<FrameResults> Queue;
+  Queue read(_queueCapacity);
+  Queue registered(_queueCapacity);
+  Queue clustered(_queueCapacity);
+
+  // Each stage owns its modules exclusively and handles the frames in the
+  // order they arrive, closing a queue lets the next stage drain and finish.
+  auto runStage = [this](Queue &in, Queue &out,
+                         bool (Pipeline::*stage)(FrameResults &)) {
+    FrameResults r;
+    while (in.pop(r)) {
+      if (runStageSafe(r.frame, [&]() { return (this->*stage)(r); })) {
+        out.push(std::move(r));
+      }
+    }
+    out.close();
+  };
+
+  std::thread readThread([this, &read]() {
+    forallFrames([this, &read](FrameNumber f) {
+      FrameResults r;
+      r.frame = f;
+      if (runStageSafe(f, [&]() { return readStage(r); })) {
+        read.push(std::move(r));
+      }
+    });
+    read.close();
+  });
+  std::thread registrationThread(runStage, std::ref(read), std::ref(registered),
+                                 &Pipeline::registrationStage);
+  std::thread clusteringThread(runStage, std::ref(registered),
+                               std::ref(clustered), &Pipeline::clusteringStage);
+
+  // matching is stateful, keep it on the controller thread
+  FrameResults r;
+  while (clustered.pop(r)) {
+    runStageSafe(r.frame, [&]() {
+      matchingStage(r);
+      return true;
+    });
+  }
+
+  readThread.join();
+  registrationThread.join();
+  clusteringThread.join();
+}
+
+void Pipeline::runPipelineFrameParallel() {
+  unsigned int workerCount = _workerCount;
+  if (workerCount == 0) {
+    workerCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+  BOOST_LOG_TRIVIAL(debug) << "Running frame parallel pipeline with "
+                           << workerCount << " workers";
+
+  // frames in flight: one per worker plus a few finished ones waiting for
+  // matching
+  ReorderBuffer<FrameNumber, FrameResults> finished(workerCount +
+                                                    _queueCapacity);
+  BoundedQueue<FrameNumber> jobs(workerCount);
+
+  std::thread dispatcher([this, &finished, &jobs]() {
+    forallFrames([&finished, &jobs](FrameNumber f) {
+      if (finished.reserve(f)) {
+        jobs.push(f);
+      }
+    });
+    jobs.close();
+    finished.close();
+  });
+
+  std::vector<std::thread> workers;
+  for (unsigned int i = 0; i < workerCount; ++i) {
+    workers.emplace_back([this, &finished, &jobs]() {
+      FrameNumber f;
+      while (jobs.pop(f)) {
+        FrameResults r;
+        r.frame = f;
+        bool complete = runStageSafe(f, [&]() {
+          return readStage(r) && registrationStage(r) && clusteringStage(r);
+        });
+        if (!complete) {
+          // dropped frames still need to leave the reorder buffer
+          r = FrameResults();
+          r.frame = f;
+        }
+        finished.put(f, std::move(r));
+      }
+    });
+  }
+
+  // matching is stateful, keep it on the controller thread
+  FrameNumber f;
+  FrameResults r;
+  while (finished.pop(f, r)) {
+    if (r.descriptors == nullptr) {
+      continue;
+    }
+    runStageSafe(f, [&]() {
+      matchingStage(r);
+      return true;
+    });
+  }
+
+  dispatcher.join();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
 bool Pipeline::terminateEarly() {
   if (!_controller_should_run) {
     BOOST_LOG_TRIVIAL(debug) << "Terminate early.";
@@ -233,9 +407,23 @@ bool Pipeline::terminateEarly() {
   return false;
 }
 
+std::unique_lock<std::mutex> Pipeline::lockReader() const {
+  if (_reader->threadSafe()) {
+    return std::unique_lock<std::mutex>();
+  }
+  return std::unique_lock<std::mutex>(_reader_mutex);
+}
+
 void Pipeline::processFrameSafe(FrameNumber f) {
-  try {
+  runStageSafe(f, [&]() {
     processFrame(f);
+    return true;
+  });
+}
+
+bool Pipeline::runStageSafe(FrameNumber f, const std::function<bool()> &stage) {
+  try {
+    return stage();
   } catch (const std::string &e) {
     BOOST_LOG_TRIVIAL(warning)
         << "Exception while processing frame " << f << ": " << e;
@@ -249,90 +437,133 @@ void Pipeline::processFrameSafe(FrameNumber f) {
     BOOST_LOG_TRIVIAL(warning)
         << "Exception while processing frame " << f << ": " << e.what();
   }
+  return false;
 }
 
 void Pipeline::processFrame(FrameNumber f) {
+  FrameResults r;
+  r.frame = f;
+  if (!readStage(r) || !registrationStage(r) || !clusteringStage(r)) {
+    return;
+  }
+  matchingStage(r);
+}
+
+bool Pipeline::readStage(FrameResults &r) {
+  const FrameNumber f = r.frame;
   // tell everybody we're starting to process frame f
   BOOST_LOG_TRIVIAL(debug) << "Processing frame " << f;
   forallObservers([=](PipelineObserver *o) { o->frameStart(f); });
 
   // Read frame data
   forallObservers([=](PipelineObserver *o) { o->startFrameWindow(f); });
-  std::unique_ptr<FrameWindow> windowPtr(new FrameWindow);
-  (*windowPtr) = (*_reader)(f);
-  std::shared_ptr<const FrameWindow> window{std::move(windowPtr)};
+  std::shared_ptr<FrameWindow> rawWindow;
+  {
+    auto lock = lockReader();
+    rawWindow = std::make_shared<FrameWindow>((*_reader)(f));
+  }
+  std::shared_ptr<const FrameWindow> window{rawWindow};
   forallObservers([=](PipelineObserver *o) { o->newFrameWindow(f, window); });
 
   if (terminateEarly()) {
     forallObservers([=](PipelineObserver *o) { o->frameEnd(f); });
-    return;
+    return false;
   }
 
   // optional: frame window point cloud
   if (!_frameWindowFiltering.empty()) {
     forallObservers(
         [=](PipelineObserver *o) { o->startFrameWindowFiltering(f); });
+    // filter in place: copy the raw frame window only if an observer still
+    // holds it
+    window.reset();
+    FrameWindow filtered = rawWindow.use_count() == 1
+                               ? std::move(*rawWindow)
+                               : FrameWindow(*rawWindow);
+    rawWindow.reset();
     for (const auto &filter : _frameWindowFiltering) {
-      std::unique_ptr<FrameWindow> filteredFrameWindowPtr(new FrameWindow());
-      (*filteredFrameWindowPtr) = (*filter)(*window);
-      // replace raw frame window
-      window =
-          std::shared_ptr<const FrameWindow>{std::move(filteredFrameWindowPtr)};
+      filtered = (*filter)(std::move(filtered));
     }
+    window = std::make_shared<const FrameWindow>(std::move(filtered));
     forallObservers(
         [=](PipelineObserver *o) { o->newFilteredFrameWindow(f, window); });
 
     if (terminateEarly()) {
       forallObservers([=](PipelineObserver *o) { o->frameEnd(f); });
-      return;
+      return false;
     }
   }
 
+  r.window = window;
+  return true;
+}
+
+bool Pipeline::registrationStage(FrameResults &r) {
+  const FrameNumber f = r.frame;
+  if (terminateEarly()) {
+    forallObservers([=](PipelineObserver *o) { o->frameEnd(f); });
+    return false;
+  }
+
   // get raw point cloud
   if (_registration == nullptr) {
     BOOST_LOG_TRIVIAL(info)
         << "No regsitration object set, stopping processing of frame " << f;
     forallObservers([=](PipelineObserver *o) { o->frameEnd(f); });
-    return;
+    return false;
   }
   forallObservers([=](PipelineObserver *o) { o->startRegistration(f); });
   std::unique_ptr<PointCloud> rawPointCloudPtr(new PointCloud());
-  (*rawPointCloudPtr) = (*_registration)(*window);
-  std::shared_ptr<const PointCloud> pointCloud{std::move(rawPointCloudPtr)};
+  (*rawPointCloudPtr) = (*_registration)(*r.window);
+  std::shared_ptr<const PointCloud> rawPointCloud{std::move(rawPointCloudPtr)};
   forallObservers(
-      [=](PipelineObserver *o) { o->newRawPointCloud(f, pointCloud); });
+      [=](PipelineObserver *o) { o->newRawPointCloud(f, rawPointCloud); });
+  auto pointCloud = std::make_shared<const PointCloudView>(rawPointCloud);
 
   if (terminateEarly()) {
     forallObservers([=](PipelineObserver *o) { o->frameEnd(f); });
-    return;
+    return false;
   }
 
   // optional: filter point cloud
   if (!_cloudFiltering.empty()) {
     forallObservers(
         [=](PipelineObserver *o) { o->startPointCloudFiltering(f); });
+    // filters only select points of the raw point cloud, nothing is copied
+    PointCloudView filtered = *pointCloud;
     for (const auto &filter : _cloudFiltering) {
-      std::unique_ptr<PointCloud> filteredPointCloudPtr(new PointCloud());
-      (*filteredPointCloudPtr) = (*filter)(*pointCloud);
-      // replace raw point cloud
-      pointCloud =
-          std::shared_ptr<const PointCloud>{std::move(filteredPointCloudPtr)};
+      filtered = (*filter)(filtered);
     }
+    pointCloud = std::make_shared<const PointCloudView>(std::move(filtered));
     forallObservers(
         [=](PipelineObserver *o) { o->newFilteredPointCloud(f, pointCloud); });
 
     if (terminateEarly()) {
       forallObservers([=](PipelineObserver *o) { o->frameEnd(f); });
-      return;
+      return false;
     }
   }
 
+  // the frame window is no longer needed, release it early
+  r.window.reset();
+  r.cloud = pointCloud;
+  return true;
+}
+
+bool Pipeline::clusteringStage(FrameResults &r) {
+  const FrameNumber f = r.frame;
+  const std::shared_ptr<const PointCloudView> pointCloud = r.cloud;
+  if (terminateEarly()) {
+    forallObservers([=](PipelineObserver *o) { o->frameEnd(f); });
+    return false;
+  }
+
   // cluster the point cloud
   if (_clustering == nullptr) {
     BOOST_LOG_TRIVIAL(info)
         << "No clustering object set, stopping processing of frame " << f;
     forallObservers([=](PipelineObserver *o) { o->frameEnd(f); });
-    return;
+    return false;
   }
   forallObservers([=](PipelineObserver *o) { o->startClustering(f); });
   std::unique_ptr<std::vector<Cluster>> clustersPtr(new std::vector<Cluster>());
@@ -342,7 +573,7 @@ void Pipeline::processFrame(FrameNumber f) {
 
   if (terminateEarly()) {
     forallObservers([=](PipelineObserver *o) { o->frameEnd(f); });
-    return;
+    return false;
   }
 
   // extract cluster descriptors
@@ -351,7 +582,7 @@ void Pipeline::processFrame(FrameNumber f) {
     BOOST_LOG_TRIVIAL(info)
         << "No descripting object set, stopping processing of frame " << f;
     forallObservers([=](PipelineObserver *o) { o->frameEnd(f); });
-    return;
+    return false;
   }
 
   BOOST_LOG_TRIVIAL(trace) << "Descripting clusters of frame: " << f;
@@ -368,6 +599,23 @@ void Pipeline::processFrame(FrameNumber f) {
   forallObservers(
       [=](PipelineObserver *o) { o->newDescriptors(f, descriptors); });
 
+  if (terminateEarly()) {
+    forallObservers([=](PipelineObserver *o) { o->frameEnd(f); });
+    return false;
+  }
+
+  r.clusters = clusters;
+  r.descriptors = descriptors;
+  return true;
+}
+
+void Pipeline::matchingStage(FrameResults &r) {
+  const FrameNumber f = r.frame;
+  const std::shared_ptr<const PointCloudView> pointCloud = r.cloud;
+  const std::shared_ptr<const std::vector<Cluster>> clusters = r.clusters;
+  const std::shared_ptr<
+      const std::vector<std::shared_ptr<const ClusterDescriptor>>>
+      descriptors = r.descriptors;
   if (terminateEarly()) {
     forallObservers([=](PipelineObserver *o) { o->frameEnd(f); });
     return;
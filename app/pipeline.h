@@ -5,9 +5,12 @@
 
 #pragma once
 
+#include "async_observer.h"
 #include "clustering/clustering.h"
 #include "descripting/descripting.h"
 #include "frame_window_filtering/frame_window_filtering.h"
+#include "generic/bounded_queue.h"
+#include "generic/reorder_buffer.h"
 #include "matching/matching.h"
 #include "pipeline_delegate.h"
 #include "pipeline_observer.h"
@@ -16,6 +19,8 @@
 #include "registration/registration.h"
 #include "trajectory_builder/trajectory_builder.h"
 #include <atomic>
+#include <functional>
+#include <map>
 #include <mutex>
 #include <set>
 #include <thread>
@@ -38,6 +43,20 @@ namespace MouseTrack {
 /// Also see `std::thread` for further information on threads.
 class Pipeline {
 public:
+  /// How frames are scheduled through the pipeline steps.
+  ///
+  /// - SEQUENTIAL: one frame after another on the controller thread.
+  /// - STAGED: reading + window filtering, registration + cloud filtering and
+  ///   clustering + descripting each run on their own thread and hand their
+  ///   results to the next group via bounded queues. Matching and trajectory
+  ///   building stay on the controller thread and see the frames in order.
+  /// - FRAME_PARALLEL: a pool of workers runs whole frames from reading
+  ///   through descripting concurrently, a reorder buffer hands the results to
+  ///   matching and trajectory building in frame order. Only one thread at a
+  ///   time enters the reader, all modules from frame window filtering up to
+  ///   descripting must accept concurrent calls for different frames.
+  enum ExecutionMode { SEQUENTIAL, STAGED, FRAME_PARALLEL };
+
   /// Default constructor, create empty pipeline
   Pipeline();
 
@@ -83,6 +102,14 @@ public:
   /// Don't expect the observes to be called in a particular order.
   void addObserver(PipelineObserver *observer);
 
+  /// Like `addObserver(observer)`, but `observer` is called from its own
+  /// thread, decoupled by a queue with the given capacity and policy (see
+  /// AsyncObserver). A slow observer does not delay the pipeline this way.
+  /// `join()` waits until all events are delivered.
+  void addObserver(PipelineObserver *observer, AsyncObserver::Policy policy,
+                   size_t capacity = 32);
+
+  /// Delivers pending events of asynchronous observers before returning.
   void removeObserver(PipelineObserver *observer);
 
   /// Sets a pointer to a delegate object
@@ -98,11 +125,28 @@ public:
   /// undefined.
   void setDelegate(PipelineDelegate *delegate);
 
+  /// Changes take effect with the next `start()`.
+  void setExecutionMode(ExecutionMode mode);
+  ExecutionMode executionMode() const;
+
+  /// Maximum number of frames waiting between two stages in `STAGED` mode.
+  /// Bounds the memory held by frames in flight.
+  void setQueueCapacity(size_t capacity);
+  size_t queueCapacity() const;
+
+  /// Number of frames processed concurrently in `FRAME_PARALLEL` mode, 0 picks
+  /// the number of hardware threads.
+  void setWorkerCount(unsigned int workers);
+  unsigned int workerCount() const;
+
 private:
   /// This mutex regulates communication with the outside
   /// (observers and delegate)
   mutable std::mutex _observer_mutex;
   std::set<PipelineObserver *> _observers;
+  /// Wrappers of observers added with a dispatch policy, the wrapper is
+  /// registered in `_observers`
+  std::map<PipelineObserver *, std::unique_ptr<AsyncObserver>> _asyncObservers;
   PipelineDelegate *_delegate;
 
   /// main worker thread, coordinates work distribution and communicates with
@@ -125,12 +169,42 @@ private:
   /// starting point for controller thread
   void controllerStart();
 
+  /// Intermediate results of one frame on its way through the pipeline
+  struct FrameResults {
+    FrameNumber frame;
+    std::shared_ptr<const FrameWindow> window;
+    std::shared_ptr<const PointCloudView> cloud;
+    std::shared_ptr<const std::vector<Cluster>> clusters;
+    std::shared_ptr<const std::vector<std::shared_ptr<const ClusterDescriptor>>>
+        descriptors;
+  };
+
   /// coordinates pipeline for one frame
   void processFrame(FrameNumber f);
 
   /// Wraps `processFrame` and takes care of exception handling
   void processFrameSafe(FrameNumber f);
 
+  // Each stage fills its part of `r`. A return value of false means the frame
+  // should not be passed on, `frameEnd` was already sent in this case.
+
+  /// Reads the frame window and applies the frame window filters
+  bool readStage(FrameResults &r);
+
+  /// Registration and point cloud filters
+  bool registrationStage(FrameResults &r);
+
+  /// Clustering and descripting
+  bool clusteringStage(FrameResults &r);
+
+  /// Matching, updating cluster chains and trajectory building. Stateful, must
+  /// see the frames in order.
+  void matchingStage(FrameResults &r);
+
+  /// Runs `stage` and takes care of exception handling, returns false if the
+  /// stage failed or dropped the frame.
+  bool runStageSafe(FrameNumber f, const std::function<bool()> &stage);
+
   template <typename Lambda> void forallObservers(Lambda lambda) {
     std::lock_guard<std::mutex> lock(_observer_mutex);
     for (PipelineObserver *o : _observers) {
@@ -158,6 +232,9 @@ private:
 
   // pipeline steps
 
+  /// Serializes access to `_reader`, readers don't need to be thread-safe
+  /// (e.g. a ROS bag can't be read concurrently). Use `lockReader()`.
+  mutable std::mutex _reader_mutex;
   std::unique_ptr<Reader> _reader;
   std::vector<std::unique_ptr<FrameWindowFiltering>> _frameWindowFiltering;
   std::unique_ptr<Registration> _registration;
@@ -168,9 +245,59 @@ private:
   std::unique_ptr<TrajectoryBuilder> _trajectoryBuilder;
   std::vector<ClusterChain> _clusterChains;
 
+  ExecutionMode _executionMode;
+  size_t _queueCapacity;
+  unsigned int _workerCount;
+
   void runPipeline();
 
+  /// Runs the pipeline in `STAGED` mode
+  void runPipelineStaged();
+
+  /// Runs the pipeline in `FRAME_PARALLEL` mode
+  void runPipelineFrameParallel();
+
+  /// Calls `lambda` with each frame number to process, as long as the pipeline
+  /// is not asked to stop.
+  template <typename Lambda> void forallFrames(Lambda lambda) {
+    if (_delegate != nullptr) {
+      // we have a delegate, use it
+      while (
+          askDelegate([](PipelineDelegate *d) { return d->hasNextFrame(); })) {
+        FrameNumber f =
+            askDelegate([](PipelineDelegate *d) { return d->nextFrame(); });
+        if (terminateEarly()) {
+          break;
+        }
+        lambda(f);
+      }
+    } else {
+      // no delegate set, fall back to reader, workers might read frames
+      // concurrently
+      auto next = [this](FrameNumber &f) {
+        auto lock = lockReader();
+        if (!_reader->hasNextFrame()) {
+          return false;
+        }
+        f = _reader->nextFrame();
+        return true;
+      };
+      FrameNumber f;
+      while (next(f)) {
+        if (terminateEarly()) {
+          break;
+        }
+        lambda(f);
+      }
+    }
+  }
+
   bool terminateEarly();
+
+  /// Locks `_reader_mutex` unless the reader is thread-safe. A thread-safe
+  /// reader might block in `hasNextFrame()`/`nextFrame()` until other
+  /// threads read their frames, holding the mutex would deadlock.
+  std::unique_lock<std::mutex> lockReader() const;
 };
 
 } // namespace MouseTrack
@@ -0,0 +1,267 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "pipeline.h"
+#include "clustering/single_cluster.h"
+#include "descripting/cog.h"
+#include "reader/prefetching_reader.h"
+#include "trajectory_builder/cog_trajectory_builder.h"
+
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace utf = boost::unit_test;
+
+namespace MouseTrack {
+namespace {
+
+/// Delivers frames [0, count), the frame number is stored in the focal length,
+/// the disparity map has `size` x `size` pixels
+class CountingReader : public Reader {
+public:
+  CountingReader(FrameNumber count, int size = 0)
+      : _count(count), _next(0), _size(size) {
+    // empty
+  }
+  bool valid() const { return true; }
+  bool hasNextFrame() const { return _next < _count; }
+  FrameNumber nextFrame() { return _next++; }
+  FrameWindow operator()(FrameNumber f) {
+    Frame frame;
+    frame.focallength = f;
+    frame.normalizedDisparityMap = DisparityMap::Zero(_size, _size);
+    return FrameWindow(std::vector<Frame>{frame});
+  }
+
+private:
+  FrameNumber _count;
+  FrameNumber _next;
+  int _size;
+};
+
+/// Like CountingReader, but counts calls that overlap with another call
+class ExclusiveReader : public Reader {
+public:
+  ExclusiveReader(FrameNumber count, int size = 0) : _reader(count, size) {
+    // empty
+  }
+  bool valid() const { return true; }
+  bool hasNextFrame() const {
+    Guard guard(*this);
+    return _reader.hasNextFrame();
+  }
+  FrameNumber nextFrame() {
+    Guard guard(*this);
+    return _reader.nextFrame();
+  }
+  FrameWindow operator()(FrameNumber f) {
+    Guard guard(*this);
+    // widen the window for overlapping calls
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    return _reader(f);
+  }
+  int overlaps() const { return _overlaps; }
+
+private:
+  class Guard {
+  public:
+    Guard(const ExclusiveReader &r) : _r(r) {
+      if (_r._inside++ != 0) {
+        ++_r._overlaps;
+      }
+    }
+    ~Guard() { --_r._inside; }
+
+  private:
+    const ExclusiveReader &_r;
+  };
+  CountingReader _reader;
+  mutable std::atomic<int> _inside{0};
+  mutable std::atomic<int> _overlaps{0};
+};
+
+/// Creates a single point at (focallength, 0, 0)
+class FocalLengthRegistration : public Registration {
+public:
+  PointCloud operator()(const FrameWindow &window) const {
+    PointCloud cloud;
+    cloud.resize(1, 0);
+    cloud[0].x(window.frames()[0].focallength);
+    cloud[0].y(0);
+    cloud[0].z(0);
+    cloud[0].intensity(0);
+    return cloud;
+  }
+};
+
+/// Shifts the focal length by `offset`
+class ShiftFilter : public FrameWindowFiltering {
+public:
+  ShiftFilter(double offset) : _offset(offset) {
+    // empty
+  }
+  void filterFrame(Frame &frame, size_t) const {
+    frame.focallength += _offset;
+  }
+
+private:
+  double _offset;
+};
+
+/// Appends everything to the first chain
+class FirstChainMatching : public Matching {
+public:
+  std::vector<long> operator()(
+      const std::vector<std::shared_ptr<const ClusterDescriptor>> &descriptors,
+      const std::vector<ClusterChain> &chains) {
+    return std::vector<long>(descriptors.size(), chains.empty() ? -1 : 0);
+  }
+};
+
+class ControlPointRecorder : public PipelineObserver {
+public:
+  void newControlPoints(
+      FrameNumber f,
+      std::shared_ptr<const std::vector<Eigen::Vector3d>> controlPoints) {
+    frames.push_back(f);
+    xs.push_back((*controlPoints)[0][0]);
+  }
+  std::vector<FrameNumber> frames;
+  std::vector<double> xs;
+};
+
+Pipeline countingPipeline(
+    FrameNumber count,
+    std::vector<std::unique_ptr<FrameWindowFiltering>> &&filters = {},
+    std::unique_ptr<Reader> reader = nullptr) {
+  if (reader == nullptr) {
+    reader.reset(new CountingReader(count));
+  }
+  return Pipeline(std::move(reader),
+                  std::move(filters),
+                  std::unique_ptr<Registration>(new FocalLengthRegistration()),
+                  std::vector<std::unique_ptr<PointCloudFiltering>>(),
+                  std::unique_ptr<Clustering>(new SingleCluster()),
+                  std::unique_ptr<Descripting>(new CenterOfGravity()),
+                  std::unique_ptr<Matching>(new FirstChainMatching()),
+                  std::unique_ptr<TrajectoryBuilder>(
+                      new CogTrajectoryBuilder()));
+}
+
+void checkInOrder(Pipeline::ExecutionMode mode) {
+  constexpr FrameNumber count = 50;
+  Pipeline pipeline = countingPipeline(count);
+  pipeline.setExecutionMode(mode);
+  pipeline.setWorkerCount(4);
+  ControlPointRecorder recorder;
+  pipeline.addObserver(&recorder);
+  pipeline.start();
+  pipeline.join();
+
+  BOOST_REQUIRE_EQUAL(recorder.frames.size(), count);
+  for (FrameNumber f = 0; f < count; ++f) {
+    BOOST_CHECK_EQUAL(recorder.frames[f], f);
+    BOOST_CHECK_CLOSE(recorder.xs[f], f, 0.00001);
+  }
+}
+
+} // namespace
+} // namespace MouseTrack
+
+using MouseTrack::Pipeline;
+
+BOOST_AUTO_TEST_CASE(pipeline_sequential_in_order) {
+  MouseTrack::checkInOrder(Pipeline::SEQUENTIAL);
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_staged_in_order) {
+  MouseTrack::checkInOrder(Pipeline::STAGED);
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_frame_parallel_in_order) {
+  MouseTrack::checkInOrder(Pipeline::FRAME_PARALLEL);
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_frame_parallel_serializes_reader) {
+  constexpr MouseTrack::FrameNumber count = 40;
+  auto reader = new MouseTrack::ExclusiveReader(count);
+  Pipeline pipeline = MouseTrack::countingPipeline(
+      count, {}, std::unique_ptr<MouseTrack::Reader>(reader));
+  pipeline.setExecutionMode(Pipeline::FRAME_PARALLEL);
+  pipeline.setWorkerCount(4);
+  MouseTrack::ControlPointRecorder recorder;
+  pipeline.addObserver(&recorder);
+  pipeline.start();
+  pipeline.join();
+  BOOST_CHECK_EQUAL(recorder.frames.size(), count);
+  BOOST_CHECK_EQUAL(reader->overlaps(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_frame_parallel_prefetching_reader,
+                     *utf::timeout(60)) {
+  // the cap is smaller than a single window: prefetching only continues once
+  // the workers read their frames
+  constexpr MouseTrack::FrameNumber count = 40;
+  auto wrapped = new MouseTrack::ExclusiveReader(count, 10);
+  std::unique_ptr<MouseTrack::Reader> reader(new MouseTrack::PrefetchingReader(
+      std::unique_ptr<MouseTrack::Reader>(wrapped), 4, 1));
+  Pipeline pipeline =
+      MouseTrack::countingPipeline(count, {}, std::move(reader));
+  pipeline.setExecutionMode(Pipeline::FRAME_PARALLEL);
+  pipeline.setWorkerCount(4);
+  MouseTrack::ControlPointRecorder recorder;
+  pipeline.addObserver(&recorder);
+  pipeline.start();
+  pipeline.join();
+  BOOST_REQUIRE_EQUAL(recorder.frames.size(), count);
+  for (MouseTrack::FrameNumber f = 0; f < count; ++f) {
+    BOOST_CHECK_EQUAL(recorder.frames[f], f);
+  }
+  BOOST_CHECK_EQUAL(wrapped->overlaps(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_staged_stop) {
+  Pipeline pipeline = MouseTrack::countingPipeline(100000);
+  pipeline.setExecutionMode(Pipeline::STAGED);
+  pipeline.start();
+  pipeline.stop();
+  pipeline.join();
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_frame_parallel_stop) {
+  Pipeline pipeline = MouseTrack::countingPipeline(100000);
+  pipeline.setExecutionMode(Pipeline::FRAME_PARALLEL);
+  pipeline.setWorkerCount(4);
+  pipeline.start();
+  pipeline.stop();
+  pipeline.join();
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_async_observer_flushed_on_join) {
+  MouseTrack::ControlPointRecorder recorder;
+  Pipeline pipeline = MouseTrack::countingPipeline(50);
+  pipeline.addObserver(&recorder, MouseTrack::AsyncObserver::BLOCK, 2);
+  pipeline.start();
+  pipeline.join();
+  BOOST_CHECK_EQUAL(recorder.frames.size(), 50);
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_frame_window_filter_chain) {
+  std::vector<std::unique_ptr<MouseTrack::FrameWindowFiltering>> filters;
+  filters.emplace_back(new MouseTrack::ShiftFilter(100));
+  filters.emplace_back(new MouseTrack::ShiftFilter(20));
+  MouseTrack::ControlPointRecorder recorder;
+  Pipeline pipeline = MouseTrack::countingPipeline(10, std::move(filters));
+  pipeline.addObserver(&recorder);
+  pipeline.start();
+  pipeline.join();
+  BOOST_REQUIRE_EQUAL(recorder.xs.size(), 10);
+  for (int f = 0; f < 10; ++f) {
+    BOOST_CHECK_CLOSE(recorder.xs[f], f + 120, 0.00001);
+  }
+}
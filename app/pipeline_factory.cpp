@@ -17,20 +17,24 @@
 #include "frame_window_filtering/disparity_morphology.h"
 #include "frame_window_filtering/hog_labeling.h"
 #include "frame_window_filtering/strict_labeling.h"
+#include "frame_window_filtering/stream_parallel_filtering.h"
 
 #include "matching/nearest_neighbour.h"
 
 #include "matlab_reader.h"
 #include "matlab_reader_concurrent.h"
+#include "reader/prefetching_reader.h"
 
 #if ENABLE_ROSBAG
 #include "ros_bag_reader.h"
 #endif
 
 #include "registration/disparity_registration.h"
+#include "registration/disparity_registration_cached.h"
 #include "registration/disparity_registration_cpu_optimized.h"
 
 #include "point_cloud_filtering/statistical_outlier_removal.h"
+#include "point_cloud_filtering/morton_order.h"
 #include "point_cloud_filtering/subsample.h"
 
 #include "clustering/kmeans.h"
@@ -54,6 +58,16 @@ PipelineFactory::fromCliOptions(const op::variables_map &options) const {
   }
   BOOST_LOG_TRIVIAL(trace) << "Creating Reader";
   std::unique_ptr<Reader> reader = getReader(options);
+  if (reader != nullptr && options["reader-prefetch"].as<int>() > 0) {
+    BOOST_LOG_TRIVIAL(trace) << "Wrapping Reader in PrefetchingReader";
+    int prefetchMemory = options["reader-prefetch-memory"].as<int>();
+    if (prefetchMemory < 0) {
+      throw "reader-prefetch-memory must not be negative.";
+    }
+    reader = std::unique_ptr<Reader>(new PrefetchingReader(
+        std::move(reader), options["reader-prefetch"].as<int>(),
+        prefetchMemory * 1024ul * 1024ul));
+  }
 
   BOOST_LOG_TRIVIAL(trace) << "Creating FrameWindowFiltering";
   std::vector<std::unique_ptr<FrameWindowFiltering>> windowFiltering =
@@ -80,15 +94,24 @@ PipelineFactory::fromCliOptions(const op::variables_map &options) const {
       getTrajectoryBuilder(options)};
   BOOST_LOG_TRIVIAL(debug) << "Pipeline modules successfully created.";
   // clang-format off
-  return Pipeline(std::move(reader),
-                  std::move(windowFiltering),
-                  std::move(registration),
-                  std::move(cloudFiltering),
-                  std::move(clustering),
-                  std::move(descripting),
-                  std::move(matching),
-                  std::move(trajectoryBuilder));
+  Pipeline pipeline(std::move(reader),
+                    std::move(windowFiltering),
+                    std::move(registration),
+                    std::move(cloudFiltering),
+                    std::move(clustering),
+                    std::move(descripting),
+                    std::move(matching),
+                    std::move(trajectoryBuilder));
   // clang-format on
+  pipeline.setExecutionMode(
+      getExecutionMode(options["pipeline-mode"].as<std::string>()));
+  int queueSize = options["pipeline-queue-size"].as<int>();
+  if (queueSize < 1) {
+    throw "pipeline-queue-size must be positive.";
+  }
+  pipeline.setQueueCapacity(queueSize);
+  pipeline.setWorkerCount(options["pipeline-workers"].as<unsigned int>());
+  return pipeline;
 }
 
 std::unique_ptr<Reader>
@@ -189,6 +212,13 @@ PipelineFactory::getWindowFilters(const op::variables_map &options) const {
     }
     filters.push_back(std::move(ptr));
   }
+  if (options.count("frame-window-filtering-parallel") && !filters.empty()) {
+    BOOST_LOG_TRIVIAL(trace) << "Filtering streams in parallel";
+    std::unique_ptr<FrameWindowFiltering> parallel(
+        new StreamParallelFiltering(std::move(filters)));
+    filters.clear();
+    filters.push_back(std::move(parallel));
+  }
   return filters;
 }
 
@@ -439,6 +469,9 @@ PipelineFactory::getRegistration(const op::variables_map &options) const {
     return std::unique_ptr<Registration>(
         new DisparityRegistrationCpuOptimized());
   }
+  if (target == "disparity-cached") {
+    return std::unique_ptr<Registration>(new DisparityRegistrationCached());
+  }
   return nullptr;
 }
 
@@ -470,8 +503,14 @@ PipelineFactory::getCloudFiltering(const std::string &target,
   if (target == "statistical-outlier-removal") {
     double alpha = options["statistical-outlier-removal-alpha"].as<double>();
     int k = options["statistical-outlier-removal-k"].as<int>();
-    return std::unique_ptr<PointCloudFiltering>(
-        new StatisticalOutlierRemoval(alpha, k));
+    std::unique_ptr<StatisticalOutlierRemoval> ptr{
+        new StatisticalOutlierRemoval(alpha, k)};
+    ptr->oracleFactory().desiredOracle(getOracle(
+        options["statistical-outlier-removal-oracle"].as<std::string>()));
+    return ptr;
+  }
+  if (target == "morton-order") {
+    return std::unique_ptr<PointCloudFiltering>(new MortonOrder());
   }
   if (target == "none") {
     return nullptr;
@@ -536,14 +575,42 @@ PipelineFactory::getOracle(const std::string &oracleKey) const {
   if (oracleKey == "uniform-grid") {
     return OFactory::Oracles::UNIFORM_GRID;
   }
+  if (oracleKey == "flat-grid") {
+    return OFactory::Oracles::FLAT_GRID;
+  }
+  if (oracleKey == "hybrid-grid") {
+    return OFactory::Oracles::HYBRID_GRID;
+  }
+  if (oracleKey == "kd-tree") {
+    return OFactory::Oracles::KD_TREE;
+  }
   if (oracleKey == "flann") {
     return OFactory::Oracles::FLANN;
   }
+  if (oracleKey == "autotune") {
+    return OFactory::Oracles::AUTOTUNE;
+  }
   BOOST_LOG_TRIVIAL(info) << "Unknown requested oracle \"" << oracleKey
                           << "\", using brute force.";
   return OFactory::Oracles::BRUTE_FORCE;
 }
 
+Pipeline::ExecutionMode
+PipelineFactory::getExecutionMode(const std::string &modeKey) const {
+  if (modeKey == "sequential") {
+    return Pipeline::ExecutionMode::SEQUENTIAL;
+  }
+  if (modeKey == "staged") {
+    return Pipeline::ExecutionMode::STAGED;
+  }
+  if (modeKey == "frame-parallel") {
+    return Pipeline::ExecutionMode::FRAME_PARALLEL;
+  }
+  BOOST_LOG_TRIVIAL(info) << "Unknown requested pipeline mode \"" << modeKey
+                          << "\", using sequential.";
+  return Pipeline::ExecutionMode::SEQUENTIAL;
+}
+
 std::unique_ptr<Descripting>
 PipelineFactory::getDescripting(const op::variables_map &options) const {
   std::string target = options["pipeline-descripting"].as<std::string>();
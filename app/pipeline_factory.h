@@ -20,7 +20,7 @@ public:
   Pipeline fromCliOptions(const op::variables_map &options) const;
 
 private:
-  typedef OracleFactoryXd OFactory;
+  typedef OracleFactory<Coordinate> OFactory;
   /// Depending on the given options, choose, create and return a reader
   std::unique_ptr<Reader> getReader(const op::variables_map &options) const;
   std::string chooseReaderTarget(const std::string &givenTarget,
@@ -72,6 +72,9 @@ private:
 
   /// Choose a value from the Oracles enum based on a given string
   OFactory::Oracles getOracle(const std::string &oracleKey) const;
+
+  /// Choose a value from the ExecutionMode enum based on a given string
+  Pipeline::ExecutionMode getExecutionMode(const std::string &modeKey) const;
 };
 
 } // namespace MouseTrack
@@ -60,7 +60,7 @@ void PipelineObserver::startPointCloudFiltering(FrameNumber) {
 }
 
 void PipelineObserver::newFilteredPointCloud(
-    FrameNumber, std::shared_ptr<const PointCloud>) {
+    FrameNumber, std::shared_ptr<const PointCloudView>) {
   // empty
 }
 
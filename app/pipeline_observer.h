@@ -14,6 +14,7 @@
 #include "generic/cluster_descriptor.h"
 #include "generic/frame_window.h"
 #include "generic/point_cloud.h"
+#include "generic/point_cloud_view.h"
 
 #include <Eigen/Core>
 
@@ -50,6 +51,10 @@ namespace MouseTrack {
 ///   startFrameWindow(2) is always called before newFrameWindow(2).
 ///   Don't rely on any other ordering (frameEnd(2) and frameStart(3) can come
 ///   in any order).
+///   Exception: if the pipeline processes frames in parallel
+///   (`Pipeline::FRAME_PARALLEL`), the frame numbers only increase
+///   monotonically from `startMatching` on, earlier steps of different frames
+///   can come in any order.
 ///
 /// Notes:
 /// - You don't need to implement all methods. By default, each method is a
@@ -86,7 +91,7 @@ public:
     virtual void newRawPointCloud     (FrameNumber f, std::shared_ptr<const PointCloud> cloud);
   
     virtual void startPointCloudFiltering(FrameNumber f);
-    virtual void newFilteredPointCloud(FrameNumber f, std::shared_ptr<const PointCloud> cloud);
+    virtual void newFilteredPointCloud(FrameNumber f, std::shared_ptr<const PointCloudView> cloud);
 
     virtual void startClustering      (FrameNumber f);
     virtual void newClusters          (FrameNumber f, std::shared_ptr<const std::vector<Cluster>> clusters);
@@ -91,8 +91,8 @@ void PipelineTimer::startPointCloudFiltering(FrameNumber f) {
   startTimer(f, POINT_CLOUD_FILTERING);
 }
 
-void PipelineTimer::newFilteredPointCloud(FrameNumber f,
-                                          std::shared_ptr<const PointCloud>) {
+void PipelineTimer::newFilteredPointCloud(
+    FrameNumber f, std::shared_ptr<const PointCloudView>) {
   stopTimer(f, POINT_CLOUD_FILTERING);
 }
 
@@ -37,8 +37,9 @@ public:
                                 std::shared_ptr<const PointCloud> cloud);
 
   virtual void startPointCloudFiltering(FrameNumber f);
-  virtual void newFilteredPointCloud(FrameNumber f,
-                                     std::shared_ptr<const PointCloud> cloud);
+  virtual void
+  newFilteredPointCloud(FrameNumber f,
+                        std::shared_ptr<const PointCloudView> cloud);
 
   virtual void startClustering(FrameNumber f);
   virtual void
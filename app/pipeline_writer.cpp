@@ -17,6 +17,20 @@
 
 namespace MouseTrack {
 
+namespace {
+
+/// One column per color
+PointCloud::ColMatrix
+toPalette(const std::vector<std::vector<double>> &colors) {
+  PointCloud::ColMatrix palette(3, colors.size());
+  for (size_t i = 0; i < colors.size(); ++i) {
+    palette.col(i) << colors[i][0], colors[i][1], colors[i][2];
+  }
+  return palette;
+}
+
+} // namespace
+
 PipelineWriter::PipelineWriter(fs::path targetDir)
     // clang-format off
     : _outputDir(fs::absolute(targetDir)),
@@ -39,6 +53,7 @@ PipelineWriter::PipelineWriter(fs::path targetDir)
       _filteredPointCloudMetricsPath("filtered_point_cloud_metrics_<frameNumber>.txt"),
       _clusteredPointCloudPath("clustered_point_cloud_<frameNumber>.ply"),
       _clustersPath("clusters_<frameNumber>.csv"),
+      _clustersRawPath("clusters_raw_<frameNumber>.csv"),
       _clustersCoGsPath("cluster_cogs_<frameNumber>.csv"),
       _descriptorsPath("descriptors_<frameNumber>.csv"),
       _matchesPath("matches_<frameNumber>.csv"),
@@ -199,11 +214,11 @@ void PipelineWriter::newFilteredFrameWindow(
   // write label overlays
   for (StreamNumber s = 0; (size_t)s < window->frames().size(); ++s) {
     const Frame &frame = window->frames()[s];
-    auto mask = frame.normalizedDisparityMap.array() > 0.0;
+    auto mask = frame.normalizedDisparityMap.array() > 0;
     cv::Mat refImg;
 
     // why 255??
-    Eigen::MatrixXf refF = frame.referencePicture.cast<float>() * 255;
+    Eigen::MatrixXf refF = frame.referencePicture.cast<float>() * 255.0f;
 
     cv::eigen2cv(refF, refImg);
     cv::cvtColor(refImg, refImg, cv::COLOR_GRAY2BGR);
@@ -248,18 +263,19 @@ void PipelineWriter::newFilteredFrameWindow(
 
 void PipelineWriter::newRawPointCloud(FrameNumber f,
                                       std::shared_ptr<const PointCloud> cloud) {
-  _clouds[f] = cloud;
+  auto view = std::make_shared<const PointCloudView>(cloud);
+  _clouds[f] = view;
   if (!writeRawPointCloud) {
     return;
   }
   fs::path path = _outputDir / insertFrame(_rawPointCloudPath, f);
   fs::path pathMetrics = _outputDir / insertFrame(_rawPointCloudMetricsPath, f);
-  write_point_cloud(path.string(), *cloud);
-  write_point_cloud_metrics(pathMetrics.string(), *cloud);
+  write_point_cloud(path.string(), *view, plyOptions);
+  write_point_cloud_metrics(pathMetrics.string(), *view);
 }
 
 void PipelineWriter::newFilteredPointCloud(
-    FrameNumber f, std::shared_ptr<const PointCloud> cloud) {
+    FrameNumber f, std::shared_ptr<const PointCloudView> cloud) {
   // overwrite rawPointCloud
   _clouds[f] = cloud;
   if (!writeFilteredPointCloud) {
@@ -269,7 +285,7 @@ void PipelineWriter::newFilteredPointCloud(
   fs::path path = _outputDir / insertFrame(_filteredPointCloudPath, f);
   fs::path pathMetrics =
       _outputDir / insertFrame(_filteredPointCloudMetricsPath, f);
-  write_point_cloud(path.string(), *cloud);
+  write_point_cloud(path.string(), *cloud, plyOptions);
   write_point_cloud_metrics(pathMetrics.string(), *cloud);
 }
 
@@ -287,8 +303,29 @@ void PipelineWriter::newClusters(
   fs::path path = _outputDir / insertFrame(_clustersPath, f);
   write_csv(path.string(), tmp);
 
-  // write clustered point cloud
-  PointCloud cloud = *_clouds[f];
+  auto cloudIt = _clouds.find(f);
+  if (cloudIt == _clouds.end()) {
+    BOOST_LOG_TRIVIAL(warning)
+        << "No point cloud for clusters of frame " << f << ", skipping.";
+    return;
+  }
+  // write clustered point cloud, points not in a large cluster keep their
+  // color
+  const PointCloudView &cloud = *cloudIt->second;
+
+  // cluster indices refer to the filtered (possibly reordered) cloud, also
+  // write them as indices of the raw point cloud
+  if (!cloud.complete()) {
+    for (auto &c : tmp) {
+      for (auto &i : c) {
+        i = cloud.parentIndex(i);
+      }
+    }
+    fs::path rawPath = _outputDir / insertFrame(_clustersRawPath, f);
+    write_csv(rawPath.string(), tmp);
+  }
+
+  std::vector<int> colorIndex(cloud.size(), -1);
   BOOST_LOG_TRIVIAL(trace) << "Writing point cloud with " << cloud.size()
                            << " points.";
   std::vector<Cluster> largeClusters;
@@ -298,19 +335,17 @@ void PipelineWriter::newClusters(
     }
     largeClusters.push_back(c);
   }
-  auto clusterColors = nColors(largeClusters.size());
+  const auto palette = toPalette(nColors(largeClusters.size()));
   for (size_t ci = 0; ci < largeClusters.size(); ++ci) {
     const auto &cluster = largeClusters[ci];
     for (auto i : cluster.points()) {
       assert(i < cloud.size());
-      auto color = clusterColors[ci];
-      cloud[i].r(color[0]);
-      cloud[i].g(color[1]);
-      cloud[i].b(color[2]);
+      colorIndex[i] = ci;
     }
   }
   fs::path cloudPath = _outputDir / insertFrame(_clusteredPointCloudPath, f);
-  write_point_cloud(cloudPath.string(), cloud);
+  write_point_cloud(cloudPath.string(), cloud, colorIndex, palette,
+                    plyOptions);
 
   fs::path cogsPath = _outputDir / insertFrame(_clustersCoGsPath, f);
   std::vector<std::vector<double>> controlPoints;
@@ -387,10 +422,15 @@ void PipelineWriter::newClusterChains(
   if (!writeClusteredPointCloud) {
     return;
   }
-  auto clusterColors = nColors(chains->size());
-  for (auto cloudIt : _clouds) {
+  const auto palette = toPalette(nColors(chains->size()));
+  // frames without a cloud don't show up, there is nothing to color
+  for (const auto &cloudIt : _clouds) {
     FrameNumber f = cloudIt.first;
-    PointCloud cloud = *cloudIt.second;
+    if (cloudIt.second == nullptr) {
+      continue;
+    }
+    const PointCloudView &cloud = *cloudIt.second;
+    std::vector<int> colorIndex(cloud.size(), -1);
     for (size_t chainIndex = 0; chainIndex < chains->size(); ++chainIndex) {
       const ClusterChain &chain = (*chains)[chainIndex];
       const auto &clus = chain.clusters();
@@ -402,14 +442,12 @@ void PipelineWriter::newClusterChains(
       const Cluster &clu = *(cluster->second);
       for (auto i : clu.points()) {
         assert(i < cloud.size());
-        auto color = clusterColors[chainIndex];
-        cloud[i].r(color[0]);
-        cloud[i].g(color[1]);
-        cloud[i].b(color[2]);
+        colorIndex[i] = chainIndex;
       }
     }
     fs::path cloudPath = _outputDir / insertFrame(_chainedPointCloudPath, f);
-    write_point_cloud(cloudPath.string(), cloud);
+    write_point_cloud(cloudPath.string(), cloud, colorIndex, palette,
+                      plyOptions);
   }
 }
 
@@ -433,7 +471,7 @@ const std::set<size_t> &PipelineWriter::labelsToIgnore() const {
   return _labelsToIgnore;
 }
 
-void PipelineWriter::writePng(const PictureD &pic,
+void PipelineWriter::writePng(const Picture &pic,
                               const std::string &path) const {
   if (pic.size() == 0) {
     return;
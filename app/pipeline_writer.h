@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "generic/write_point_cloud.h"
 #include "pipeline_observer.h"
 #include "types.h"
 #include <set>
@@ -25,8 +26,9 @@ public:
                          std::shared_ptr<const FrameWindow> window);
   virtual void newRawPointCloud(FrameNumber f,
                                 std::shared_ptr<const PointCloud> cloud);
-  virtual void newFilteredPointCloud(FrameNumber f,
-                                     std::shared_ptr<const PointCloud> cloud);
+  virtual void
+  newFilteredPointCloud(FrameNumber f,
+                        std::shared_ptr<const PointCloudView> cloud);
   virtual void
   newClusters(FrameNumber f,
               std::shared_ptr<const std::vector<Cluster>> clusters);
@@ -58,6 +60,9 @@ public:
   bool writeControlPoints = true;
   bool writeChainedPointCloud = true;
 
+  /// Encoding of all written point clouds
+  PlyOptions plyOptions;
+
   std::vector<std::vector<double>> &forcedNColors();
   const std::vector<std::vector<double>> &forcedNColors() const;
 
@@ -85,12 +90,14 @@ private:
   std::string _filteredPointCloudMetricsPath;
   std::string _clusteredPointCloudPath;
   std::string _clustersPath;
+  std::string _clustersRawPath;
   std::string _clustersCoGsPath;
   std::string _descriptorsPath;
   std::string _matchesPath;
   std::string _controlPointsPath;
   std::string _chainedPointCloudPath;
-  std::unordered_map<FrameNumber, std::shared_ptr<const PointCloud>> _clouds;
+  std::unordered_map<FrameNumber, std::shared_ptr<const PointCloudView>>
+      _clouds;
   std::unordered_map<FrameNumber, std::shared_ptr<const std::vector<Cluster>>>
       _clusters;
 
@@ -100,7 +107,7 @@ private:
                            StreamNumber f) const;
 
   /// only writes image, if not empty
-  void writePng(const PictureD &pic, const std::string &path) const;
+  void writePng(const Picture &pic, const std::string &path) const;
 
   std::vector<std::vector<double>> nColors(int n) const;
 
@@ -0,0 +1,172 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "async_observer.h"
+#include "pipeline_writer.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+
+namespace utf = boost::unit_test;
+namespace fs = boost::filesystem;
+
+namespace MouseTrack {
+namespace {
+
+/// Forwards to `target`, the first call waits until `release()` (or a short
+/// timeout, so a blocking sender can't dead lock the test)
+class GatedObserver : public PipelineObserver {
+public:
+  GatedObserver(PipelineObserver &target) : _target(target) {
+    // empty
+  }
+  void frameStart(FrameNumber f) {
+    gate();
+    _target.frameStart(f);
+  }
+  void frameEnd(FrameNumber f) { _target.frameEnd(f); }
+  void newRawPointCloud(FrameNumber f,
+                        std::shared_ptr<const PointCloud> cloud) {
+    _target.newRawPointCloud(f, cloud);
+  }
+  void newFilteredPointCloud(FrameNumber f,
+                             std::shared_ptr<const PointCloudView> cloud) {
+    _target.newFilteredPointCloud(f, cloud);
+  }
+  void newClusters(FrameNumber f,
+                   std::shared_ptr<const std::vector<Cluster>> clusters) {
+    _target.newClusters(f, clusters);
+  }
+
+  /// Blocks until the first call waits at the gate
+  void waitUntilEntered() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _changed.wait(lock, [this]() { return _entered; });
+  }
+
+  void release() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _released = true;
+    _changed.notify_all();
+  }
+
+private:
+  PipelineObserver &_target;
+  std::mutex _mutex;
+  std::condition_variable _changed;
+  bool _entered = false;
+  bool _released = false;
+
+  void gate() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_entered) {
+      return;
+    }
+    _entered = true;
+    _changed.notify_all();
+    _changed.wait_for(lock, std::chrono::milliseconds(200),
+                      [this]() { return _released; });
+  }
+};
+
+/// Frame f: a raw cloud of 4 points, a filtered view of the points 3, 2 and
+/// 1 (in this order) and one cluster over the whole view
+void sendClouds(PipelineObserver &observer, FrameNumber f) {
+  auto raw = std::make_shared<PointCloud>();
+  raw->resize(4, 0);
+  for (int i = 0; i < 4; ++i) {
+    (*raw)[i].x(10 * f + i);
+    (*raw)[i].y(0);
+    (*raw)[i].z(0);
+  }
+  std::shared_ptr<const PointCloud> cloud = raw;
+  auto filtered = std::make_shared<const PointCloudView>(
+      PointCloudView(cloud).select(std::vector<PointIndex>{3, 2, 1}));
+  auto clusters = std::make_shared<const std::vector<Cluster>>(
+      1, Cluster(std::vector<PointIndex>{0, 1, 2}));
+  observer.newRawPointCloud(f, cloud);
+  observer.newFilteredPointCloud(f, filtered);
+  observer.newClusters(f, clusters);
+}
+
+std::string readFile(const fs::path &path) {
+  std::ifstream in(path.string());
+  return std::string((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+}
+
+/// Floods a small queue while the writer is stuck in frame 0. Without
+/// protected clouds, both policies deliver the clusters of frame 1 after
+/// dropping its clouds. Every frame with clusters needs its filtered cloud:
+/// the clusters mapped to the raw cloud are the points 3, 2 and 1.
+void checkDroppingWriter(AsyncObserver::Policy policy) {
+  const fs::path dir =
+      fs::temp_directory_path() / fs::unique_path("mousetrack-%%%%%%%%");
+  {
+    PipelineWriter writer(dir);
+    GatedObserver gated(writer);
+    // room for exactly one frame
+    AsyncObserver async(&gated, policy, 5);
+    async.frameStart(0);
+    gated.waitUntilEntered();
+    sendClouds(async, 0);
+    async.frameEnd(0);
+    async.frameStart(1);
+    sendClouds(async, 1);
+    async.frameEnd(1);
+    async.frameStart(2);
+    gated.release();
+    async.frameEnd(2);
+    async.flush();
+
+    // nothing is dropped on an empty queue
+    async.frameStart(3);
+    sendClouds(async, 3);
+    async.frameEnd(3);
+    async.flush();
+  }
+  BOOST_CHECK(fs::exists(dir / "clusters_3.csv"));
+  for (FrameNumber f = 0; f < 4; ++f) {
+    const std::string suffix = std::to_string(f) + ".csv";
+    if (!fs::exists(dir / ("clusters_" + suffix))) {
+      continue;
+    }
+    BOOST_CHECK_EQUAL(readFile(dir / ("clusters_" + suffix)), "0,1,2\n");
+    BOOST_CHECK_EQUAL(readFile(dir / ("clusters_raw_" + suffix)), "3,2,1\n");
+  }
+  fs::remove_all(dir);
+}
+
+} // namespace
+} // namespace MouseTrack
+
+BOOST_AUTO_TEST_CASE(pipeline_writer_drop_oldest_keeps_clouds) {
+  MouseTrack::checkDroppingWriter(MouseTrack::AsyncObserver::DROP_OLDEST);
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_writer_coalesce_keeps_clouds) {
+  MouseTrack::checkDroppingWriter(MouseTrack::AsyncObserver::COALESCE);
+}
+
+BOOST_AUTO_TEST_CASE(pipeline_writer_clusters_without_cloud) {
+  const fs::path dir =
+      fs::temp_directory_path() / fs::unique_path("mousetrack-%%%%%%%%");
+  {
+    MouseTrack::PipelineWriter writer(dir);
+    auto clusters = std::make_shared<const std::vector<MouseTrack::Cluster>>(
+        1, MouseTrack::Cluster(std::vector<MouseTrack::PointIndex>{0}));
+    writer.newClusters(7, clusters);
+    writer.newClusterChains(
+        std::make_shared<const std::vector<MouseTrack::ClusterChain>>());
+  }
+  BOOST_CHECK(fs::exists(dir / "clusters_7.csv"));
+  BOOST_CHECK(!fs::exists(dir / "clustered_point_cloud_7.ply"));
+  fs::remove_all(dir);
+}
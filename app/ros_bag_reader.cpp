@@ -101,13 +101,15 @@ FrameWindow RosBagReader::frameWindow(FrameNumber f) const {
     const rosbag::MessageInstance *msg = frameMessage(index(s, Reference), f);
     if (msg != nullptr) {
       PictureI im = readImageFromMsg(*msg);
-      frame.referencePicture = im.cast<PictureD::Scalar>() * (1.0 / 255);
+      frame.referencePicture =
+          im.cast<Picture::Scalar>() * Picture::Scalar(1.0 / 255);
     }
     msg = frameMessage(index(s, Disparity), f);
     if (msg != nullptr) {
       PictureI im = readImageFromMsg(*msg);
 
-      frame.rawDisparityMap = im.cast<PictureD::Scalar>() * (1.0 / 255);
+      frame.rawDisparityMap =
+          im.cast<DisparityMap::Scalar>() * DisparityMap::Scalar(1.0 / 255);
       frame.normalizedDisparityMap = normalizeDisparity(im);
     }
     // camInfo holds: focallength, ccx, ccy
@@ -137,8 +139,8 @@ FrameWindow RosBagReader::frameWindow(FrameNumber f) const {
   return window;
 }
 
-PictureD RosBagReader::normalizeDisparity(const PictureI &disp) const {
-  PictureD im(disp.rows(), disp.cols());
+DisparityMap RosBagReader::normalizeDisparity(const PictureI &disp) const {
+  DisparityMap im(disp.rows(), disp.cols());
   // process disparity map to get a cleaned version
   // crop last 3 bits of 8 bit disparity value (contains debug info)
   for (int i = 0; i < disp.rows(); ++i) {
@@ -147,8 +149,8 @@ PictureD RosBagReader::normalizeDisparity(const PictureI &disp) const {
       // 2. then scale according to fpga set up
       // adjust for extended disparity range with offset of 32 pixels and every:
       // im = disparityMap * 2 + 32;
-      // 3. divide by 255 to convert from PictureI to PictureD
-      im(i, j) = ((disp(i, j) >> 3) * 2 + 32) / 255.0;
+      // 3. divide by 255 to convert from PictureI to DisparityMap
+      im(i, j) = ((disp(i, j) >> 3) * 2 + 32) / DisparityMap::Scalar(255);
     }
   }
 
@@ -85,7 +85,7 @@ private:
   /// `_upperFrameDuration` seconds, we classify them as no longer synchronized
   ros::Duration _upperFrameDuration = ros::Duration(0.1);
 
-  PictureD normalizeDisparity(const PictureI &disp) const;
+  DisparityMap normalizeDisparity(const PictureI &disp) const;
 
   PictureI readImageFromMsg(const rosbag::MessageInstance &it) const;
 
@@ -6,7 +6,7 @@
 #pragma once
 
 #include "generic/cluster.h"
-#include "generic/point_cloud.h"
+#include "generic/point_cloud_view.h"
 #include <vector>
 
 namespace MouseTrack {
@@ -15,7 +15,8 @@ namespace MouseTrack {
 class Clustering {
 public:
   /// Takes a point cloud and splits it into clusters.
-  virtual std::vector<Cluster> operator()(const PointCloud &cloud) const = 0;
+  virtual std::vector<Cluster>
+  operator()(const PointCloudView &cloud) const = 0;
 };
 
 } // namespace MouseTrack
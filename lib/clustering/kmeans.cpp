@@ -16,7 +16,7 @@ KMeans::KMeans(int K) : _k(K) {
   // empty
 }
 
-std::vector<Cluster> KMeans::operator()(const PointCloud &cloud) const {
+std::vector<Cluster> KMeans::operator()(const PointCloudView &cloud) const {
   BOOST_LOG_TRIVIAL(trace) << "KMeans algorithm started";
   // Convert point cloud to Eigen vectors
 
@@ -28,19 +28,13 @@ std::vector<Cluster> KMeans::operator()(const PointCloud &cloud) const {
   PointList means(dims, K());
   PointList prevMeans;
 
-  PointList points;
-  points.resize(dims, cloud.size());
-  for (PointIndex i = 0; i < cloud.size(); i += 1) {
-    auto v = cloud[i].characteristic();
-    points.col(i) = v;
-  }
+  PointList points = cloud.characteristics();
 
   // TODO: get kmeans++ initialization
   means = points.block(0, 0, dims, K());
 
-  Eigen::VectorXd min = points.rowwise().minCoeff();
-  Eigen::VectorXd max = points.rowwise().maxCoeff();
-  Eigen::VectorXd bb_size = max - min;
+  const PointCloud::Statistics stats = cloud.statistics();
+  OFactory::Point bb_size = stats.max - stats.min;
 
   BOOST_LOG_TRIVIAL(debug) << "KMeans: bb: " << bb_size;
 
@@ -86,7 +80,7 @@ std::vector<Cluster> KMeans::operator()(const PointCloud &cloud) const {
         int pi = clusters[c].points()[i];
         assigned.col(i) = points.col(pi);
       }
-      Eigen::VectorXd mean =
+      OFactory::Point mean =
           assigned.array().rowwise().sum() / (assigned.cols() + .000001);
       means.col(c) = mean;
     }
@@ -22,13 +22,13 @@ namespace MouseTrack {
 /// This is repeated until convergence.
 class KMeans : public Clustering {
 public:
-  typedef OracleFactory<Precision> OFactory;
+  typedef OracleFactory<Coordinate> OFactory;
   typedef OFactory::Oracle Oracle;
   typedef Oracle::PointList PointList;
 
   KMeans(int k);
 
-  virtual std::vector<Cluster> operator()(const PointCloud &cloud) const;
+  virtual std::vector<Cluster> operator()(const PointCloudView &cloud) const;
 
   void K(int k);
   int K() const;
@@ -10,7 +10,7 @@
 namespace MouseTrack {
 
 std::vector<Cluster> LabelClustering::
-operator()(const PointCloud &cloud) const {
+operator()(const PointCloudView &cloud) const {
   BOOST_LOG_TRIVIAL(trace) << "LabelClustering: dims: " << cloud.labelsDim();
   int clusterCount = cloud.labelsDim() + 1;
   std::vector<Cluster> clusters(clusterCount);
@@ -16,7 +16,7 @@ namespace MouseTrack {
 /// `_rejectionThreshold`.
 class LabelClustering : public Clustering {
 public:
-  std::vector<Cluster> operator()(const PointCloud &cloud) const;
+  std::vector<Cluster> operator()(const PointCloudView &cloud) const;
 
 private:
   Precision _rejectionThreshold = 0.2;
@@ -9,6 +9,7 @@
 #include "spatial/uniform_grid.h"
 #include <Eigen/Dense>
 #include <boost/log/trivial.hpp>
+#include <cmath>
 #include <iostream>
 
 namespace MouseTrack {
@@ -17,7 +18,8 @@ MeanShift::MeanShift(double window_size) : _window_size(window_size) {
   // empty
 }
 
-std::vector<Cluster> MeanShift::operator()(const PointCloud &cloud) const {
+std::vector<Cluster> MeanShift::
+operator()(const PointCloudView &cloud) const {
   BOOST_LOG_TRIVIAL(trace) << "MeanShift algorithm started";
   // Convert point cloud to Eigen vectors
 
@@ -25,24 +27,16 @@ std::vector<Cluster> MeanShift::operator()(const PointCloud &cloud) const {
     return std::vector<Cluster>();
   }
 
-  const int dimensions = cloud.charDim();
-
-  Oracle::PointList points;
-  points.resize(dimensions, cloud.size());
-  for (PointIndex i = 0; i < cloud.size(); i += 1) {
-    auto v = cloud[i].characteristic();
-    points.col(i) = v;
-  }
+  Oracle::PointList points = cloud.characteristics();
 
   bool normalize = false;
   if (normalize) {
-    Eigen::VectorXd min = points.rowwise().minCoeff();
-    Eigen::VectorXd max = points.rowwise().maxCoeff();
-    Eigen::VectorXd bb_size = max - min;
+    const PointCloud::Statistics stats = cloud.statistics();
+    Vector bb_size = stats.max - stats.min;
     points = (points.array().colwise()) / bb_size.array();
   }
 
-  std::vector<Eigen::VectorXd> currCenters = convergePoints(points);
+  std::vector<Vector> currCenters = convergePoints(points);
 
   BOOST_LOG_TRIVIAL(debug) << "Merging points to clusters";
   // Merge step
@@ -54,12 +48,12 @@ std::vector<Cluster> MeanShift::operator()(const PointCloud &cloud) const {
   return clusters;
 }
 
-std::vector<Eigen::VectorXd>
+std::vector<MeanShift::Vector>
 MeanShift::convergePoints(const Oracle::PointList &points) const {
 
   const int dimensions = points.rows();
 
-  std::vector<Eigen::VectorXd> currCenters, pointsVec;
+  std::vector<Vector> currCenters, pointsVec;
 
   for (int i = 0; i < points.cols(); i += 1) {
     auto v = points.col(i);
@@ -72,12 +66,14 @@ MeanShift::convergePoints(const Oracle::PointList &points) const {
     OFactory::Query q;
     q.maxR = 2 * _window_size;
     q.dimensions = dimensions;
+    q.example_data = &points;
     oraclePtr = oracleFactory().forQuery(q);
   }
   Oracle &oracle = *oraclePtr;
 
   // Initialize some stuff used in the MeanShift loop
-  Eigen::VectorXd prevCenter;
+  Vector prevCenter;
+  WeightedMean weightedMean(points, _window_size);
 
   oracle.compute(points);
 
@@ -90,21 +86,15 @@ MeanShift::convergePoints(const Oracle::PointList &points) const {
       iterations++;
       // perform one iteration of mean shift
       prevCenter = currCenters[i];
-      std::vector<PointIndex> locals =
-          oracle.find_in_range(currCenters[i], 2 * _window_size)[0];
-      if (locals.empty()) {
+      weightedMean.reset();
+      oracle.visit_in_range(currCenters[i], 2 * _window_size, weightedMean);
+      if (weightedMean.count() == 0) {
         BOOST_LOG_TRIVIAL(warning)
             << "No points in neighborhood, falling back to brute force.";
         currCenters[i] = iterate_mode(currCenters[i], pointsVec);
         break;
-      } else {
-        std::vector<Eigen::VectorXd> localPoints;
-        for (int li : locals) {
-          localPoints.push_back(points.col(li));
-        }
-
-        currCenters[i] = iterate_mode(currCenters[i], localPoints);
       }
+      weightedMean.mean(currCenters[i]);
 
       if (iterations > _max_iterations) {
         BOOST_LOG_TRIVIAL(warning)
@@ -122,7 +112,7 @@ MeanShift::convergePoints(const Oracle::PointList &points) const {
 }
 
 std::vector<Cluster>
-MeanShift::mergePoints(std::vector<Eigen::VectorXd> &currCenters) const {
+MeanShift::mergePoints(std::vector<Vector> &currCenters) const {
   // Initialize Clusters. Initially, every point has its own cluster.
   const size_t nPoints = currCenters.size();
   std::vector<Cluster> clusters(nPoints);
@@ -138,7 +128,7 @@ MeanShift::mergePoints(std::vector<Eigen::VectorXd> &currCenters) const {
     }
     // Check modes we haven't already executed the (i)-loop for
     for (size_t j = i + 1; j < currCenters.size(); j++) {
-      Eigen::VectorXd diff = currCenters[i] - currCenters[j];
+      Vector diff = currCenters[i] - currCenters[j];
       if (diff.norm() < _merge_threshold) {
         // Merge clusters. Erase one of the modes corresponding to the clusters
         // and append points belonging to j to cluser of i
@@ -156,8 +146,7 @@ MeanShift::mergePoints(std::vector<Eigen::VectorXd> &currCenters) const {
   return clusters;
 }
 
-double MeanShift::gaussian_weight(const Eigen::VectorXd point,
-                                  const Eigen::VectorXd mean) const {
+double MeanShift::gaussian_weight(const Vector point, const Vector mean) const {
 
   // assert if dimensions match
   assert(mean.size() == point.size());
@@ -169,22 +158,69 @@ double MeanShift::gaussian_weight(const Eigen::VectorXd point,
   return exp(-d / (2 * _window_size));
 }
 
-Eigen::VectorXd
-MeanShift::iterate_mode(const Eigen::VectorXd mode,
-                        const std::vector<Eigen::VectorXd> &fixedPoints) const {
+MeanShift::Vector
+MeanShift::iterate_mode(const Vector mode,
+                        const std::vector<Vector> &fixedPoints) const {
   // COG Normalization Factor
   double normfact = 0;
   // Rest of COG
-  Eigen::VectorXd cog = Eigen::VectorXd::Zero(mode.size());
+  Vector cog = Vector::Zero(mode.size());
   for (size_t i = 0; i < fixedPoints.size(); i++) {
-    double temp = gaussian_weight(fixedPoints[i], mode);
+    const Coordinate temp = gaussian_weight(fixedPoints[i], mode);
     normfact += temp;
     cog += temp * fixedPoints[i];
   }
-  cog = cog * (1.0 / normfact);
+  cog = cog * Coordinate(1.0 / normfact);
   return cog;
 }
 
+MeanShift::WeightedMean::WeightedMean(const Oracle::PointList &points,
+                                      double window_size)
+    : _points(points), _variance2(2 * window_size),
+      _cog(Vector::Zero(points.rows())) {
+  reset();
+}
+
+void MeanShift::WeightedMean::reset() {
+  _normfact = 0;
+  _cog.setZero();
+  _count = 0;
+  _pending = 0;
+}
+
+void MeanShift::WeightedMean::operator()(PointIndex index,
+                                         Coordinate squaredDistance) {
+  _distances[_pending] = squaredDistance;
+  _indices[_pending] = index;
+  _pending += 1;
+  _count += 1;
+  if (_pending == blockSize) {
+    flush();
+  }
+}
+
+size_t MeanShift::WeightedMean::count() const { return _count; }
+
+void MeanShift::WeightedMean::mean(Vector &mean) {
+  flush();
+  mean = _cog * Coordinate(1.0 / _normfact);
+}
+
+void MeanShift::WeightedMean::flush() {
+  if (_pending == 0) {
+    return;
+  }
+  // evaluate the kernel for the pending part of the block (vectorized), the
+  // rest of `_distances` is stale
+  const Eigen::Array<Coordinate, Eigen::Dynamic, 1, 0, blockSize, 1> weights =
+      (-_distances.head(_pending) / _variance2).exp();
+  for (int i = 0; i < _pending; ++i) {
+    _normfact += weights[i];
+    _cog += weights[i] * _points.col(_indices[i]);
+  }
+  _pending = 0;
+}
+
 void MeanShift::setMaxIterations(int max_iterations) {
   _max_iterations = max_iterations;
 }
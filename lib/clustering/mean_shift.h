@@ -10,6 +10,7 @@
 #include "generic/cluster.h"
 #include "spatial/oracle_factory.h"
 #include <Eigen/Core>
+#include <array>
 #include <vector>
 
 namespace MouseTrack {
@@ -31,14 +32,16 @@ namespace MouseTrack {
 
 class MeanShift : public Clustering {
 public:
-  typedef OracleFactory<double> OFactory;
+  typedef OracleFactory<Coordinate> OFactory;
   typedef OFactory::Oracle Oracle;
+  /// A single point in characteristic space
+  typedef OFactory::Point Vector;
 
   /// window_size is the sigma for the gaussian kernel
   MeanShift(double window_size);
 
   /// Performs MeanShift algorithm
-  virtual std::vector<Cluster> operator()(const PointCloud &cloud) const;
+  virtual std::vector<Cluster> operator()(const PointCloudView &cloud) const;
 
   void setMaxIterations(int max_iterations);
   int getMaxIterations() const;
@@ -60,17 +63,52 @@ public:
 
 protected:
   /// Converge points according to mean shift procedure
-  virtual std::vector<Eigen::VectorXd>
+  virtual std::vector<Vector>
   convergePoints(const Oracle::PointList &points) const;
 
   /// Merge the converged points into clusters
   virtual std::vector<Cluster>
-  mergePoints(std::vector<Eigen::VectorXd> &points) const;
+  mergePoints(std::vector<Vector> &points) const;
 
   /// Returns a weight in [0,1] for point by applying a gaussian kernel with
   /// variance window_size and mean mean
-  double gaussian_weight(const Eigen::VectorXd point,
-                         const Eigen::VectorXd mean) const;
+  double gaussian_weight(const Vector point, const Vector mean) const;
+
+  /// Accumulates the gaussian weighted center of gravity of the points
+  /// visited by an oracle query, so one mean shift step needs no temporary
+  /// neighbor lists.
+  class WeightedMean : public Oracle::Visitor {
+  public:
+    WeightedMean(const Oracle::PointList &points, double window_size);
+
+    /// Forget all visited points
+    void reset();
+
+    virtual void operator()(PointIndex index, Coordinate squaredDistance);
+
+    /// Number of points visited since the last reset
+    size_t count() const;
+
+    /// Stores the weighted mean of the visited points in `mean`
+    void mean(Vector &mean);
+
+  private:
+    const Oracle::PointList &_points;
+    const Coordinate _variance2;
+    double _normfact;
+    Vector _cog;
+    size_t _count;
+
+    /// Visited points are collected in blocks, so the kernel can be
+    /// evaluated for a whole block at once
+    static constexpr int blockSize = 128;
+    Eigen::Array<Coordinate, blockSize, 1> _distances;
+    std::array<PointIndex, blockSize> _indices;
+    int _pending;
+
+    /// Adds the pending points to `_cog` and `_normfact`
+    void flush();
+  };
 
 private:
   /// when two peaks are closer than this, they are merged. Must be larger than
@@ -88,8 +126,8 @@ private:
   double _window_size;
 
   /// Performs one iteration of the mean shift algorithm for a single mode
-  Eigen::VectorXd iterate_mode(const Eigen::VectorXd mode,
-                               const std::vector<Eigen::VectorXd> &state) const;
+  Vector iterate_mode(const Vector mode,
+                      const std::vector<Vector> &state) const;
 
   OFactory _oracleFactory;
 };
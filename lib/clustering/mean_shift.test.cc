@@ -4,6 +4,7 @@
 ///
 
 #include "mean_shift.h"
+#include "mean_shift_cpu_optimized.h"
 
 #include <boost/test/floating_point_comparison.hpp>
 #include <boost/test/unit_test.hpp>
@@ -16,7 +17,7 @@ namespace utf = boost::unit_test;
 BOOST_AUTO_TEST_CASE(mean_shift_read_write) {
   MouseTrack::PointCloud pc;
   MouseTrack::MeanShift ms = MouseTrack::MeanShift(1);
-  ms(pc);
+  ms(MouseTrack::PointCloudView(pc));
 }
 
 BOOST_AUTO_TEST_CASE(mean_shift_single_point) {
@@ -29,7 +30,8 @@ BOOST_AUTO_TEST_CASE(mean_shift_single_point) {
   pc[0].z(5);
   pc[0].intensity(1);
 
-  std::vector<MouseTrack::Cluster> clusters = ms(pc);
+  std::vector<MouseTrack::Cluster> clusters =
+      ms(MouseTrack::PointCloudView(pc));
   BOOST_CHECK_EQUAL(clusters.size(), 1);
 }
 
@@ -46,7 +48,8 @@ BOOST_AUTO_TEST_CASE(two_faraway_points) {
   pc[1].z(100);
   pc[1].intensity(1);
 
-  std::vector<MouseTrack::Cluster> clusters = ms(pc);
+  std::vector<MouseTrack::Cluster> clusters =
+      ms(MouseTrack::PointCloudView(pc));
   BOOST_CHECK_EQUAL(clusters.size(), 2);
 }
 
@@ -63,7 +66,8 @@ BOOST_AUTO_TEST_CASE(two_closetogether_points) {
   pc[1].z(0.1);
   pc[1].intensity(0);
 
-  std::vector<MouseTrack::Cluster> clusters = ms(pc);
+  std::vector<MouseTrack::Cluster> clusters =
+      ms(MouseTrack::PointCloudView(pc));
   BOOST_CHECK_EQUAL(clusters.size(), 1);
 }
 
@@ -95,7 +99,8 @@ BOOST_AUTO_TEST_CASE(three_gaussian_clusters) {
     pc[i + 2].intensity(gauss0(gen));
   }
 
-  std::vector<MouseTrack::Cluster> clusters = ms(pc);
+  std::vector<MouseTrack::Cluster> clusters =
+      ms(MouseTrack::PointCloudView(pc));
 
   BOOST_CHECK_EQUAL(clusters.size(), 3);
   BOOST_CHECK_EQUAL(clusters[0].points().size(), 100);
@@ -139,7 +144,8 @@ BOOST_AUTO_TEST_CASE(expected_clustering) {
 
   MouseTrack::MeanShift ms = MouseTrack::MeanShift(1.0);
 
-  std::vector<MouseTrack::Cluster> clusters = ms(pc);
+  std::vector<MouseTrack::Cluster> clusters =
+      ms(MouseTrack::PointCloudView(pc));
 
   BOOST_CHECK_EQUAL(clusters.size(), 3);
 
@@ -153,3 +159,33 @@ BOOST_AUTO_TEST_CASE(expected_clustering) {
   BOOST_CHECK(expected[1] == received[1]);
   BOOST_CHECK(expected[2] == received[2]);
 }
+
+BOOST_AUTO_TEST_CASE(mean_shift_cpu_optimized_three_gaussian_clusters) {
+  // enough points to converge modes on several threads
+  std::default_random_engine gen;
+  std::normal_distribution<double> gauss0(0.0, 1.0);
+  std::normal_distribution<double> gauss10(100.0, 1.0);
+
+  const int n = 3000;
+  MouseTrack::PointCloud pc;
+  pc.resize(n, 0);
+  for (int i = 0; i < n; i += 3) {
+    for (int c = 0; c < 3; c += 1) {
+      pc[i + c].x(c == 0 ? gauss10(gen) : gauss0(gen));
+      pc[i + c].y(c == 1 ? gauss10(gen) : gauss0(gen));
+      pc[i + c].z(c == 2 ? gauss10(gen) : gauss0(gen));
+      pc[i + c].intensity(gauss0(gen));
+    }
+  }
+
+  MouseTrack::MeanShiftCpuOptimized ms(2.0);
+  std::vector<MouseTrack::Cluster> clusters =
+      ms(MouseTrack::PointCloudView(pc));
+
+  BOOST_REQUIRE_EQUAL(clusters.size(), 3);
+  for (const auto &cluster : clusters) {
+    const auto cog =
+        cluster.center_of_gravity(MouseTrack::PointCloudView(pc));
+    BOOST_CHECK_EQUAL((cog.array() > 50).count(), 1);
+  }
+}
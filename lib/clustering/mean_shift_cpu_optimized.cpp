@@ -9,6 +9,7 @@
 #include <Eigen/Dense>
 #include <boost/log/trivial.hpp>
 #include <iostream>
+#include <numeric>
 
 namespace MouseTrack {
 
@@ -17,12 +18,12 @@ MeanShiftCpuOptimized::MeanShiftCpuOptimized(double window_size)
   // empty
 }
 
-std::vector<Eigen::VectorXd>
+std::vector<MeanShiftCpuOptimized::Vector>
 MeanShiftCpuOptimized::convergePoints(const Oracle::PointList &points) const {
 
   const int dimensions = points.rows();
 
-  std::vector<Eigen::VectorXd> currCenters;
+  std::vector<Vector> currCenters;
 
   for (int i = 0; i < points.cols(); i += 1) {
     auto v = points.col(i);
@@ -34,56 +35,61 @@ MeanShiftCpuOptimized::convergePoints(const Oracle::PointList &points) const {
     OFactory::Query q;
     q.maxR = 2 * getWindowSize();
     q.dimensions = dimensions;
+    q.example_data = &points;
     _cachedConvergeOracle = oracleFactory().forQuery(q);
   }
   Oracle &oracle = *_cachedConvergeOracle;
 
   oracle.compute(points);
 
-  // For each point...
-  for (size_t i = 0; i < currCenters.size(); i++) {
-    int iterations = 0; // for logging and abort condition
-
-    Eigen::VectorXd prevCenter;
-    // ... iterate until convergence
-    do {
-      iterations++;
-      // perform one iteration of mean shift
-      prevCenter = currCenters[i];
-      std::vector<PointIndex> locals =
-          oracle.find_in_range(currCenters[i], 2 * getWindowSize())[0];
-      if (locals.empty()) {
-        BOOST_LOG_TRIVIAL(warning)
-            << "No points in neighborhood, falling back to brute force.";
-        currCenters[i] = iterate_mode(currCenters[i], points);
-        break;
-      } else {
-        PointList localPoints(points.rows(), locals.size());
-        for (size_t i = 0; i < locals.size(); ++i) {
-          const auto li = locals[i];
-          localPoints.col(i) = points.col(li);
+  // Modes are independent of each other, each thread has its own scratch
+  // space and only reads from the oracle.
+  const int nPoints = currCenters.size();
+#pragma omp parallel
+  {
+    WeightedMean weightedMean(points, getWindowSize());
+    Vector prevCenter;
+
+    // For each point...
+#pragma omp for schedule(dynamic, 16)
+    for (int i = 0; i < nPoints; i++) {
+      int iterations = 0; // for logging and abort condition
+
+      // ... iterate until convergence
+      do {
+        iterations++;
+        // perform one iteration of mean shift
+        prevCenter = currCenters[i];
+        weightedMean.reset();
+        oracle.visit_in_range(currCenters[i], 2 * getWindowSize(),
+                              weightedMean);
+        if (weightedMean.count() == 0) {
+          BOOST_LOG_TRIVIAL(warning)
+              << "No points in neighborhood, falling back to brute force.";
+          currCenters[i] = iterate_mode(currCenters[i], points);
+          break;
         }
+        weightedMean.mean(currCenters[i]);
 
-        currCenters[i] = iterate_mode(currCenters[i], localPoints);
-      }
-
-      if (iterations > getMaxIterations()) {
-        BOOST_LOG_TRIVIAL(warning)
-            << "Max number of iterations for point " << i
-            << " reached - continuing without convergence for this point";
-        break;
+        if (iterations > getMaxIterations()) {
+          BOOST_LOG_TRIVIAL(warning)
+              << "Max number of iterations for point " << i
+              << " reached - continuing without convergence for this point";
+          break;
+        }
+      } while ((prevCenter - currCenters[i]).norm() >
+               getConvergenceThreshold());
+      if (i % 1024 == 0) {
+        BOOST_LOG_TRIVIAL(trace)
+            << "converged i " << i << " after " << iterations << " iterations";
       }
-    } while ((prevCenter - currCenters[i]).norm() > getConvergenceThreshold());
-    if (i % 1024 == 0) {
-      BOOST_LOG_TRIVIAL(trace)
-          << "converged i " << i << " after " << iterations << " iterations";
     }
   }
   return currCenters;
 }
 
 std::vector<Cluster> MeanShiftCpuOptimized::mergePoints(
-    std::vector<Eigen::VectorXd> &currCenters) const {
+    std::vector<Vector> &currCenters) const {
   std::vector<Cluster> clusters;
   std::vector<int> remainingPoints(currCenters.size());
   std::iota(remainingPoints.begin(), remainingPoints.end(), 0);
@@ -120,7 +126,8 @@ std::vector<Cluster> MeanShiftCpuOptimized::mergePoints(
     // erase_indices assumes a sorted index vector
     std::sort(neighbors.begin(), neighbors.end());
 
-    std::vector<size_t> cluster(neighbors.size());
+    std::vector<size_t> cluster;
+    cluster.reserve(neighbors.size());
     for (const auto ni : neighbors) {
       cluster.push_back(remainingPoints[ni]);
     }
@@ -146,19 +153,21 @@ std::vector<Cluster> MeanShiftCpuOptimized::mergePoints(
   return clusters;
 }
 
-Eigen::VectorXd
-MeanShiftCpuOptimized::iterate_mode(const Eigen::VectorXd &mode,
+MeanShiftCpuOptimized::Vector
+MeanShiftCpuOptimized::iterate_mode(const Vector &mode,
                                     const PointList &fixedPoints) const {
   auto w = (fixedPoints.colwise() - mode).colwise().squaredNorm();
-  Eigen::RowVectorXd weights = (-w.array() / (2 * getWindowSize())).exp();
+  const Coordinate variance2 = 2 * getWindowSize();
+  Eigen::Matrix<Coordinate, 1, Eigen::Dynamic> weights =
+      (-w.array() / variance2).exp();
   assert(weights.rows() == 1);
   assert(weights.cols() == fixedPoints.cols());
   // COG Normalization Factor
   double normfact = weights.sum();
-  Eigen::VectorXd cog =
+  Vector cog =
       (fixedPoints.array().rowwise() * weights.array()).rowwise().sum();
   assert(cog.size() == mode.size());
-  cog = cog * (1.0 / normfact);
+  cog = cog * Coordinate(1.0 / normfact);
   return cog;
 }
 
@@ -14,23 +14,24 @@
 namespace MouseTrack {
 
 /// For CPU optimized version of MeanShift (parallelizm, cache locallity)
+///
+/// Modes are converged in parallel, one point per thread at a time.
 class MeanShiftCpuOptimized : public MeanShift {
 public:
   /// k is the number of desired clusters
   MeanShiftCpuOptimized(double window_size);
 
 protected:
-  virtual std::vector<Eigen::VectorXd>
+  virtual std::vector<Vector>
   convergePoints(const Oracle::PointList &points) const;
 
   virtual std::vector<Cluster>
-  mergePoints(std::vector<Eigen::VectorXd> &points) const;
+  mergePoints(std::vector<Vector> &points) const;
 
 private:
-  typedef UniformGrid4d::PointList PointList;
+  typedef Oracle::PointList PointList;
   /// Performs one iteration of the mean shift algorithm for a single mode
-  Eigen::VectorXd iterate_mode(const Eigen::VectorXd &mode,
-                               const PointList &state) const;
+  Vector iterate_mode(const Vector &mode, const PointList &state) const;
 
   mutable std::mutex _convergeOracleMutex;
   mutable std::unique_ptr<Oracle> _cachedConvergeOracle;
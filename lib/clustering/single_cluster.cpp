@@ -16,7 +16,8 @@ SingleCluster::SingleCluster() {
   // empty
 }
 
-std::vector<Cluster> SingleCluster::operator()(const PointCloud &cloud) const {
+std::vector<Cluster> SingleCluster::
+operator()(const PointCloudView &cloud) const {
   BOOST_LOG_TRIVIAL(trace) << "SingleCluster started";
   //Create vector with single cluster containing all the points
   std::vector<Cluster> cluster_vec(1);
@@ -20,7 +20,7 @@ public:
 
   SingleCluster();
 
-  std::vector<Cluster> operator()(const PointCloud &cloud) const;
+  std::vector<Cluster> operator()(const PointCloudView &cloud) const;
 
 };
 
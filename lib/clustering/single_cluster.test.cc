@@ -29,7 +29,8 @@ BOOST_AUTO_TEST_CASE(single_cluster) {
 
   MouseTrack::SingleCluster sc = MouseTrack::SingleCluster();
 
-  std::vector<MouseTrack::Cluster> clusters = sc(pc);
+  std::vector<MouseTrack::Cluster> clusters =
+      sc(MouseTrack::PointCloudView(pc));
 
   BOOST_CHECK_EQUAL(clusters.size(), 1);
   BOOST_CHECK_EQUAL(clusters[0].points().size(), pc.size());
@@ -15,7 +15,7 @@ CenterOfGravity::~CenterOfGravity(){};
 /// Takes a cluster and its referencing PointCloud and creates a cluster
 /// descriptor
 std::unique_ptr<ClusterDescriptor> CenterOfGravity::
-operator()(const Cluster &cluster, const PointCloud &cloud) const {
+operator()(const Cluster &cluster, const PointCloudView &cloud) const {
   Coordinate sumX = 0, sumY = 0, sumZ = 0;
   size_t numPoints = cluster.points().size();
   // Go through each point in the cluster
@@ -17,7 +17,7 @@ public:
   /// Takes a cluster and its referencing PointCloud and creates a cluster
   /// descriptor
   virtual std::unique_ptr<ClusterDescriptor>
-  operator()(const Cluster &cluster, const PointCloud &cloud) const;
+  operator()(const Cluster &cluster, const PointCloudView &cloud) const;
 };
 
 } // namespace MouseTrack
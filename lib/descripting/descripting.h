@@ -7,7 +7,7 @@
 
 #include "generic/cluster.h"
 #include "generic/cluster_descriptor.h"
-#include "generic/point_cloud.h"
+#include "generic/point_cloud_view.h"
 #include <memory>
 #include <vector>
 
@@ -15,10 +15,10 @@ namespace MouseTrack {
 
 class Descripting {
 public:
-  /// Takes a cluster and its referencing PointCloud and creates a cluster
+  /// Takes a cluster and its referencing point cloud and creates a cluster
   /// descriptor
   virtual std::unique_ptr<ClusterDescriptor>
-  operator()(const Cluster &cluster, const PointCloud &cloud) const = 0;
+  operator()(const Cluster &cluster, const PointCloudView &cloud) const = 0;
 };
 
 } // namespace MouseTrack
@@ -15,7 +15,7 @@ namespace MouseTrack {
 class BackgroundSubtraction : public FrameWindowFiltering {
 public:
   BackgroundSubtraction();
-  virtual FrameWindow operator()(const FrameWindow &window) const;
+  virtual void filterFrame(Frame &frame, size_t stream) const;
 
   const FrameWindow &cage_frame() const;
   void cage_frame(FrameWindow &cage_frame);
@@ -10,7 +10,7 @@ namespace MouseTrack {
 /// Wrapper for OpenCV's bilateral filter
 class DisparityBilateral : public FrameWindowFiltering {
 public:
-  virtual FrameWindow operator()(const FrameWindow &window) const;
+  virtual void filterFrame(Frame &frame, size_t stream) const;
 
   int diameter() const;
   void diameter(int _new);
@@ -10,7 +10,7 @@ namespace MouseTrack {
 /// Wrapper for OpenCV's gaussian blur filter
 class DisparityGaussianBlur : public FrameWindowFiltering {
 public:
-  virtual FrameWindow operator()(const FrameWindow &window) const;
+  virtual void filterFrame(Frame &frame, size_t stream) const;
 
   /// patch diameter in x direction, kx = 0 results in a patch width of 1
   int kx() const;
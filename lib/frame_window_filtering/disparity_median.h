@@ -11,7 +11,7 @@ namespace MouseTrack {
 /// Wrapper for OpenCV's median filter
 class DisparityMedian : public FrameWindowFiltering {
 public:
-  virtual FrameWindow operator()(const FrameWindow &window) const;
+  virtual void filterFrame(Frame &frame, size_t stream) const;
 
   int diameter() const;
   void diameter(int _new);
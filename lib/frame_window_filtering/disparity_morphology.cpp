@@ -11,21 +11,16 @@
 
 namespace MouseTrack {
 
-FrameWindow DisparityMorphology::operator()(const FrameWindow &window) const {
-  FrameWindow result = window;
+void DisparityMorphology::filterFrame(Frame &f, size_t) const {
   int op = opencvOperation();
   cv::Mat kernel = getStructuringElement(
       opencvKernelShape(), cv::Size(2 * diameter() + 1, 2 * diameter() + 1),
       cv::Point(diameter(), diameter()));
-  for (size_t i = 0; i < window.frames().size(); ++i) {
-    Frame &f = result.frames()[i];
-    auto &disp = f.normalizedDisparityMap;
-    cv::Mat raw, processed;
-    cv::eigen2cv(disp, raw);
-    cv::morphologyEx(raw, processed, op, kernel);
-    cv::cv2eigen(processed, f.normalizedDisparityMap);
-  }
-  return result;
+  auto &disp = f.normalizedDisparityMap;
+  cv::Mat raw, processed;
+  cv::eigen2cv(disp, raw);
+  cv::morphologyEx(raw, processed, op, kernel);
+  cv::cv2eigen(processed, f.normalizedDisparityMap);
 }
 
 int DisparityMorphology::diameter() const { return _diameter; }
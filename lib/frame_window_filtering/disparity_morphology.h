@@ -10,7 +10,7 @@ namespace MouseTrack {
 /// Wrapper for OpenCV's morphology operations
 class DisparityMorphology : public FrameWindowFiltering {
 public:
-  virtual FrameWindow operator()(const FrameWindow &window) const;
+  virtual void filterFrame(Frame &frame, size_t stream) const;
 
   enum Morph { open, close };
 
@@ -8,10 +8,39 @@
 
 namespace MouseTrack {
 
+/// Modifies the frames of a frame window, e.g. smoothing or labeling.
+///
+/// Implementations work in place, so a chain of filters can pass one frame
+/// window along without copying the frame data. The streams of a window are
+/// filtered independently (`filterFrame`), different streams may be filtered
+/// concurrently.
 class FrameWindowFiltering {
 public:
   virtual ~FrameWindowFiltering() = default;
-  virtual FrameWindow operator()(const FrameWindow &window) const = 0;
+
+  /// Returns a filtered copy of `window`
+  FrameWindow operator()(const FrameWindow &window) const {
+    FrameWindow result = window;
+    filter(result);
+    return result;
+  }
+
+  /// Filters `window` in place and returns it, no frame data is copied
+  FrameWindow operator()(FrameWindow &&window) const {
+    filter(window);
+    return std::move(window);
+  }
+
+  /// Filters `window` in place, stream after stream
+  virtual void filter(FrameWindow &window) const {
+    for (size_t s = 0; s < window.frames().size(); ++s) {
+      filterFrame(window.frames()[s], s);
+    }
+  }
+
+  /// Filters `frame` in place, `stream` is the index of the frame inside its
+  /// frame window.
+  virtual void filterFrame(Frame &frame, size_t stream) const = 0;
 };
 
 } // namespace MouseTrack
@@ -71,22 +71,16 @@ void HogLabeling::train(const Mat &X_train, const Vec &y_train) {
   _numLabels = y_train.maxCoeff() + 1;
 }
 
-FrameWindow HogLabeling::operator()(const FrameWindow &window) const {
-  if (window.frames().empty()) {
-    return window;
-  }
+void HogLabeling::filterFrame(Frame &frame, size_t f) const {
   if (_classifier.get() == nullptr) {
     BOOST_LOG_TRIVIAL(warning)
         << "HOG classifier not trained, no labeling performed.";
-    return window;
+    return;
   }
-  FrameWindow result = window;
   // create matrices for labels
-  for (Frame &f : result.frames()) {
-    f.labels.resize(_numLabels);
-    for (auto &l : f.labels) {
-      l.setZero(f.referencePicture.rows(), f.referencePicture.cols());
-    }
+  frame.labels.resize(_numLabels);
+  for (auto &l : frame.labels) {
+    l.setZero(frame.referencePicture.rows(), frame.referencePicture.cols());
   }
 
   // hog settings
@@ -104,73 +98,69 @@ FrameWindow HogLabeling::operator()(const FrameWindow &window) const {
   cv::Size padding;
 
   // build locations for sliding window
-  const auto &first = result.frames()[0];
   std::vector<cv::Point> locations = slidingWindows(
-      first.referencePicture.cols(), first.referencePicture.rows(), _stepSize,
+      frame.referencePicture.cols(), frame.referencePicture.rows(), _stepSize,
       _windowWidth, _windowHeight);
 
   BOOST_LOG_TRIVIAL(trace) << "Created " << locations.size()
                            << " sliding window locations to check.";
 
-  for (size_t f = 0; f < result.frames().size(); ++f) {
-    BOOST_LOG_TRIVIAL(trace) << "Checking frame " << f;
-    Frame &frame = result.frames()[f];
-    cv::Mat img;
-    PictureI eig = (frame.referencePicture * 255.0).cast<PictureI::Scalar>();
-    cv::eigen2cv(eig, img);
-
-    // holds `locations.size()` descriptors of size hog.getDescriptorSize()
-    std::vector<float> descriptors;
-    hog.compute(img, descriptors, windowStride, padding, locations);
-    BOOST_LOG_TRIVIAL(trace)
-        << "Found " << (descriptors.size() / hog.getDescriptorSize())
-        << " HOG descriptors of size " << hog.getDescriptorSize() << " at "
-        << locations.size() << " locations in frame " << f;
-    Eigen::Map<Eigen::MatrixXf> map(descriptors.data(), hog.getDescriptorSize(),
-                                    locations.size());
-    Classifier::Mat tmp = map.cast<double>();
-    BOOST_LOG_TRIVIAL(trace) << "Classifying...";
-    auto labels = _classifier->predictProbabilities(tmp);
-    BOOST_LOG_TRIVIAL(trace) << "Assigning...";
-    // apply labels of windows to frame.labels
-    for (size_t w = 0; w < locations.size(); ++w) {
-      // iterate over pixels within window w
-      for (int x = locations[w].x; x < locations[w].x + _windowWidth; ++x) {
-        for (int y = locations[w].y; y < locations[w].y + _windowHeight; ++y) {
-          // distribute labels
-          for (int l = 0; l < _numLabels; ++l) {
-            frame.labels[l](y, x) += labels(l, w);
-          }
+  BOOST_LOG_TRIVIAL(trace) << "Checking frame " << f;
+  cv::Mat img;
+  PictureI eig = (frame.referencePicture * Picture::Scalar(255))
+                     .cast<PictureI::Scalar>();
+  cv::eigen2cv(eig, img);
+
+  // holds `locations.size()` descriptors of size hog.getDescriptorSize()
+  std::vector<float> descriptors;
+  hog.compute(img, descriptors, windowStride, padding, locations);
+  BOOST_LOG_TRIVIAL(trace)
+      << "Found " << (descriptors.size() / hog.getDescriptorSize())
+      << " HOG descriptors of size " << hog.getDescriptorSize() << " at "
+      << locations.size() << " locations in frame " << f;
+  Eigen::Map<Eigen::MatrixXf> map(descriptors.data(), hog.getDescriptorSize(),
+                                  locations.size());
+  Classifier::Mat tmp = map.cast<double>();
+  BOOST_LOG_TRIVIAL(trace) << "Classifying...";
+  auto labels = _classifier->predictProbabilities(tmp);
+  BOOST_LOG_TRIVIAL(trace) << "Assigning...";
+  // apply labels of windows to frame.labels
+  for (size_t w = 0; w < locations.size(); ++w) {
+    // iterate over pixels within window w
+    for (int x = locations[w].x; x < locations[w].x + _windowWidth; ++x) {
+      for (int y = locations[w].y; y < locations[w].y + _windowHeight; ++y) {
+        // distribute labels
+        for (int l = 0; l < _numLabels; ++l) {
+          frame.labels[l](y, x) += labels(l, w);
         }
       }
     }
-    // normalize label weights
-    if (_normalizeRange) {
-      for (auto &l : frame.labels) {
-        auto min = l.minCoeff();
-        l = l.array() - min;
-        auto max = l.maxCoeff();
-        l = l.array() / max;
-      }
+  }
+  // normalize label weights
+  if (_normalizeRange) {
+    for (auto &l : frame.labels) {
+      auto min = l.minCoeff();
+      l = l.array() - min;
+      auto max = l.maxCoeff();
+      l = l.array() / max;
     }
+  }
 
-    // normalize accross labels
-    if (_normalizeAccross) {
-      PictureD sum;
-      sum.setZero(frame.referencePicture.rows(), frame.referencePicture.cols());
-      for (int l = 0; l < _numLabels; ++l) {
-        sum += frame.labels[l];
-      }
-      // avoid division by zero
-      sum = sum.array() + 0.0000001;
-      sum = sum.array().inverse();
-      for (int l = 0; l < _numLabels; ++l) {
-        frame.labels[l] = frame.labels[l].array() * sum.array();
-      }
+  // normalize accross labels
+  if (_normalizeAccross) {
+    Picture sum;
+    sum.setZero(frame.referencePicture.rows(), frame.referencePicture.cols());
+    for (int l = 0; l < _numLabels; ++l) {
+      sum += frame.labels[l];
+    }
+    // avoid division by zero
+    sum = sum.array() + 0.0000001;
+    sum = sum.array().inverse();
+    for (int l = 0; l < _numLabels; ++l) {
+      frame.labels[l] = frame.labels[l].array() * sum.array();
     }
-    BOOST_LOG_TRIVIAL(trace) << "Frame " << f << " finished.";
   }
-  return result;
+  BOOST_LOG_TRIVIAL(trace) << "Frame " << f << " finished.";
 }
 
 } // namespace MouseTrack
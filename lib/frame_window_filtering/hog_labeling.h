@@ -27,7 +27,7 @@ public:
   typedef Classifier::Mat Mat;
   typedef Classifier::Vec Vec;
   void train(const Mat &X_train, const Vec &y_train);
-  virtual FrameWindow operator()(const FrameWindow &window) const;
+  virtual void filterFrame(Frame &frame, size_t stream) const;
 
   int slidingWindowWidth() const;
   void slidingWindowWidth(int _new);
@@ -0,0 +1,49 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "stream_parallel_filtering.h"
+
+#include <exception>
+
+namespace MouseTrack {
+
+StreamParallelFiltering::StreamParallelFiltering(
+    std::vector<std::unique_ptr<FrameWindowFiltering>> &&chain)
+    : _chain(std::move(chain)) {
+  // empty
+}
+
+void StreamParallelFiltering::filter(FrameWindow &window) const {
+  auto &frames = window.frames();
+  const int streams = frames.size();
+  // exceptions must not leave the parallel region, rethrow the first one
+  std::vector<std::exception_ptr> errors(streams);
+#pragma omp parallel for schedule(dynamic)
+  for (int s = 0; s < streams; ++s) {
+    try {
+      filterFrame(frames[s], s);
+    } catch (...) {
+      errors[s] = std::current_exception();
+    }
+  }
+  for (const auto &e : errors) {
+    if (e) {
+      std::rethrow_exception(e);
+    }
+  }
+}
+
+void StreamParallelFiltering::filterFrame(Frame &frame, size_t stream) const {
+  for (const auto &filter : _chain) {
+    filter->filterFrame(frame, stream);
+  }
+}
+
+const std::vector<std::unique_ptr<FrameWindowFiltering>> &
+StreamParallelFiltering::chain() const {
+  return _chain;
+}
+
+} // namespace MouseTrack
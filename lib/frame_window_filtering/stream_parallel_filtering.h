@@ -0,0 +1,37 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#pragma once
+
+#include "frame_window_filtering.h"
+
+#include <memory>
+#include <vector>
+
+namespace MouseTrack {
+
+/// Runs a chain of filters on all streams of a frame window concurrently.
+///
+/// Each stream passes through the whole chain on its own task, so the frames
+/// see exactly the same filters in the same order as with sequential
+/// execution.
+class StreamParallelFiltering : public FrameWindowFiltering {
+public:
+  StreamParallelFiltering(
+      std::vector<std::unique_ptr<FrameWindowFiltering>> &&chain);
+
+  /// Filters all streams in parallel
+  virtual void filter(FrameWindow &window) const;
+
+  /// Applies the whole chain to `frame`
+  virtual void filterFrame(Frame &frame, size_t stream) const;
+
+  const std::vector<std::unique_ptr<FrameWindowFiltering>> &chain() const;
+
+private:
+  std::vector<std::unique_ptr<FrameWindowFiltering>> _chain;
+};
+
+} // namespace MouseTrack
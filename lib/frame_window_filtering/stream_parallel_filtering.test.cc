@@ -0,0 +1,74 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "stream_parallel_filtering.h"
+
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace utf = boost::unit_test;
+
+namespace MouseTrack {
+namespace {
+
+/// focallength = factor * focallength + stream
+class AffineFilter : public FrameWindowFiltering {
+public:
+  AffineFilter(double factor) : _factor(factor) {
+    // empty
+  }
+  void filterFrame(Frame &frame, size_t stream) const {
+    if (frame.focallength < 0) {
+      throw "negative focal length";
+    }
+    frame.focallength = _factor * frame.focallength + stream;
+  }
+
+private:
+  double _factor;
+};
+
+std::vector<std::unique_ptr<FrameWindowFiltering>> affineChain() {
+  std::vector<std::unique_ptr<FrameWindowFiltering>> chain;
+  chain.emplace_back(new AffineFilter(2));
+  chain.emplace_back(new AffineFilter(3));
+  return chain;
+}
+
+FrameWindow window(int streams) {
+  std::vector<Frame> frames(streams);
+  for (int s = 0; s < streams; ++s) {
+    frames[s].focallength = 10 * s;
+  }
+  return FrameWindow(std::move(frames));
+}
+
+} // namespace
+} // namespace MouseTrack
+
+using namespace MouseTrack;
+
+BOOST_AUTO_TEST_CASE(stream_parallel_filtering_matches_sequential) {
+  FrameWindow sequential = window(8);
+  for (const auto &filter : affineChain()) {
+    sequential = (*filter)(std::move(sequential));
+  }
+
+  StreamParallelFiltering parallel(affineChain());
+  FrameWindow result = parallel(window(8));
+
+  BOOST_REQUIRE_EQUAL(result.frames().size(), 8);
+  for (size_t s = 0; s < 8; ++s) {
+    BOOST_CHECK_CLOSE(result.frames()[s].focallength,
+                      sequential.frames()[s].focallength, 0.00001);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(stream_parallel_filtering_rethrows) {
+  StreamParallelFiltering parallel(affineChain());
+  FrameWindow w = window(4);
+  w.frames()[2].focallength = -1;
+  BOOST_CHECK_THROW(parallel.filter(w), const char *);
+}
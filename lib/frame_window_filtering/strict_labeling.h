@@ -15,7 +15,7 @@ namespace MouseTrack {
 /// For each pixel, it sets one label to 1 and all others to 0
 class StrictLabeling : public FrameWindowFiltering {
 public:
-  virtual FrameWindow operator()(const FrameWindow &window) const;
+  virtual void filterFrame(Frame &frame, size_t stream) const;
 
 private:
   /// labels that should not be considered for classification, they won't get a
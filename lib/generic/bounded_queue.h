@@ -0,0 +1,89 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace MouseTrack {
+
+/// Thread safe FIFO queue with a fixed capacity.
+///
+/// Producers block in `push` as long as the queue is full, consumers block in
+/// `pop` as long as the queue is empty. After `close()` was called, `push`
+/// rejects new elements and `pop` drains the remaining elements before it
+/// reports the end of the stream.
+template <typename T> class BoundedQueue {
+public:
+  /// A capacity of 0 is treated as 1.
+  BoundedQueue(size_t capacity) : _capacity(capacity == 0 ? 1 : capacity) {
+    // empty
+  }
+
+  /// Appends `value`, blocks while the queue is full.
+  /// Returns false if the queue was closed, `value` is dropped in this case.
+  bool push(T value) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notFull.wait(lock,
+                  [this]() { return _closed || _queue.size() < _capacity; });
+    if (_closed) {
+      return false;
+    }
+    _queue.push_back(std::move(value));
+    lock.unlock();
+    _notEmpty.notify_one();
+    return true;
+  }
+
+  /// Removes the oldest element and moves it into `value`, blocks while the
+  /// queue is empty.
+  /// Returns false if the queue is closed and no elements are left.
+  bool pop(T &value) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [this]() { return _closed || !_queue.empty(); });
+    if (_queue.empty()) {
+      return false;
+    }
+    value = std::move(_queue.front());
+    _queue.pop_front();
+    lock.unlock();
+    _notFull.notify_one();
+    return true;
+  }
+
+  /// Signals the end of the stream, wakes up all waiting threads.
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _closed = true;
+    }
+    _notFull.notify_all();
+    _notEmpty.notify_all();
+  }
+
+  bool closed() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _closed;
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _queue.size();
+  }
+
+  size_t capacity() const { return _capacity; }
+
+private:
+  const size_t _capacity;
+  bool _closed = false;
+  std::deque<T> _queue;
+  mutable std::mutex _mutex;
+  std::condition_variable _notFull;
+  std::condition_variable _notEmpty;
+};
+
+} // namespace MouseTrack
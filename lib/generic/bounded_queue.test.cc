@@ -0,0 +1,64 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "bounded_queue.h"
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace utf = boost::unit_test;
+
+using namespace MouseTrack;
+
+BOOST_AUTO_TEST_CASE(bounded_queue_fifo_order) {
+  BoundedQueue<int> queue(3);
+  constexpr int N = 1000;
+
+  std::thread producer([&queue]() {
+    for (int i = 0; i < N; ++i) {
+      queue.push(i);
+    }
+    queue.close();
+  });
+
+  std::vector<int> received;
+  int value;
+  while (queue.pop(value)) {
+    BOOST_CHECK(queue.size() <= queue.capacity());
+    received.push_back(value);
+  }
+  producer.join();
+
+  BOOST_CHECK_EQUAL(received.size(), N);
+  for (int i = 0; i < (int)received.size(); ++i) {
+    BOOST_CHECK_EQUAL(received[i], i);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(bounded_queue_close_drains) {
+  BoundedQueue<int> queue(2);
+  BOOST_CHECK(queue.push(1));
+  BOOST_CHECK(queue.push(2));
+  queue.close();
+  BOOST_CHECK(!queue.push(3));
+
+  int value = 0;
+  BOOST_CHECK(queue.pop(value));
+  BOOST_CHECK_EQUAL(value, 1);
+  BOOST_CHECK(queue.pop(value));
+  BOOST_CHECK_EQUAL(value, 2);
+  BOOST_CHECK(!queue.pop(value));
+}
+
+BOOST_AUTO_TEST_CASE(bounded_queue_close_wakes_producer) {
+  BoundedQueue<int> queue(1);
+  queue.push(1);
+  bool accepted = true;
+  std::thread producer([&]() { accepted = queue.push(2); });
+  queue.close();
+  producer.join();
+  BOOST_CHECK(!accepted);
+}
@@ -23,16 +23,12 @@ Cluster::Cluster(std::vector<PointIndex> &&points)
 std::vector<PointIndex> &Cluster::points() { return _points; }
 const std::vector<PointIndex> &Cluster::points() const { return _points; }
 
-Eigen::VectorXd Cluster::center_of_gravity(const PointCloud &cloud) const {
-  Eigen::VectorXd cog;
-  cog.setZero(cloud.charDim());
-  for (size_t i = 0; i < points().size(); i++) {
-    cog += cloud[points()[i]].characteristic();
+Eigen::VectorXd
+Cluster::center_of_gravity(const PointCloudView &cloud) const {
+  if (points().empty()) {
+    return Eigen::VectorXd::Zero(cloud.charDim());
   }
-  if (points().size() > 0) {
-    cog /= points().size();
-  }
-  return cog;
+  return cloud.characteristics(points()).cast<double>().rowwise().mean();
 }
 
 } // namespace MouseTrack
@@ -6,7 +6,7 @@
 #pragma once
 
 #include "Eigen/Core"
-#include "point_cloud.h"
+#include "point_cloud_view.h"
 #include "types.h"
 #include <vector>
 
@@ -33,7 +33,7 @@ public:
   const std::vector<PointIndex> &points() const;
 
   /// Get center of gravity
-  Eigen::VectorXd center_of_gravity(const PointCloud &cloud) const;
+  Eigen::VectorXd center_of_gravity(const PointCloudView &cloud) const;
 
 private:
   std::vector<PointIndex> _points;
@@ -11,6 +11,6 @@
 
 namespace MouseTrack {
 
-typedef PictureD DisparityMap;
+typedef Picture DisparityMap;
 
 } // namespace MouseTrack
@@ -8,6 +8,7 @@
 #include "generic/disparity_map.h"
 #include "generic/types.h"
 #include <Eigen/Core>
+#include <vector>
 
 namespace MouseTrack {
 
@@ -15,8 +16,8 @@ namespace MouseTrack {
 struct Frame {
   DisparityMap normalizedDisparityMap;
   DisparityMap rawDisparityMap;
-  PictureD referencePicture;
-  std::vector<PictureD> labels;
+  Picture referencePicture;
+  std::vector<Picture> labels;
   Precision focallength;
   Precision baseline;
   Precision ccx;
@@ -5,210 +5,394 @@
 
 #include "point_cloud.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace MouseTrack {
 
 // PointCloud implementation
 
-PointCloud::PointCloud() {
+template <typename Scalar> PointCloudT<Scalar>::PointCloudT() {
   // empty
 }
 
-void PointCloud::resize(size_t n, size_t labelsCount) {
+template <typename Scalar>
+void PointCloudT<Scalar>::resize(size_t n, size_t labelsCount) {
+  changed();
   _pos.conservativeResize(POS_DIM, n);
   _col.conservativeResize(COL_DIM, n);
   _labels.conservativeResize(labelsCount, n);
 }
 
-size_t PointCloud::size() const { return _pos.cols(); }
+template <typename Scalar>
+size_t PointCloudT<Scalar>::size() const { return _pos.cols(); }
 
-PointCloud::Point PointCloud::operator[](size_t i) {
-  return PointCloud::Point(*this, i);
+template <typename Scalar>
+typename PointCloudT<Scalar>::Point PointCloudT<Scalar>::operator[](size_t i) {
+  return Point(*this, i);
 }
 
-const PointCloud::ConstantPoint PointCloud::operator[](size_t i) const {
-  return PointCloud::ConstantPoint(*this, i);
+template <typename Scalar>
+const typename PointCloudT<Scalar>::ConstantPoint
+PointCloudT<Scalar>::operator[](size_t i) const {
+  return ConstantPoint(*this, i);
 }
 
-int PointCloud::labelsDim() const { return _labels.rows(); }
+template <typename Scalar>
+int PointCloudT<Scalar>::labelsDim() const { return _labels.rows(); }
 
-int PointCloud::charDim() const {
+template <typename Scalar>
+int PointCloudT<Scalar>::charDim() const {
   // position: 3
   // intensity: 1
   // labels: labelsDim()
   return POS_DIM + 1 + labelsDim();
 }
 
-Eigen::Vector3d PointCloud::posMin() const {
-  Eigen::Vector3d min;
-  min.setConstant(POS_DIM, std::numeric_limits<double>::max());
+template <typename Scalar>
+typename PointCloudT<Scalar>::PosVec PointCloudT<Scalar>::posMin() const {
+  return statistics().min.template head<POS_DIM>();
+}
+
+template <typename Scalar>
+typename PointCloudT<Scalar>::PosVec PointCloudT<Scalar>::posMax() const {
+  return statistics().max.template head<POS_DIM>();
+}
 
-  for (PointIndex i = 0; i < size(); i += 1) {
-    const auto &p = (*this)[i];
-    min = min.array().min(p.pos().array());
+template <typename Scalar>
+typename PointCloudT<Scalar>::PosVec PointCloudT<Scalar>::posCog() const {
+  const Statistics stats = statistics();
+  if (stats.count == 0) {
+    return PosVec::Zero();
   }
-  return min;
+  return stats.mean().template head<POS_DIM>().template cast<Scalar>();
+}
+
+template <typename Scalar>
+typename PointCloudT<Scalar>::CharMatrix
+PointCloudT<Scalar>::characteristics() const {
+  CharMatrix result(charDim(), size());
+  result.template topRows<POS_DIM>() = _pos;
+  result.row(POS_DIM) =
+      ((_col.row(R) + _col.row(G) + _col.row(B)) / ColorChannel(3))
+          .template cast<Scalar>();
+  result.bottomRows(labelsDim()) = _labels;
+  return result;
 }
 
-Eigen::Vector3d PointCloud::posMax() const {
-  Eigen::Vector3d max;
-  max.setConstant(POS_DIM, std::numeric_limits<double>::min());
+template <typename Scalar>
+typename PointCloudT<Scalar>::CharMatrix PointCloudT<Scalar>::characteristics(
+    const std::vector<PointIndex> &indices) const {
+  CharMatrix result(charDim(), indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    const PointIndex j = indices[i];
+    result.template block<POS_DIM, 1>(0, i) = _pos.col(j);
+    result(POS_DIM, i) =
+        (_col(R, j) + _col(G, j) + _col(B, j)) / ColorChannel(3);
+    result.col(i).tail(labelsDim()) = _labels.col(j);
+  }
+  return result;
+}
 
-  for (PointIndex i = 0; i < size(); i += 1) {
-    const auto &p = (*this)[i];
-    max = max.array().max(p.pos().array());
+template <typename Scalar>
+typename PointCloudT<Scalar>::CharVec PointCloudT<Scalar>::charMin() const {
+  return statistics().min;
+}
+
+template <typename Scalar>
+typename PointCloudT<Scalar>::CharVec PointCloudT<Scalar>::charMax() const {
+  return statistics().max;
+}
+
+template <typename Scalar>
+typename PointCloudT<Scalar>::Statistics
+PointCloudT<Scalar>::statistics() const {
+  std::shared_ptr<const Statistics> stats = std::atomic_load(&_statistics);
+  if (stats == nullptr) {
+    // concurrent callers might compute it twice, but get the same result
+    stats = std::make_shared<const Statistics>(computeStatistics());
+    std::atomic_store(&_statistics, stats);
+  }
+  return *stats;
+}
+
+template <typename Scalar>
+typename PointCloudT<Scalar>::Statistics
+PointCloudT<Scalar>::computeStatistics() const {
+  Statistics stats(charDim());
+  stats.count = size();
+
+  // reduce a block of columns at a time: the block stays in cache for all
+  // four reductions and the partial sums stay accurate in float
+  const int blockSize = 1024;
+  Eigen::Matrix<Scalar, 1, Eigen::Dynamic> intensity(blockSize);
+  for (size_t first = 0; first < size(); first += blockSize) {
+    const int n = std::min<size_t>(blockSize, size() - first);
+    stats.accumulate(_pos.middleCols(first, n), 0);
+    const auto col = _col.middleCols(first, n);
+    intensity.head(n) =
+        ((col.row(R) + col.row(G) + col.row(B)) / ColorChannel(3))
+            .template cast<Scalar>();
+    stats.accumulate(intensity.head(n), POS_DIM);
+    if (labelsDim() > 0) {
+      stats.accumulate(_labels.middleCols(first, n), POS_DIM + 1);
+    }
   }
-  return max;
+  return stats;
+}
+
+template <typename Scalar>
+PointCloudT<Scalar>::Statistics::Statistics(int dims) : count(0) {
+  min.setConstant(dims, std::numeric_limits<Scalar>::max());
+  max.setConstant(dims, std::numeric_limits<Scalar>::lowest());
+  sum.setZero(dims);
+  sumSq.setZero(dims);
+}
+
+template <typename Scalar>
+Eigen::VectorXd PointCloudT<Scalar>::Statistics::mean() const {
+  return sum / count;
+}
+
+template <typename Scalar>
+Eigen::VectorXd PointCloudT<Scalar>::Statistics::variance() const {
+  Eigen::VectorXd m = mean();
+  return sumSq / count - m.cwiseProduct(m);
+}
+
+template <typename Scalar> void PointCloudT<Scalar>::changed() {
+  _statistics.reset();
 }
 
-PointCloud::PosVec PointCloud::posCog() const {
-  PosVec posCog = _pos.rowwise().sum();
+template <typename Scalar>
+void PointCloudT<Scalar>::setPos(size_t first, size_t n, const Scalar *data) {
+  changed();
+  _pos.middleCols(first, n) = Eigen::Map<const PosMatrix>(data, POS_DIM, n);
+}
+
+template <typename Scalar>
+void PointCloudT<Scalar>::setIntensity(size_t first, size_t n,
+                                       const ColorChannel *data) {
+  changed();
+  Eigen::Map<const Eigen::Matrix<ColorChannel, 1, -1>> intensities(data, n);
+  _col.middleCols(first, n) = intensities.replicate<COL_DIM, 1>();
+}
+
+template <typename Scalar>
+void PointCloudT<Scalar>::setLabels(size_t first, size_t n, const Label *data) {
+  changed();
+  _labels.middleCols(first, n) =
+      Eigen::Map<const LabelMatrix>(data, labelsDim(), n);
+}
+
+template <typename Scalar>
+PointCloudT<Scalar>
+PointCloudT<Scalar>::gather(const std::vector<PointIndex> &indices) const {
+  PointCloudT result;
+  result.resize(indices.size(), labelsDim());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    const PointIndex j = indices[i];
+    result._pos.col(i) = _pos.col(j);
+    result._col.col(i) = _col.col(j);
+    result._labels.col(i) = _labels.col(j);
+  }
+  return result;
+}
+
+template <typename Scalar>
+void PointCloudT<Scalar>::append(const PointCloudT &other) {
   if (size() == 0) {
-    return posCog;
+    *this = other;
+    return;
   }
-  posCog /= size();
-  return posCog;
+  if (labelsDim() != other.labelsDim()) {
+    throw "Can't append point cloud with different number of labels.";
+  }
+  const size_t first = size();
+  resize(first + other.size(), labelsDim());
+  _pos.rightCols(other.size()) = other._pos;
+  _col.rightCols(other.size()) = other._col;
+  _labels.rightCols(other.size()) = other._labels;
 }
 
-Eigen::VectorXd PointCloud::charMin() const {
-  Eigen::VectorXd min;
-  min.setConstant(charDim(), std::numeric_limits<double>::max());
+template <typename Scalar>
+typename PointCloudT<Scalar>::PosMatrix &PointCloudT<Scalar>::posData() {
+  changed();
+  return _pos;
+}
 
-  for (PointIndex i = 0; i < size(); i += 1) {
-    const auto &p = (*this)[i];
-    min = min.array().min(p.characteristic().array());
-  }
-  return min;
+template <typename Scalar>
+const typename PointCloudT<Scalar>::PosMatrix &
+PointCloudT<Scalar>::posData() const {
+  return _pos;
 }
 
-Eigen::VectorXd PointCloud::charMax() const {
-  Eigen::VectorXd max;
-  max.setConstant(charDim(), std::numeric_limits<double>::min());
+template <typename Scalar>
+typename PointCloudT<Scalar>::ColMatrix &PointCloudT<Scalar>::colData() {
+  changed();
+  return _col;
+}
 
-  for (PointIndex i = 0; i < size(); i += 1) {
-    const auto &p = (*this)[i];
-    max = max.array().max(p.pos().array());
-  }
-  return max;
+template <typename Scalar>
+const typename PointCloudT<Scalar>::ColMatrix &
+PointCloudT<Scalar>::colData() const {
+  return _col;
+}
+
+template <typename Scalar>
+typename PointCloudT<Scalar>::LabelMatrix &PointCloudT<Scalar>::labelData() {
+  changed();
+  return _labels;
+}
+
+template <typename Scalar>
+const typename PointCloudT<Scalar>::LabelMatrix &
+PointCloudT<Scalar>::labelData() const {
+  return _labels;
 }
 
 // Point implementation
 
-PointCloud::Point::Point(PointCloud &cloud, size_t i)
+template <typename Scalar>
+PointCloudT<Scalar>::Point::Point(PointCloudT &cloud, size_t i)
     : ConstantPoint(cloud, i) {
   // empty
 }
 
-void PointCloud::Point::x(const Coordinate &_new) {
-  cloud()._pos(X, index()) = _new;
+template <typename Scalar>
+void PointCloudT<Scalar>::Point::x(const Scalar &_new) {
+  this->cloud()._pos(X, this->index()) = _new;
 }
 
-void PointCloud::Point::y(const Coordinate &_new) {
-  cloud()._pos(Y, index()) = _new;
+template <typename Scalar>
+void PointCloudT<Scalar>::Point::y(const Scalar &_new) {
+  this->cloud()._pos(Y, this->index()) = _new;
 }
 
-void PointCloud::Point::z(const Coordinate &_new) {
-  cloud()._pos(Z, index()) = _new;
+template <typename Scalar>
+void PointCloudT<Scalar>::Point::z(const Scalar &_new) {
+  this->cloud()._pos(Z, this->index()) = _new;
 }
 
-void PointCloud::Point::r(const ColorChannel &_new) {
-  cloud()._col(R, index()) = _new;
+template <typename Scalar>
+void PointCloudT<Scalar>::Point::r(const ColorChannel &_new) {
+  this->cloud()._col(R, this->index()) = _new;
 }
 
-void PointCloud::Point::g(const ColorChannel &_new) {
-  cloud()._col(G, index()) = _new;
+template <typename Scalar>
+void PointCloudT<Scalar>::Point::g(const ColorChannel &_new) {
+  this->cloud()._col(G, this->index()) = _new;
 }
 
-void PointCloud::Point::b(const ColorChannel &_new) {
-  cloud()._col(B, index()) = _new;
+template <typename Scalar>
+void PointCloudT<Scalar>::Point::b(const ColorChannel &_new) {
+  this->cloud()._col(B, this->index()) = _new;
 }
 
-void PointCloud::Point::intensity(const ColorChannel &_new) {
-  cloud()._col(R, index()) = _new;
-  cloud()._col(G, index()) = _new;
-  cloud()._col(B, index()) = _new;
+template <typename Scalar>
+void PointCloudT<Scalar>::Point::intensity(const ColorChannel &_new) {
+  this->cloud()._col(R, this->index()) = _new;
+  this->cloud()._col(G, this->index()) = _new;
+  this->cloud()._col(B, this->index()) = _new;
 }
 
-void PointCloud::Point::labels(const PointCloud::LabelVec &newLabels) {
-  cloud()._labels.col(index()) = newLabels;
+template <typename Scalar>
+void PointCloudT<Scalar>::Point::labels(const LabelVec &newLabels) {
+  this->cloud()._labels.col(this->index()) = newLabels;
 }
 
-void PointCloud::Point::labels(PointCloud::LabelVec &&newLabels) {
-  cloud()._labels.col(index()) = std::move(newLabels);
+template <typename Scalar>
+void PointCloudT<Scalar>::Point::labels(LabelVec &&newLabels) {
+  this->cloud()._labels.col(this->index()) = std::move(newLabels);
 }
 
-void PointCloud::Point::operator=(const Point &o) {
-  x(o.x());
-  y(o.y());
-  z(o.z());
-  r(o.r());
-  g(o.g());
-  b(o.b());
-  labels(o.labels());
+template <typename Scalar>
+void PointCloudT<Scalar>::Point::operator=(const Point &o) {
+  *this = static_cast<const ConstantPoint &>(o);
 }
 
-void PointCloud::Point::operator=(const ConstantPoint &o) {
-  x(o.x());
-  y(o.y());
-  z(o.z());
-  r(o.r());
-  g(o.g());
-  b(o.b());
-  labels(o.labels());
+template <typename Scalar>
+void PointCloudT<Scalar>::Point::operator=(const ConstantPoint &o) {
+  // copy whole columns instead of going through the accessors
+  this->cloud()._pos.col(this->index()) = o.constCloud()._pos.col(o.index());
+  this->cloud()._col.col(this->index()) = o.constCloud()._col.col(o.index());
+  this->cloud()._labels.col(this->index()) =
+      o.constCloud()._labels.col(o.index());
 }
 
 // ConstantPoint implementation
 
-PointCloud::ConstantPoint::ConstantPoint(const PointCloud &cloud, size_t i)
+template <typename Scalar>
+PointCloudT<Scalar>::ConstantPoint::ConstantPoint(const PointCloudT &cloud,
+                                                  size_t i)
     : _cloud(cloud), _index(i) {
   // empty
 }
 
 // a little hack to provide write-access for `Point`
-PointCloud &PointCloud::ConstantPoint::cloud() const {
-  return const_cast<PointCloud &>(_cloud);
+template <typename Scalar>
+PointCloudT<Scalar> &PointCloudT<Scalar>::ConstantPoint::cloud() const {
+  // only used for writing
+  PointCloudT &cloud = const_cast<PointCloudT &>(_cloud);
+  cloud.changed();
+  return cloud;
 }
 
-const PointCloud &PointCloud::ConstantPoint::constCloud() const {
+template <typename Scalar>
+const PointCloudT<Scalar> &
+PointCloudT<Scalar>::ConstantPoint::constCloud() const {
   return _cloud;
 }
-size_t PointCloud::ConstantPoint::index() const { return _index; }
+template <typename Scalar>
+size_t PointCloudT<Scalar>::ConstantPoint::index() const { return _index; }
 
-const Coordinate &PointCloud::ConstantPoint::x() const {
+template <typename Scalar>
+const Scalar &PointCloudT<Scalar>::ConstantPoint::x() const {
   return constCloud()._pos(X, index());
 }
 
-const Coordinate &PointCloud::ConstantPoint::y() const {
+template <typename Scalar>
+const Scalar &PointCloudT<Scalar>::ConstantPoint::y() const {
   return constCloud()._pos(Y, index());
 }
 
-const Coordinate &PointCloud::ConstantPoint::z() const {
+template <typename Scalar>
+const Scalar &PointCloudT<Scalar>::ConstantPoint::z() const {
   return constCloud()._pos(Z, index());
 }
 
-const ColorChannel &PointCloud::ConstantPoint::r() const {
+template <typename Scalar>
+const ColorChannel &PointCloudT<Scalar>::ConstantPoint::r() const {
   return constCloud()._col(R, index());
 }
 
-const ColorChannel &PointCloud::ConstantPoint::g() const {
+template <typename Scalar>
+const ColorChannel &PointCloudT<Scalar>::ConstantPoint::g() const {
   return constCloud()._col(G, index());
 }
 
-const ColorChannel &PointCloud::ConstantPoint::b() const {
+template <typename Scalar>
+const ColorChannel &PointCloudT<Scalar>::ConstantPoint::b() const {
   return constCloud()._col(B, index());
 }
 
-ColorChannel PointCloud::ConstantPoint::intensity() const {
-  return (constCloud()._col(R, index()) + cloud()._col(G, index()) +
-          cloud()._col(B, index())) /
+template <typename Scalar>
+ColorChannel PointCloudT<Scalar>::ConstantPoint::intensity() const {
+  return (constCloud()._col(R, index()) + constCloud()._col(G, index()) +
+          constCloud()._col(B, index())) /
          3.0;
 }
 
-PointCloud::LabelVecConstOut PointCloud::ConstantPoint::labels() const {
+template <typename Scalar>
+typename PointCloudT<Scalar>::LabelVecConstOut
+PointCloudT<Scalar>::ConstantPoint::labels() const {
   return constCloud()._labels.col(_index);
 }
 
-Eigen::VectorXd PointCloud::ConstantPoint::characteristic() const {
-  Eigen::VectorXd result(constCloud().charDim());
+template <typename Scalar>
+typename PointCloudT<Scalar>::CharVec
+PointCloudT<Scalar>::ConstantPoint::characteristic() const {
+  CharVec result(constCloud().charDim());
   result[0] = x();
   result[1] = y();
   result[2] = z();
@@ -217,8 +401,13 @@ Eigen::VectorXd PointCloud::ConstantPoint::characteristic() const {
   return result;
 }
 
-PointCloud::PosVecConstOut PointCloud::ConstantPoint::pos() const {
+template <typename Scalar>
+typename PointCloudT<Scalar>::PosVecConstOut
+PointCloudT<Scalar>::ConstantPoint::pos() const {
   return constCloud()._pos.col(index());
 }
 
+template class PointCloudT<float>;
+template class PointCloudT<double>;
+
 } // namespace MouseTrack
@@ -9,13 +9,20 @@
 
 #include <Eigen/Core>
 #include <cstddef>
+#include <memory>
 #include <vector>
 
 namespace MouseTrack {
 
 /// A point cloud holds a list of 3D points. Each point can have additional
 /// attributes like color intensity.
-class PointCloud {
+///
+/// `Scalar` is the precision of positions and labels, use the `PointCloud`
+/// typedef unless you need a specific precision.
+template <typename _Scalar> class PointCloudT {
+public:
+  typedef _Scalar Scalar;
+
   // Design note: In general, one has to decide betwen two basic concepts:
   // - Structure of Arrays
   // - Array of Structures
@@ -30,8 +37,8 @@ private:
   static constexpr int Z = 2;
   static constexpr int POS_DIM = 3;
   static constexpr int R = 0;
-  static constexpr int G = 0;
-  static constexpr int B = 0;
+  static constexpr int G = 1;
+  static constexpr int B = 2;
   static constexpr int COL_DIM = 3;
 
 public:
@@ -42,17 +49,60 @@ public:
   /// 1 means "very much this label"
   ///
   /// Values inbetween show insecurity
-  typedef double Label;
+  typedef Scalar Label;
   typedef Eigen::Matrix<Label, -1, 1> LabelVec;
-  typedef Eigen::Block<Eigen::MatrixXd, -1, 1, true> LabelVecOut;
-  typedef Eigen::Block<const Eigen::MatrixXd, -1, 1, true> LabelVecConstOut;
-  typedef Eigen::Matrix<Coordinate, POS_DIM, 1> PosVec;
-  typedef Eigen::Block<const Eigen::Matrix<Coordinate, POS_DIM, -1>, POS_DIM, 1,
+  /// Storage of all labels, column i holds point i
+  typedef Eigen::Matrix<Label, -1, -1> LabelMatrix;
+  typedef Eigen::Block<LabelMatrix, -1, 1, true> LabelVecOut;
+  typedef Eigen::Block<const LabelMatrix, -1, 1, true> LabelVecConstOut;
+  /// All characteristic values of a point
+  typedef Eigen::Matrix<Scalar, -1, 1> CharVec;
+  /// Characteristic values of many points, column i holds point i
+  typedef Eigen::Matrix<Scalar, -1, -1> CharMatrix;
+  typedef Eigen::Matrix<Scalar, POS_DIM, 1> PosVec;
+  /// Storage of all positions, column i holds point i
+  typedef Eigen::Matrix<Scalar, POS_DIM, -1> PosMatrix;
+  /// Storage of all colors, column i holds point i
+  typedef Eigen::Matrix<ColorChannel, COL_DIM, -1> ColMatrix;
+  typedef Eigen::Block<const Eigen::Matrix<Scalar, POS_DIM, -1>, POS_DIM, 1,
                        true>
       PosVecConstOut;
   class Point;
   class ConstantPoint;
 
+  /// Reductions over all points per characteristic dimension, rows are
+  /// ordered like `characteristic()`.
+  struct Statistics {
+    /// Statistics of zero points over `dims` dimensions
+    Statistics(int dims = 0);
+
+    size_t count;
+    CharVec min;
+    CharVec max;
+    /// accumulated in double to keep `variance()` meaningful for float clouds
+    Eigen::VectorXd sum;
+    Eigen::VectorXd sumSq;
+
+    Eigen::VectorXd mean() const;
+    /// population variance
+    Eigen::VectorXd variance() const;
+
+    /// Adds the points in the columns of `block` to the dimensions starting
+    /// at `firstRow`. `count` is left to the caller.
+    template <typename Block>
+    void accumulate(const Block &block, int firstRow) {
+      const int rows = block.rows();
+      auto blockMin = min.segment(firstRow, rows);
+      auto blockMax = max.segment(firstRow, rows);
+      blockMin = blockMin.cwiseMin(block.rowwise().minCoeff());
+      blockMax = blockMax.cwiseMax(block.rowwise().maxCoeff());
+      sum.segment(firstRow, rows) +=
+          block.rowwise().sum().template cast<double>();
+      sumSq.segment(firstRow, rows) +=
+          block.rowwise().squaredNorm().template cast<double>();
+    }
+  };
+
   /// Exactly the same as `Point` but it only provides read-only access to the
   /// data.
   class ConstantPoint {
@@ -105,28 +155,28 @@ public:
     ///
     /// This definitely breaks the one or other OO-principle, but I haven't
     /// found a cleaner way to get rid of all unnecessary overhead.
-    friend class PointCloud;
+    friend class PointCloudT;
 
   private:
-    ConstantPoint(const PointCloud &cloud, size_t i);
+    ConstantPoint(const PointCloudT &cloud, size_t i);
 
-    const PointCloud &_cloud;
+    const PointCloudT &_cloud;
     size_t _index;
 
   protected:
-    PointCloud &cloud() const;
-    const PointCloud &constCloud() const;
+    PointCloudT &cloud() const;
+    const PointCloudT &constCloud() const;
     size_t index() const;
 
   public:
     /// Read access to x coordinate.
-    const Coordinate &x() const;
+    const Scalar &x() const;
 
     /// Read access to y coordinate.
-    const Coordinate &y() const;
+    const Scalar &y() const;
 
     /// Read access to z coordinate.
-    const Coordinate &z() const;
+    const Scalar &z() const;
 
     /// Read access to color r.
     const ColorChannel &r() const;
@@ -144,7 +194,7 @@ public:
     LabelVecConstOut labels() const;
 
     /// Convert to dx1 Eigen Vector holding all characteristic values
-    Eigen::VectorXd characteristic() const;
+    CharVec characteristic() const;
 
     /// Position as eigen column vector
     PosVecConstOut pos() const;
@@ -157,10 +207,10 @@ public:
     // Design note: I tend to keep the hierarchy flat,
     // this way we can implement it by storing a reference to the PointCloud
     // and an index, and nothing more.
-    friend class PointCloud;
+    friend class PointCloudT;
 
     /// Create a Point instance that manipulates the i-th point of cloud
-    Point(PointCloud &cloud, size_t i);
+    Point(PointCloudT &cloud, size_t i);
 
   public:
     // clang-format off
@@ -175,13 +225,13 @@ public:
     // clang-format on
 
     /// Write access to x coordinate.
-    void x(const Coordinate &_new);
+    void x(const Scalar &_new);
 
     /// Write access to y coordinate.
-    void y(const Coordinate &_new);
+    void y(const Scalar &_new);
 
     /// Write access to z coordinate.
-    void z(const Coordinate &_new);
+    void z(const Scalar &_new);
 
     /// Write access to color r.
     void r(const ColorChannel &_new);
@@ -213,7 +263,7 @@ public:
     void operator=(const ConstantPoint &other);
   };
 
-  PointCloud();
+  PointCloudT();
 
   /// Make space to accomodate n points and `labelsCount` labels for each point.
   void resize(size_t n, size_t labelsCount);
@@ -233,11 +283,27 @@ public:
   /// How many characteristic dimensions are there?
   int charDim() const;
 
+  /// Characteristic vectors of all points in a single pass, column i holds
+  /// `(*this)[i].characteristic()`.
+  CharMatrix characteristics() const;
+
+  /// Characteristic vectors of the points at `indices` in the same order.
+  CharMatrix characteristics(const std::vector<PointIndex> &indices) const;
+
+  /// min, max, sum and sum of squares of all characteristic dimensions,
+  /// computed in a single pass over the storage.
+  ///
+  /// The result is cached until the cloud changes through a non-const member
+  /// or a `Point`. References obtained from `posData()`, `colData()` or
+  /// `labelData()` must not be written to after calling this method.
+  /// Concurrent calls on an unchanged cloud are safe.
+  Statistics statistics() const;
+
   /// min corner of bounding box (all characteristic dimensions)
-  Eigen::VectorXd charMin() const;
+  CharVec charMin() const;
 
   /// max corner of bounding box (all characteristic dimensions)
-  Eigen::VectorXd charMax() const;
+  CharVec charMax() const;
 
   /// min corner of bounding box (only 3d position of points)
   PosVec posMin() const;
@@ -248,10 +314,62 @@ public:
   /// Center of gravity/centroid of point cloud
   PosVec posCog() const;
 
+  /// Copies the positions of `n` points starting at point `first`.
+  ///
+  /// `data` holds x, y, z of the first point, followed by x, y, z of the
+  /// second point and so on.
+  void setPos(size_t first, size_t n, const Scalar *data);
+
+  /// Sets the color of `n` points starting at point `first` to the
+  /// intensities in `data`.
+  void setIntensity(size_t first, size_t n, const ColorChannel *data);
+
+  /// Copies the labels of `n` points starting at point `first`.
+  ///
+  /// `data` holds `labelsDim()` labels of the first point, followed by the
+  /// labels of the second point and so on.
+  void setLabels(size_t first, size_t n, const Label *data);
+
+  /// Returns a new cloud holding the points at `indices` in the same order.
+  PointCloudT gather(const std::vector<PointIndex> &indices) const;
+
+  /// Appends all points of `other`.
+  ///
+  /// Both clouds need the same number of labels, unless this one is empty.
+  void append(const PointCloudT &other);
+
+  /// Direct access to the position storage for bulk operations.
+  /// Don't change its size, use `resize` instead.
+  PosMatrix &posData();
+  const PosMatrix &posData() const;
+
+  /// Direct access to the color storage for bulk operations.
+  /// Don't change its size, use `resize` instead.
+  ColMatrix &colData();
+  const ColMatrix &colData() const;
+
+  /// Direct access to the label storage for bulk operations.
+  /// Don't change its size, use `resize` instead.
+  LabelMatrix &labelData();
+  const LabelMatrix &labelData() const;
+
 private:
-  Eigen::Matrix<Coordinate, POS_DIM, -1> _pos;
-  Eigen::Matrix<ColorChannel, COL_DIM, -1> _col;
-  Eigen::Matrix<Label, -1, -1> _labels;
+  PosMatrix _pos;
+  ColMatrix _col;
+  LabelMatrix _labels;
+  /// cache of `statistics()`, empty if outdated
+  mutable std::shared_ptr<const Statistics> _statistics;
+
+  /// Drops cached values, call on every change
+  void changed();
+
+  Statistics computeStatistics() const;
 };
 
+/// Default precision, see `Coordinate`
+typedef PointCloudT<Coordinate> PointCloud;
+
+typedef PointCloudT<float> PointCloudF;
+typedef PointCloudT<double> PointCloudD;
+
 } // namespace MouseTrack
@@ -25,3 +25,132 @@ BOOST_AUTO_TEST_CASE(point_cloud_read_write) {
   BOOST_CHECK_CLOSE(3.0, point.z(), .00001);
   BOOST_CHECK_CLOSE(4.0, point.intensity(), .00001);
 }
+
+BOOST_AUTO_TEST_CASE(point_cloud_bulk_set) {
+  MouseTrack::PointCloud pc;
+  pc.resize(4, 2);
+  const MouseTrack::Coordinate pos[] = {1, 2, 3, 4, 5, 6};
+  const MouseTrack::ColorChannel intensities[] = {0.25, 0.5};
+  const MouseTrack::PointCloud::Label labels[] = {0.1, 0.9, 0.7, 0.3};
+  pc.setPos(1, 2, pos);
+  pc.setIntensity(1, 2, intensities);
+  pc.setLabels(2, 2, labels);
+
+  BOOST_CHECK_CLOSE(1.0, pc[1].x(), .00001);
+  BOOST_CHECK_CLOSE(3.0, pc[1].z(), .00001);
+  BOOST_CHECK_CLOSE(4.0, pc[2].x(), .00001);
+  BOOST_CHECK_CLOSE(6.0, pc[2].z(), .00001);
+  BOOST_CHECK_CLOSE(0.25, pc[1].intensity(), .00001);
+  BOOST_CHECK_CLOSE(0.5, pc[2].intensity(), .00001);
+  BOOST_CHECK_CLOSE(0.1, pc[2].labels()[0], .00001);
+  BOOST_CHECK_CLOSE(0.9, pc[2].labels()[1], .00001);
+  BOOST_CHECK_CLOSE(0.7, pc[3].labels()[0], .00001);
+}
+
+BOOST_AUTO_TEST_CASE(point_cloud_gather_append) {
+  MouseTrack::PointCloud pc;
+  pc.resize(3, 1);
+  for (size_t i = 0; i < pc.size(); ++i) {
+    pc[i].x(i);
+    pc[i].y(10 * i);
+    pc[i].z(100 * i);
+    pc[i].intensity(0.1 * i);
+    pc[i].labels(MouseTrack::PointCloud::LabelVec::Constant(1, i));
+  }
+
+  MouseTrack::PointCloud gathered = pc.gather({2, 0});
+  BOOST_REQUIRE_EQUAL(gathered.size(), 2);
+  BOOST_REQUIRE_EQUAL(gathered.labelsDim(), 1);
+  BOOST_CHECK_CLOSE(2.0, gathered[0].x(), .00001);
+  BOOST_CHECK_CLOSE(200.0, gathered[0].z(), .00001);
+  BOOST_CHECK_CLOSE(0.2, gathered[0].intensity(), .00001);
+  BOOST_CHECK_CLOSE(2.0, gathered[0].labels()[0], .00001);
+  BOOST_CHECK_SMALL(double(gathered[1].y()), .00001);
+
+  gathered.append(pc);
+  BOOST_REQUIRE_EQUAL(gathered.size(), 5);
+  BOOST_CHECK_CLOSE(20.0, gathered[4].y(), .00001);
+  BOOST_CHECK_CLOSE(2.0, gathered[4].labels()[0], .00001);
+  BOOST_CHECK_CLOSE(2.0, gathered[0].x(), .00001);
+
+  MouseTrack::PointCloud other;
+  other.resize(1, 3);
+  BOOST_CHECK_THROW(gathered.append(other), const char *);
+}
+
+BOOST_AUTO_TEST_CASE(point_cloud_single_precision) {
+  MouseTrack::PointCloudF pc;
+  pc.resize(3, 1);
+  const float pos[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  const float labels[] = {0.5f, 1.5f, 2.5f};
+  pc.setPos(0, 3, pos);
+  pc.setLabels(0, 3, labels);
+
+  MouseTrack::PointCloudF gathered = pc.gather({2, 1});
+  BOOST_REQUIRE_EQUAL(gathered.size(), 2);
+  BOOST_CHECK_CLOSE(7.0f, gathered[0].x(), .00001f);
+  BOOST_CHECK_CLOSE(6.0f, gathered[1].z(), .00001f);
+  BOOST_CHECK_CLOSE(1.5f, gathered[1].labels()[0], .00001f);
+  BOOST_CHECK_EQUAL(gathered[0].characteristic().size(), 5);
+  BOOST_CHECK_CLOSE(7.0f, gathered.posMax()[0], .00001f);
+}
+
+BOOST_AUTO_TEST_CASE(point_cloud_characteristics) {
+  MouseTrack::PointCloud pc;
+  pc.resize(3, 2);
+  const MouseTrack::Coordinate pos[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  const MouseTrack::ColorChannel intensities[] = {0.1f, 0.2f, 0.3f};
+  const MouseTrack::PointCloud::Label labels[] = {1, 2, 3, 4, 5, 6};
+  pc.setPos(0, 3, pos);
+  pc.setIntensity(0, 3, intensities);
+  pc.setLabels(0, 3, labels);
+
+  const MouseTrack::PointCloud::CharMatrix all = pc.characteristics();
+  BOOST_REQUIRE_EQUAL(all.rows(), pc.charDim());
+  BOOST_REQUIRE_EQUAL(all.cols(), 3);
+  for (size_t i = 0; i < pc.size(); ++i) {
+    const auto expected = pc[i].characteristic();
+    for (int d = 0; d < pc.charDim(); ++d) {
+      BOOST_CHECK_CLOSE(expected[d], all(d, i), .0001);
+    }
+  }
+
+  const MouseTrack::PointCloud::CharMatrix subset = pc.characteristics({2, 0});
+  BOOST_REQUIRE_EQUAL(subset.cols(), 2);
+  BOOST_CHECK_EQUAL(subset.col(0), all.col(2));
+  BOOST_CHECK_EQUAL(subset.col(1), all.col(0));
+}
+
+BOOST_AUTO_TEST_CASE(point_cloud_statistics) {
+  MouseTrack::PointCloud pc;
+  pc.resize(3, 1);
+  const MouseTrack::Coordinate pos[] = {-1, 2, 3, 4, -5, 6, 7, 8, -9};
+  const MouseTrack::ColorChannel intensities[] = {0.25f, 0.5f, 0.75f};
+  const MouseTrack::PointCloud::Label labels[] = {1, 2, 3};
+  pc.setPos(0, 3, pos);
+  pc.setIntensity(0, 3, intensities);
+  pc.setLabels(0, 3, labels);
+
+  const auto stats = pc.statistics();
+  BOOST_REQUIRE_EQUAL(stats.count, 3);
+  BOOST_REQUIRE_EQUAL(stats.min.size(), pc.charDim());
+  BOOST_CHECK_CLOSE(-1.0, stats.min[0], .00001);
+  BOOST_CHECK_CLOSE(-9.0, stats.min[2], .00001);
+  BOOST_CHECK_CLOSE(8.0, stats.max[1], .00001);
+  BOOST_CHECK_CLOSE(0.75, stats.max[3], .00001);
+  BOOST_CHECK_CLOSE(6.0, stats.sum[4], .00001);
+  BOOST_CHECK_CLOSE(14.0, stats.sumSq[4], .00001);
+  BOOST_CHECK_CLOSE(2.0, stats.mean()[4], .00001);
+  BOOST_CHECK_CLOSE(2.0 / 3, stats.variance()[4], .00001);
+
+  // negative maxima and the cache
+  BOOST_CHECK_CLOSE(-5.0, pc.posMin()[1], .00001);
+  BOOST_CHECK_CLOSE(6.0, pc.posMax()[2], .00001);
+  BOOST_CHECK_CLOSE(0.0, pc.posCog()[2], .00001);
+
+  // changes drop the cache
+  pc[2].z(-20);
+  BOOST_CHECK_CLOSE(-20.0, pc.posMin()[2], .00001);
+  pc.posData()(0, 0) = -30;
+  BOOST_CHECK_CLOSE(-30.0, pc.charMin()[0], .00001);
+}
@@ -0,0 +1,178 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "point_cloud_view.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace MouseTrack {
+
+PointCloudView::PointCloudView()
+    : _parent(std::make_shared<const PointCloud>()), _complete(true) {
+  // empty
+}
+
+PointCloudView::PointCloudView(std::shared_ptr<const PointCloud> parent)
+    : _parent(std::move(parent)), _complete(true) {
+  if (_parent == nullptr) {
+    throw "PointCloudView needs a parent point cloud.";
+  }
+}
+
+PointCloudView::PointCloudView(std::shared_ptr<const PointCloud> parent,
+                               std::vector<PointIndex> indices)
+    : _parent(std::move(parent)), _indices(std::move(indices)),
+      _complete(false) {
+  if (_parent == nullptr) {
+    throw "PointCloudView needs a parent point cloud.";
+  }
+}
+
+PointCloudView::PointCloudView(const PointCloud &parent)
+    : _parent(std::shared_ptr<const PointCloud>(), &parent), _complete(true) {
+  // empty, aliasing constructor: no ownership
+}
+
+PointCloudView::PointCloudView(PointCloud &&parent)
+    : _parent(std::make_shared<const PointCloud>(std::move(parent))),
+      _complete(true) {
+  // empty
+}
+
+size_t PointCloudView::size() const {
+  return _complete ? _parent->size() : _indices.size();
+}
+
+const PointCloudView::ConstantPoint PointCloudView::
+operator[](size_t i) const {
+  return (*_parent)[parentIndex(i)];
+}
+
+PointIndex PointCloudView::parentIndex(size_t i) const {
+  return _complete ? i : _indices[i];
+}
+
+bool PointCloudView::complete() const { return _complete; }
+
+const std::vector<PointIndex> &PointCloudView::indices() const {
+  return _indices;
+}
+
+const PointCloud &PointCloudView::parent() const { return *_parent; }
+
+std::shared_ptr<const PointCloud> PointCloudView::parentPtr() const {
+  return _parent;
+}
+
+int PointCloudView::labelsDim() const { return _parent->labelsDim(); }
+
+int PointCloudView::charDim() const { return _parent->charDim(); }
+
+PointCloudView
+PointCloudView::select(const std::vector<PointIndex> &indices) const {
+  return PointCloudView(_parent, toParent(indices));
+}
+
+PointCloudView
+PointCloudView::selectMask(const std::vector<bool> &mask) const {
+  assert(mask.size() == size());
+  std::vector<PointIndex> indices;
+  for (size_t i = 0; i < mask.size(); ++i) {
+    if (mask[i]) {
+      indices.push_back(parentIndex(i));
+    }
+  }
+  return PointCloudView(_parent, std::move(indices));
+}
+
+PointCloud::CharMatrix PointCloudView::characteristics() const {
+  if (_complete) {
+    return _parent->characteristics();
+  }
+  return _parent->characteristics(_indices);
+}
+
+PointCloud::CharMatrix PointCloudView::characteristics(
+    const std::vector<PointIndex> &indices) const {
+  return _parent->characteristics(toParent(indices));
+}
+
+PointCloud::PosMatrix PointCloudView::positions() const {
+  if (_complete) {
+    return _parent->posData();
+  }
+  PointCloud::PosMatrix result(3, size());
+  const auto &pos = _parent->posData();
+  for (size_t i = 0; i < _indices.size(); ++i) {
+    result.col(i) = pos.col(_indices[i]);
+  }
+  return result;
+}
+
+PointCloud::ColMatrix PointCloudView::colors() const {
+  if (_complete) {
+    return _parent->colData();
+  }
+  PointCloud::ColMatrix result(3, size());
+  const auto &col = _parent->colData();
+  for (size_t i = 0; i < _indices.size(); ++i) {
+    result.col(i) = col.col(_indices[i]);
+  }
+  return result;
+}
+
+PointCloud::Statistics PointCloudView::statistics() const {
+  if (_complete) {
+    return _parent->statistics();
+  }
+  PointCloud::Statistics stats(charDim());
+  stats.count = size();
+  // gather blocks of points, reduce them while they are in cache
+  const size_t blockSize = 1024;
+  std::vector<PointIndex> block;
+  for (size_t first = 0; first < size(); first += blockSize) {
+    const size_t n = std::min(blockSize, size() - first);
+    block.assign(_indices.begin() + first, _indices.begin() + first + n);
+    stats.accumulate(_parent->characteristics(block), 0);
+  }
+  return stats;
+}
+
+PointCloud::PosVec PointCloudView::posMin() const {
+  return statistics().min.head<3>();
+}
+
+PointCloud::PosVec PointCloudView::posMax() const {
+  return statistics().max.head<3>();
+}
+
+PointCloud::PosVec PointCloudView::posCog() const {
+  if (size() == 0) {
+    return PointCloud::PosVec::Zero();
+  }
+  return statistics().mean().head<3>().cast<Coordinate>();
+}
+
+PointCloud PointCloudView::materialize() const {
+  if (_complete) {
+    return *_parent;
+  }
+  return _parent->gather(_indices);
+}
+
+std::vector<PointIndex>
+PointCloudView::toParent(const std::vector<PointIndex> &indices) const {
+  if (_complete) {
+    return indices;
+  }
+  std::vector<PointIndex> result(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    result[i] = _indices[indices[i]];
+  }
+  return result;
+}
+
+} // namespace MouseTrack
@@ -0,0 +1,116 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#pragma once
+
+#include "point_cloud.h"
+
+#include <memory>
+#include <vector>
+
+namespace MouseTrack {
+
+/// A selection of points of a parent point cloud.
+///
+/// Point i of the view is point `parentIndex(i)` of the parent, the data
+/// itself is never copied. Selecting from a view only composes indices, so
+/// chaining several filters costs index bookkeeping but no point data.
+///
+/// A view over all points of the parent doesn't store any indices.
+///
+/// The view shares ownership of its parent, except when explicitly
+/// constructed from a `const PointCloud &`: then the parent needs to outlive
+/// the view and every selection made from it.
+class PointCloudView {
+public:
+  typedef PointCloud::ConstantPoint ConstantPoint;
+
+  PointCloudView();
+
+  /// All points of `parent`
+  PointCloudView(std::shared_ptr<const PointCloud> parent);
+
+  /// The points of `parent` at `indices`, in this order
+  PointCloudView(std::shared_ptr<const PointCloud> parent,
+                 std::vector<PointIndex> indices);
+
+  /// All points of `parent` without taking ownership, `parent` needs to
+  /// outlive the view and all views selected from it
+  explicit PointCloudView(const PointCloud &parent);
+
+  /// All points of `parent`, the view takes ownership
+  PointCloudView(PointCloud &&parent);
+
+  /// Number of selected points
+  size_t size() const;
+
+  /// Read-only access to the i-th selected point.
+  const ConstantPoint operator[](size_t i) const;
+
+  /// Index of the i-th selected point in the parent cloud
+  PointIndex parentIndex(size_t i) const;
+
+  /// True if the view selects all points of the parent in their order
+  bool complete() const;
+
+  /// Indices into the parent cloud, empty if `complete()`
+  const std::vector<PointIndex> &indices() const;
+
+  const PointCloud &parent() const;
+  std::shared_ptr<const PointCloud> parentPtr() const;
+
+  int labelsDim() const;
+  int charDim() const;
+
+  /// A view of the points at `indices` (relative to this view).
+  PointCloudView select(const std::vector<PointIndex> &indices) const;
+
+  /// A view of all points i with `mask[i] == true`, `mask` needs one entry
+  /// per point of this view.
+  PointCloudView selectMask(const std::vector<bool> &mask) const;
+
+  /// Characteristic vectors of all selected points, column i belongs to
+  /// point i of the view.
+  PointCloud::CharMatrix characteristics() const;
+
+  /// Characteristic vectors of the points at `indices` (relative to this
+  /// view).
+  PointCloud::CharMatrix
+  characteristics(const std::vector<PointIndex> &indices) const;
+
+  /// Positions of all selected points, column i belongs to point i
+  PointCloud::PosMatrix positions() const;
+
+  /// Colors of all selected points, column i belongs to point i
+  PointCloud::ColMatrix colors() const;
+
+  /// Reductions over the selected points, see `PointCloud::statistics()`.
+  /// Views over all points use the cache of the parent.
+  PointCloud::Statistics statistics() const;
+
+  /// min corner of bounding box (only 3d position of points)
+  PointCloud::PosVec posMin() const;
+
+  /// max corner of bounding box (only 3d position of points)
+  PointCloud::PosVec posMax() const;
+
+  /// Center of gravity/centroid of the selected points
+  PointCloud::PosVec posCog() const;
+
+  /// Copies the selected points into a new point cloud
+  PointCloud materialize() const;
+
+private:
+  std::shared_ptr<const PointCloud> _parent;
+  /// empty if all points of the parent are selected
+  std::vector<PointIndex> _indices;
+  bool _complete;
+
+  /// Translates indices relative to this view to parent indices
+  std::vector<PointIndex>
+  toParent(const std::vector<PointIndex> &indices) const;
+};
+
+} // namespace MouseTrack
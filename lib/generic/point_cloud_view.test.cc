@@ -0,0 +1,111 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "point_cloud_view.h"
+#include "cluster.h"
+
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <type_traits>
+
+namespace MouseTrack {
+namespace {
+
+/// Point i is at (i, 10 * i, 100 * i) with intensity i / 10 and label i
+std::shared_ptr<const PointCloud> numberedCloud(int n) {
+  auto cloud = std::make_shared<PointCloud>();
+  cloud->resize(n, 1);
+  for (int i = 0; i < n; ++i) {
+    (*cloud)[i].x(i);
+    (*cloud)[i].y(10 * i);
+    (*cloud)[i].z(100 * i);
+    (*cloud)[i].intensity(i / 10.0);
+    const PointCloud::Label label = i;
+    cloud->setLabels(i, 1, &label);
+  }
+  return cloud;
+}
+
+} // namespace
+} // namespace MouseTrack
+
+BOOST_AUTO_TEST_CASE(point_cloud_view_complete) {
+  auto cloud = MouseTrack::numberedCloud(5);
+  MouseTrack::PointCloudView view(cloud);
+  BOOST_CHECK(view.complete());
+  BOOST_REQUIRE_EQUAL(view.size(), 5);
+  BOOST_CHECK_EQUAL(view.parentIndex(3), 3);
+  BOOST_CHECK_CLOSE(30.0, view[3].y(), .00001);
+  BOOST_CHECK_CLOSE(2.0, view.posCog()[0], .00001);
+  BOOST_CHECK_EQUAL(&view.parent(), cloud.get());
+}
+
+BOOST_AUTO_TEST_CASE(point_cloud_view_chained_selection) {
+  auto cloud = MouseTrack::numberedCloud(10);
+  MouseTrack::PointCloudView view(cloud);
+
+  // keep odd points, then the second and last of those
+  std::vector<bool> mask(10);
+  for (size_t i = 0; i < mask.size(); ++i) {
+    mask[i] = i % 2 == 1;
+  }
+  MouseTrack::PointCloudView odd = view.selectMask(mask);
+  BOOST_REQUIRE_EQUAL(odd.size(), 5);
+  MouseTrack::PointCloudView chained = odd.select({1, 4});
+  BOOST_REQUIRE_EQUAL(chained.size(), 2);
+  BOOST_CHECK(!chained.complete());
+  BOOST_CHECK_EQUAL(chained.parentIndex(0), 3);
+  BOOST_CHECK_EQUAL(chained.parentIndex(1), 9);
+  BOOST_CHECK_CLOSE(300.0, chained[0].z(), .00001);
+  BOOST_CHECK_EQUAL(&chained.parent(), cloud.get());
+
+  BOOST_CHECK_CLOSE(3.0, chained.posMin()[0], .00001);
+  BOOST_CHECK_CLOSE(90.0, chained.posMax()[1], .00001);
+  BOOST_CHECK_CLOSE(600.0, chained.posCog()[2], .00001);
+
+  const auto chars = chained.characteristics();
+  BOOST_REQUIRE_EQUAL(chars.cols(), 2);
+  BOOST_CHECK_CLOSE(9.0, chars(4, 1), .00001);
+
+  const MouseTrack::PointCloud copy = chained.materialize();
+  BOOST_REQUIRE_EQUAL(copy.size(), 2);
+  BOOST_CHECK_CLOSE(9.0, copy[1].x(), .00001);
+  BOOST_CHECK_CLOSE(0.9, copy[1].intensity(), .0001);
+
+  // clusters index the view
+  MouseTrack::Cluster cluster({0, 1});
+  BOOST_CHECK_CLOSE(6.0, cluster.center_of_gravity(chained)[0], .00001);
+}
+
+BOOST_AUTO_TEST_CASE(point_cloud_view_statistics) {
+  auto cloud = MouseTrack::numberedCloud(2000);
+  MouseTrack::PointCloudView view(cloud);
+  std::vector<MouseTrack::PointIndex> indices;
+  for (MouseTrack::PointIndex i = 1000; i < 2000; i += 2) {
+    indices.push_back(i);
+  }
+  const auto stats = view.select(indices).statistics();
+  BOOST_REQUIRE_EQUAL(stats.count, 500);
+  BOOST_CHECK_CLOSE(1000.0, stats.min[0], .00001);
+  BOOST_CHECK_CLOSE(19980.0, stats.max[1], .00001);
+  BOOST_CHECK_CLOSE(1499.0, stats.mean()[4], .00001);
+  BOOST_CHECK_EQUAL(view.statistics().count, 2000);
+}
+
+BOOST_AUTO_TEST_CASE(point_cloud_view_borrowing_is_explicit) {
+  // a view borrowing a cloud may dangle, only owning conversions are implicit
+  static_assert(!std::is_convertible<const MouseTrack::PointCloud &,
+                                     MouseTrack::PointCloudView>::value,
+                "borrowing a point cloud needs to be explicit");
+  static_assert(std::is_convertible<MouseTrack::PointCloud &&,
+                                    MouseTrack::PointCloudView>::value,
+                "moving a point cloud into a view is safe");
+
+  const MouseTrack::PointCloudView view =
+      MouseTrack::PointCloud(*MouseTrack::numberedCloud(4));
+  BOOST_REQUIRE_EQUAL(view.size(), 4);
+  BOOST_CHECK_CLOSE(300.0, view[3].z(), .00001);
+}
@@ -11,4 +11,8 @@ namespace MouseTrack {
 /// Returns a random sample of size "size" of points from a point cloud
 PointCloud random_sample(const PointCloud &cloud, const int size);
 
+/// Returns "size" distinct random indices in [0, count)
+std::vector<PointIndex> random_sample_indices(const size_t count,
+                                              const int size);
+
 } // namespace MouseTrack
@@ -10,10 +10,10 @@
 
 namespace MouseTrack {
 
-PictureD read_png_normalized(const std::string &path) {
+Picture read_png_normalized(const std::string &path) {
   auto mat = read_png(path);
-  PictureD result = mat.cast<PictureD::Scalar>();
-  result /= 255.0;
+  Picture result = mat.cast<Picture::Scalar>();
+  result /= Picture::Scalar(255);
   return result;
 }
 
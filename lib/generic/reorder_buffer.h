@@ -0,0 +1,108 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+
+namespace MouseTrack {
+
+/// Thread safe buffer that restores the order of out-of-order results.
+///
+/// A producer reserves a key per job in the desired output order, workers
+/// deliver the results with `put` in any order, a consumer receives them with
+/// `pop` in reservation order.
+/// At most `capacity` keys can be pending (reserved but not yet popped),
+/// `reserve` blocks otherwise. Keys must be unique while they are pending.
+template <typename Key, typename T> class ReorderBuffer {
+public:
+  /// A capacity of 0 is treated as 1.
+  ReorderBuffer(size_t capacity) : _capacity(capacity == 0 ? 1 : capacity) {
+    // empty
+  }
+
+  /// Appends `key` to the output order, blocks while `capacity` keys are
+  /// pending.
+  /// Returns false if the buffer was closed.
+  bool reserve(const Key &key) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notFull.wait(lock,
+                  [this]() { return _closed || _order.size() < _capacity; });
+    if (_closed) {
+      return false;
+    }
+    _order.push_back(key);
+    lock.unlock();
+    // the result might already be there
+    _changed.notify_all();
+    return true;
+  }
+
+  /// Delivers the result of a reserved key.
+  void put(const Key &key, T value) {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _ready[key] = std::move(value);
+    }
+    _changed.notify_all();
+  }
+
+  /// Waits until the result of the oldest reserved key is available and moves
+  /// it into `key` and `value`.
+  /// Returns false if the buffer is closed and no keys are pending.
+  bool pop(Key &key, T &value) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto next = _ready.end();
+    _changed.wait(lock, [&]() {
+      if (_order.empty()) {
+        return _closed;
+      }
+      next = _ready.find(_order.front());
+      return next != _ready.end();
+    });
+    if (_order.empty()) {
+      return false;
+    }
+    key = next->first;
+    value = std::move(next->second);
+    _ready.erase(next);
+    _order.pop_front();
+    lock.unlock();
+    _notFull.notify_one();
+    return true;
+  }
+
+  /// No more keys will be reserved, pending keys are still delivered.
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _closed = true;
+    }
+    _notFull.notify_all();
+    _changed.notify_all();
+  }
+
+  /// Number of reserved keys not popped yet
+  size_t pending() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _order.size();
+  }
+
+  size_t capacity() const { return _capacity; }
+
+private:
+  const size_t _capacity;
+  bool _closed = false;
+  std::deque<Key> _order;
+  std::map<Key, T> _ready;
+  mutable std::mutex _mutex;
+  std::condition_variable _notFull;
+  std::condition_variable _changed;
+};
+
+} // namespace MouseTrack
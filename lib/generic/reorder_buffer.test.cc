@@ -0,0 +1,75 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "reorder_buffer.h"
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+namespace utf = boost::unit_test;
+
+using namespace MouseTrack;
+
+BOOST_AUTO_TEST_CASE(reorder_buffer_restores_order) {
+  ReorderBuffer<int, int> buffer(4);
+  buffer.reserve(10);
+  buffer.reserve(3);
+  buffer.reserve(7);
+  buffer.close();
+
+  buffer.put(7, 70);
+  buffer.put(3, 30);
+  buffer.put(10, 100);
+
+  int key, value;
+  BOOST_CHECK(buffer.pop(key, value));
+  BOOST_CHECK_EQUAL(key, 10);
+  BOOST_CHECK_EQUAL(value, 100);
+  BOOST_CHECK(buffer.pop(key, value));
+  BOOST_CHECK_EQUAL(key, 3);
+  BOOST_CHECK_EQUAL(value, 30);
+  BOOST_CHECK(buffer.pop(key, value));
+  BOOST_CHECK_EQUAL(key, 7);
+  BOOST_CHECK_EQUAL(value, 70);
+  BOOST_CHECK(!buffer.pop(key, value));
+}
+
+BOOST_AUTO_TEST_CASE(reorder_buffer_concurrent_workers) {
+  constexpr int N = 500;
+  constexpr int W = 4;
+  ReorderBuffer<int, int> buffer(8);
+
+  // worker w delivers all keys k with k % W == w, the workers race against
+  // each other and against the producer
+  std::vector<std::thread> workers;
+  std::thread producer([&]() {
+    for (int k = 0; k < N; ++k) {
+      buffer.reserve(k);
+    }
+    buffer.close();
+  });
+  for (int w = 0; w < W; ++w) {
+    workers.emplace_back([&buffer, w]() {
+      for (int k = w; k < N; k += W) {
+        buffer.put(k, 2 * k);
+      }
+    });
+  }
+
+  int key, value, expected = 0;
+  while (buffer.pop(key, value)) {
+    BOOST_CHECK_EQUAL(key, expected);
+    BOOST_CHECK_EQUAL(value, 2 * expected);
+    BOOST_CHECK(buffer.pending() <= buffer.capacity());
+    expected += 1;
+  }
+  BOOST_CHECK_EQUAL(expected, N);
+
+  producer.join();
+  for (auto &t : workers) {
+    t.join();
+  }
+}
@@ -26,11 +26,27 @@ typedef int StreamNumber;
 typedef double Precision;
 
 /// Defines precision of a single coordinate component.
+/// Build with ENABLE_SINGLE_PRECISION to run point clouds, clustering and
+/// spatial queries in float.
+#if ENABLE_SINGLE_PRECISION
+typedef float Coordinate;
+#else
 typedef double Coordinate;
+#endif
 
 /// Defines precision of a single color component
 typedef float ColorChannel;
 
+/// Defines precision of a single pixel intensity of a frame.
+/// The source images are 8-bit, float represents them exactly and keeps frame
+/// windows at half the size of double.
+typedef float PixelIntensity;
+
+/// Represents an image in frame pixel format (intensity range: [0,1])
+typedef Eigen::Matrix<PixelIntensity, Eigen::Dynamic, Eigen::Dynamic,
+                      Eigen::RowMajor>
+    Picture;
+
 /// Represents an image in double format (intensity range: [0,1])
 typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
     PictureD;
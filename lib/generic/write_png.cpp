@@ -12,8 +12,8 @@
 
 namespace MouseTrack {
 
-bool write_png(const PictureD &img, const std::string &path) {
-  PictureI im = (255 * img).cast<PictureI::Scalar>();
+bool write_png(const Picture &img, const std::string &path) {
+  PictureI im = (Picture::Scalar(255) * img).cast<PictureI::Scalar>();
   return write_png(im, path);
 }
 
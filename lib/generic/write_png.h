@@ -15,6 +15,6 @@ namespace MouseTrack {
 bool write_png(const PictureI &img, const std::string &path);
 
 /// Writes an image to `path`
-bool write_png(const PictureD &img, const std::string &path);
+bool write_png(const Picture &img, const std::string &path);
 
 } // namespace MouseTrack
@@ -5,36 +5,205 @@
 
 #include "write_point_cloud.h"
 
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 
 namespace MouseTrack {
 
-void write_point_cloud(const std::string &path, const PointCloud &cloud) {
-  std::ofstream out;
-  out.open(path.c_str());
+namespace {
+
+typedef unsigned char Byte;
+
+bool hostIsLittleEndian() {
+  const std::uint16_t one = 1;
+  Byte first;
+  std::memcpy(&first, &one, 1);
+  return first == 1;
+}
+
+/// Collects the encoded vertices in memory and hands them to the file in
+/// chunks of `bufferSize` bytes.
+class PlyBuffer {
+public:
+  PlyBuffer(std::ofstream &out, size_t bufferSize)
+      : _out(out), _bufferSize(std::max(bufferSize, size_t(1024))),
+        _littleEndian(hostIsLittleEndian()) {
+    // reserve space for one more vertex than bufferSize
+    _buffer.reserve(_bufferSize + 128);
+  }
+
+  ~PlyBuffer() { flush(); }
+
+  /// Appends `value` in little endian byte order
+  template <typename T> void binary(T value) {
+    Byte bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    if (!_littleEndian) {
+      std::reverse(bytes, bytes + sizeof(T));
+    }
+    _buffer.insert(_buffer.end(), bytes, bytes + sizeof(T));
+  }
+
+  void ascii(double value) {
+    char text[32];
+    const int n = std::snprintf(text, sizeof(text), "%g", value);
+    _buffer.insert(_buffer.end(), text, text + n);
+  }
+
+  void ascii(int value) {
+    char text[16];
+    const int n = std::snprintf(text, sizeof(text), "%d", value);
+    _buffer.insert(_buffer.end(), text, text + n);
+  }
+
+  void ascii(char c) { _buffer.push_back(c); }
+
+  /// Writes the buffer to the file if it's full
+  void endVertex() {
+    if (_buffer.size() >= _bufferSize) {
+      flush();
+    }
+  }
+
+  void flush() {
+    _out.write(_buffer.data(), _buffer.size());
+    _buffer.clear();
+  }
+
+private:
+  std::ofstream &_out;
+  const size_t _bufferSize;
+  const bool _littleEndian;
+  std::vector<char> _buffer;
+};
+
+Byte toByte(ColorChannel c) { return (Byte)(int)(255.0 * c); }
+
+/// Writes header and vertices, `color(i, rgb)` stores the color of point i
+/// of the view in `rgb`.
+template <typename ColorOf>
+void write_ply(const std::string &path, const PointCloudView &cloud,
+               const PlyOptions &options, const ColorOf &color) {
+  std::ofstream out(path.c_str(), std::ios::out | std::ios::binary);
+  if (!out) {
+    BOOST_LOG_TRIVIAL(warning) << "Could not open " << path
+                               << " to write point cloud.";
+    return;
+  }
+  const char *const type = options.singlePrecision ? "float" : "double";
   out << "ply\n";
-  out << "format ascii 1.0\n";
+  if (options.binary) {
+    out << "format binary_little_endian 1.0\n";
+  } else {
+    out << "format ascii 1.0\n";
+  }
   out << "element vertex " << cloud.size() << "\n";
-  out << "property double x\n";
-  out << "property double y\n";
-  out << "property double z\n";
+  out << "property " << type << " x\n";
+  out << "property " << type << " y\n";
+  out << "property " << type << " z\n";
   out << "property uchar red\n";
   out << "property uchar green\n";
   out << "property uchar blue\n";
   out << "end_header\n";
-  for (size_t i = 0; i < cloud.size(); i += 1) {
-    const auto p = cloud[i];
-    out << p.x() << " " << p.y() << " " << p.z();
-    out << " " << (int)(255.0 * p.r());
-    out << " " << (int)(255.0 * p.g());
-    out << " " << (int)(255.0 * p.b()) << "\n";
-  }
-  out.close();
+
+  const auto &pos = cloud.parent().posData();
+  Byte rgb[3];
+  PlyBuffer buffer(out, options.bufferSize);
+  for (size_t i = 0; i < cloud.size(); ++i) {
+    const auto p = pos.col(cloud.parentIndex(i));
+    color(i, rgb);
+    if (options.binary) {
+      for (int d = 0; d < 3; ++d) {
+        if (options.singlePrecision) {
+          buffer.binary(float(p[d]));
+        } else {
+          buffer.binary(double(p[d]));
+        }
+      }
+      buffer.binary(rgb[0]);
+      buffer.binary(rgb[1]);
+      buffer.binary(rgb[2]);
+    } else {
+      for (int d = 0; d < 3; ++d) {
+        const double v = options.singlePrecision ? float(p[d]) : p[d];
+        buffer.ascii(v);
+        buffer.ascii(' ');
+      }
+      buffer.ascii(int(rgb[0]));
+      buffer.ascii(' ');
+      buffer.ascii(int(rgb[1]));
+      buffer.ascii(' ');
+      buffer.ascii(int(rgb[2]));
+      buffer.ascii('\n');
+    }
+    buffer.endVertex();
+  }
+  buffer.flush();
+  if (!out) {
+    BOOST_LOG_TRIVIAL(warning) << "Failed writing point cloud to " << path;
+  }
+}
+
+} // namespace
+
+void write_point_cloud(const std::string &path, const PointCloudView &cloud,
+                       const PlyOptions &options) {
+  const auto &col = cloud.parent().colData();
+  write_ply(path, cloud, options, [&](size_t i, Byte *rgb) {
+    const auto c = col.col(cloud.parentIndex(i));
+    rgb[0] = toByte(c[0]);
+    rgb[1] = toByte(c[1]);
+    rgb[2] = toByte(c[2]);
+  });
+}
+
+void write_point_cloud(const std::string &path, const PointCloudView &cloud,
+                       const PointCloud::ColMatrix &colors,
+                       const PlyOptions &options) {
+  assert(colors.cols() == (int)cloud.size());
+  write_ply(path, cloud, options, [&](size_t i, Byte *rgb) {
+    rgb[0] = toByte(colors(0, i));
+    rgb[1] = toByte(colors(1, i));
+    rgb[2] = toByte(colors(2, i));
+  });
+}
+
+void write_point_cloud(const std::string &path, const PointCloudView &cloud,
+                       const std::vector<int> &colorIndex,
+                       const PointCloud::ColMatrix &palette,
+                       const PlyOptions &options) {
+  assert(colorIndex.size() == cloud.size());
+  // convert each palette entry only once
+  std::vector<Byte> bytes(3 * palette.cols());
+  for (int c = 0; c < palette.cols(); ++c) {
+    for (int d = 0; d < 3; ++d) {
+      bytes[3 * c + d] = toByte(palette(d, c));
+    }
+  }
+  const auto &col = cloud.parent().colData();
+  write_ply(path, cloud, options, [&](size_t i, Byte *rgb) {
+    const int c = colorIndex[i];
+    if (c < 0) {
+      const auto own = col.col(cloud.parentIndex(i));
+      rgb[0] = toByte(own[0]);
+      rgb[1] = toByte(own[1]);
+      rgb[2] = toByte(own[2]);
+    } else {
+      assert(c < palette.cols());
+      std::copy(&bytes[3 * c], &bytes[3 * c] + 3, rgb);
+    }
+  });
 }
 
 void write_point_cloud_metrics(const std::string &path,
-                               const PointCloud &cloud) {
-  Eigen::VectorXd posCog = cloud.posCog();
+                               const PointCloudView &cloud) {
+  PointCloud::PosVec posCog = cloud.posCog();
   std::ofstream out;
   out.open(path.c_str());
   // out << "# posCog_X, posCog_Y, posCog_Z\n";
@@ -5,15 +5,44 @@
 
 #pragma once
 
-#include "generic/point_cloud.h"
+#include "generic/point_cloud_view.h"
+
+#include <string>
+#include <vector>
 
 namespace MouseTrack {
 
+/// Encoding of PLY files written by `write_point_cloud`
+struct PlyOptions {
+  /// binary little endian if true, ascii otherwise
+  bool binary = true;
+  /// store coordinates as float instead of double
+  bool singlePrecision = false;
+  /// bytes collected in memory before they are handed to the file
+  size_t bufferSize = 1 << 20;
+};
+
 /// Writes a point cloud as PLY file to `path`
-void write_point_cloud(const std::string &path, const PointCloud &cloud);
+void write_point_cloud(const std::string &path, const PointCloudView &cloud,
+                       const PlyOptions &options = PlyOptions());
 
+/// Writes a point cloud as PLY file to `path`, column i of `colors` replaces
+/// the color of point i.
+void write_point_cloud(const std::string &path, const PointCloudView &cloud,
+                       const PointCloud::ColMatrix &colors,
+                       const PlyOptions &options = PlyOptions());
+
+/// Writes a point cloud as PLY file to `path`, point i gets the color
+/// `palette.col(colorIndex[i])`, or keeps its own color if `colorIndex[i]`
+/// is negative.
+///
+/// Recoloring this way doesn't copy any point data.
+void write_point_cloud(const std::string &path, const PointCloudView &cloud,
+                       const std::vector<int> &colorIndex,
+                       const PointCloud::ColMatrix &palette,
+                       const PlyOptions &options = PlyOptions());
 
 /// Writes some point cloud metrics as csv file to `path`
 void write_point_cloud_metrics(const std::string &path,
-                               const PointCloud &cloud);
+                               const PointCloudView &cloud);
 } // namespace MouseTrack
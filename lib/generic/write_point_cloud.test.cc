@@ -0,0 +1,130 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "write_point_cloud.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace utf = boost::unit_test;
+namespace fs = boost::filesystem;
+
+namespace MouseTrack {
+namespace {
+
+/// 3 points with distinct positions and colors
+PointCloud plyTestCloud() {
+  PointCloud cloud;
+  cloud.resize(3, 0);
+  for (int i = 0; i < 3; ++i) {
+    cloud[i].x(i + 0.5);
+    cloud[i].y(-i);
+    cloud[i].z(100 * i);
+    cloud[i].r(0.0);
+    cloud[i].g(0.5);
+    cloud[i].b(1.0);
+  }
+  return cloud;
+}
+
+/// Writes the cloud with `write`, returns the file content
+template <typename Write> std::string writeAndRead(const Write &write) {
+  const fs::path path =
+      fs::temp_directory_path() / fs::unique_path("mousetrack-%%%%%%%%.ply");
+  write(path.string());
+  std::ifstream in(path.string(), std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+  in.close();
+  fs::remove(path);
+  return content;
+}
+
+/// Body of a PLY file (everything after the header)
+std::string plyBody(const std::string &content) {
+  const std::string end = "end_header\n";
+  const size_t pos = content.find(end);
+  BOOST_REQUIRE(pos != std::string::npos);
+  return content.substr(pos + end.size());
+}
+
+template <typename T> T readAt(const std::string &body, size_t offset) {
+  T value;
+  std::memcpy(&value, body.data() + offset, sizeof(T));
+  return value;
+}
+
+} // namespace
+} // namespace MouseTrack
+
+using MouseTrack::PlyOptions;
+using MouseTrack::PointCloud;
+using MouseTrack::PointCloudView;
+
+BOOST_AUTO_TEST_CASE(write_point_cloud_binary_double) {
+  const PointCloudView cloud(MouseTrack::plyTestCloud());
+  const std::string content = MouseTrack::writeAndRead(
+      [&](const std::string &p) { write_point_cloud(p, cloud); });
+  BOOST_CHECK(content.find("format binary_little_endian 1.0\n") !=
+              std::string::npos);
+  BOOST_CHECK(content.find("property double x\n") != std::string::npos);
+  const std::string body = MouseTrack::plyBody(content);
+  const size_t stride = 3 * sizeof(double) + 3;
+  BOOST_REQUIRE_EQUAL(body.size(), 3 * stride);
+  for (int i = 0; i < 3; ++i) {
+    const size_t o = i * stride;
+    BOOST_CHECK_EQUAL(MouseTrack::readAt<double>(body, o), i + 0.5);
+    BOOST_CHECK_EQUAL(MouseTrack::readAt<double>(body, o + 8), -i);
+    BOOST_CHECK_EQUAL(MouseTrack::readAt<double>(body, o + 16), 100 * i);
+    BOOST_CHECK_EQUAL((int)(unsigned char)body[o + 24], 0);
+    BOOST_CHECK_EQUAL((int)(unsigned char)body[o + 25], 127);
+    BOOST_CHECK_EQUAL((int)(unsigned char)body[o + 26], 255);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(write_point_cloud_binary_float_selection) {
+  auto cloud = std::make_shared<const PointCloud>(MouseTrack::plyTestCloud());
+  const PointCloudView view = PointCloudView(cloud).select({2, 0});
+  PlyOptions options;
+  options.singlePrecision = true;
+  // tiny buffer, forces multiple flushes
+  options.bufferSize = 1;
+  PointCloud::ColMatrix palette(3, 1);
+  palette.col(0) << 1.0, 0.0, 0.0;
+  const std::vector<int> colorIndex = {-1, 0};
+  const std::string content =
+      MouseTrack::writeAndRead([&](const std::string &p) {
+        write_point_cloud(p, view, colorIndex, palette, options);
+      });
+  BOOST_CHECK(content.find("element vertex 2\n") != std::string::npos);
+  BOOST_CHECK(content.find("property float x\n") != std::string::npos);
+  const std::string body = MouseTrack::plyBody(content);
+  const size_t stride = 3 * sizeof(float) + 3;
+  BOOST_REQUIRE_EQUAL(body.size(), 2 * stride);
+  BOOST_CHECK_EQUAL(MouseTrack::readAt<float>(body, 0), 2.5f);
+  BOOST_CHECK_EQUAL(MouseTrack::readAt<float>(body, 8), 200.0f);
+  // own color
+  BOOST_CHECK_EQUAL((int)(unsigned char)body[14], 255);
+  BOOST_CHECK_EQUAL(MouseTrack::readAt<float>(body, stride), 0.5f);
+  // palette color
+  BOOST_CHECK_EQUAL((int)(unsigned char)body[stride + 12], 255);
+  BOOST_CHECK_EQUAL((int)(unsigned char)body[stride + 14], 0);
+}
+
+BOOST_AUTO_TEST_CASE(write_point_cloud_ascii) {
+  const PointCloudView cloud(MouseTrack::plyTestCloud());
+  PlyOptions options;
+  options.binary = false;
+  const std::string content = MouseTrack::writeAndRead(
+      [&](const std::string &p) { write_point_cloud(p, cloud, options); });
+  BOOST_CHECK(content.find("format ascii 1.0\n") != std::string::npos);
+  BOOST_CHECK_EQUAL(MouseTrack::plyBody(content),
+                    "0.5 0 0 0 127 255\n1.5 -1 100 0 127 255\n"
+                    "2.5 -2 200 0 127 255\n");
+}
@@ -0,0 +1,61 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+
+#include "morton_order.h"
+#include <algorithm>
+#include <boost/log/trivial.hpp>
+
+namespace MouseTrack {
+
+namespace {
+
+/// Inserts two zero bits in front of each of the lowest 21 bits of `v`
+uint64_t spread(uint64_t v) {
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffff;
+  v = (v | v << 16) & 0x1f0000ff0000ff;
+  v = (v | v << 8) & 0x100f00f00f00f00f;
+  v = (v | v << 4) & 0x10c30c30c30c30c3;
+  v = (v | v << 2) & 0x1249249249249249;
+  return v;
+}
+
+} // namespace
+
+uint64_t MortonOrder::code(uint32_t x, uint32_t y, uint32_t z) {
+  return spread(x) | spread(y) << 1 | spread(z) << 2;
+}
+
+PointCloudView MortonOrder::operator()(const PointCloudView &inCloud) const {
+  if (inCloud.size() <= 1) {
+    return inCloud;
+  }
+  const PointCloud::PosMatrix pos = inCloud.positions();
+  const PointCloud::PosVec min = pos.rowwise().minCoeff();
+  const PointCloud::PosVec max = pos.rowwise().maxCoeff();
+  const double cells = (uint32_t(1) << bits) - 1;
+
+  // (code, index), sorting the pairs keeps the order of equal codes stable
+  std::vector<std::pair<uint64_t, PointIndex>> codes(inCloud.size());
+  for (size_t i = 0; i < inCloud.size(); ++i) {
+    uint32_t q[3];
+    for (int d = 0; d < 3; ++d) {
+      const double extent = double(max[d]) - min[d];
+      const double rel = extent > 0 ? (pos(d, i) - min[d]) / extent : 0;
+      q[d] = uint32_t(std::min(cells, std::max(0.0, rel * cells)));
+    }
+    codes[i] = std::make_pair(code(q[0], q[1], q[2]), PointIndex(i));
+  }
+  std::sort(codes.begin(), codes.end());
+
+  std::vector<PointIndex> order(codes.size());
+  for (size_t i = 0; i < codes.size(); ++i) {
+    order[i] = codes[i].second;
+  }
+  BOOST_LOG_TRIVIAL(debug) << "Sorted " << order.size()
+                           << " points along Morton curve.";
+  return inCloud.select(order);
+}
+
+} // namespace MouseTrack
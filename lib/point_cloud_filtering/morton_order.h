@@ -0,0 +1,37 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+
+#pragma once
+
+#include "point_cloud_filtering.h"
+
+#include <cstdint>
+
+namespace MouseTrack {
+
+/// Reorders the points of a point cloud along a Z-order (Morton) curve over
+/// their positions, no point is removed.
+///
+/// Registered clouds arrive in scanline order stream by stream, spatial
+/// neighbors are therefore scattered through memory. After sorting, points
+/// close in space are mostly close in memory, which saves cache misses in
+/// all neighborhood heavy stages (grids, mean shift, outlier removal).
+///
+/// The permutation is kept by the returned view: point i of the view is
+/// point `parentIndex(i)` of the original cloud.
+class MortonOrder : public PointCloudFiltering {
+public:
+  /// Bits per axis used to quantize positions
+  static constexpr int bits = 21;
+
+  MortonOrder() = default;
+  virtual ~MortonOrder() = default;
+  virtual PointCloudView operator()(const PointCloudView &inCloud) const;
+
+  /// Interleaves the lowest `bits` bits of `x`, `y` and `z`, bit i of `x`
+  /// becomes bit 3 * i of the code.
+  static uint64_t code(uint32_t x, uint32_t y, uint32_t z);
+};
+
+} // namespace MouseTrack
@@ -0,0 +1,101 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "morton_order.h"
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace MouseTrack;
+
+namespace {
+
+/// A 4x4x4 lattice, point i is at (i % 4, i / 4 % 4, i / 16) scaled by 10
+std::shared_ptr<const PointCloud> lattice() {
+  auto cloud = std::make_shared<PointCloud>();
+  cloud->resize(64, 0);
+  for (int i = 0; i < 64; ++i) {
+    (*cloud)[i].x(10 * (i % 4));
+    (*cloud)[i].y(10 * (i / 4 % 4));
+    (*cloud)[i].z(10 * (i / 16));
+  }
+  return cloud;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(morton_order_code_interleaves_bits) {
+  BOOST_CHECK_EQUAL(MortonOrder::code(0, 0, 0), 0u);
+  BOOST_CHECK_EQUAL(MortonOrder::code(1, 0, 0), 1u);
+  BOOST_CHECK_EQUAL(MortonOrder::code(0, 1, 0), 2u);
+  BOOST_CHECK_EQUAL(MortonOrder::code(0, 0, 1), 4u);
+  BOOST_CHECK_EQUAL(MortonOrder::code(3, 0, 0), 9u);
+  const uint32_t all = (uint32_t(1) << MortonOrder::bits) - 1;
+  BOOST_CHECK_EQUAL(MortonOrder::code(all, all, all),
+                    (uint64_t(1) << (3 * MortonOrder::bits)) - 1);
+  BOOST_CHECK_EQUAL(MortonOrder::code(0, 0, uint32_t(1) << 20),
+                    uint64_t(1) << 62);
+}
+
+BOOST_AUTO_TEST_CASE(morton_order_is_permutation_of_parent) {
+  auto cloud = lattice();
+  PointCloudView view(cloud);
+  // drop every third point first, the order must compose with selections
+  std::vector<PointIndex> selected;
+  for (PointIndex i = 0; i < 64; ++i) {
+    if (i % 3 != 0) {
+      selected.push_back(63 - i);
+    }
+  }
+  PointCloudView in = view.select(selected);
+  PointCloudView out = MortonOrder()(in);
+
+  BOOST_REQUIRE_EQUAL(out.size(), in.size());
+  std::set<PointIndex> seen;
+  for (size_t i = 0; i < out.size(); ++i) {
+    const PointIndex p = out.parentIndex(i);
+    seen.insert(p);
+    // data is the parent's point at the mapped index
+    BOOST_CHECK_EQUAL(out[i].x(), (*cloud)[p].x());
+    BOOST_CHECK_EQUAL(out[i].y(), (*cloud)[p].y());
+    BOOST_CHECK_EQUAL(out[i].z(), (*cloud)[p].z());
+  }
+  BOOST_CHECK(std::set<PointIndex>(selected.begin(), selected.end()) == seen);
+}
+
+BOOST_AUTO_TEST_CASE(morton_order_groups_octants) {
+  auto cloud = lattice();
+  PointCloudView out = MortonOrder()(PointCloudView(cloud));
+  BOOST_REQUIRE_EQUAL(out.size(), 64);
+  // the curve visits the 2x2x2 blocks one after the other
+  for (size_t block = 0; block < 8; ++block) {
+    for (size_t i = 8 * block; i < 8 * block + 8; ++i) {
+      BOOST_CHECK_EQUAL(int(out[i].x()) / 20, block % 2);
+      BOOST_CHECK_EQUAL(int(out[i].y()) / 20, block / 2 % 2);
+      BOOST_CHECK_EQUAL(int(out[i].z()) / 20, block / 4);
+    }
+  }
+  BOOST_CHECK_EQUAL(out.parentIndex(0), 0);
+  BOOST_CHECK_EQUAL(out.parentIndex(63), 63);
+}
+
+BOOST_AUTO_TEST_CASE(morton_order_degenerate_clouds) {
+  PointCloud empty;
+  BOOST_CHECK_EQUAL(MortonOrder()(PointCloudView(empty)).size(), 0);
+
+  // all points at the same position keep their order
+  auto flat = std::make_shared<PointCloud>();
+  flat->resize(5, 0);
+  for (int i = 0; i < 5; ++i) {
+    (*flat)[i].x(1);
+    (*flat)[i].y(2);
+    (*flat)[i].z(3);
+  }
+  PointCloudView out = MortonOrder()(PointCloudView(flat));
+  BOOST_REQUIRE_EQUAL(out.size(), 5);
+  for (size_t i = 0; i < 5; ++i) {
+    BOOST_CHECK_EQUAL(out.parentIndex(i), i);
+  }
+}
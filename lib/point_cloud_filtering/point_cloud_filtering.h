@@ -4,19 +4,21 @@
 
 #pragma once
 
-#include "generic/point_cloud.h"
+#include "generic/point_cloud_view.h"
 
 namespace MouseTrack {
 
 
 /// General interface for point cloud processing.
 ///
+/// Filters select (and possibly reorder) points, they return a view on the
+/// parent of `inCloud` instead of copying the remaining points.
 class PointCloudFiltering {
 public:
   virtual ~PointCloudFiltering() = default;
 
-  /// Takes a point cloud and returns a new point cloud on which an operation was performed.
-  virtual PointCloud operator()(const PointCloud &inCloud) const = 0;
+  /// Takes a point cloud and returns the points that pass the filter.
+  virtual PointCloudView operator()(const PointCloudView &inCloud) const = 0;
 };
 
 } // namespace MouseTrack
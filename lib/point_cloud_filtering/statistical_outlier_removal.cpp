@@ -4,55 +4,43 @@
 
 #include "statistical_outlier_removal.h"
 #include "spatial/statistical_outlier_detection.h"
-#include "spatial/uniform_grid.h"
 #include <boost/log/trivial.hpp>
 
 namespace MouseTrack {
 
+StatisticalOutlierRemoval::StatisticalOutlierRemoval() {
+  _oracleFactory.desiredOracle(OFactory::KD_TREE);
+}
+
 StatisticalOutlierRemoval::StatisticalOutlierRemoval(double alpha, int k)
     : _k(k), _alpha(alpha) {
-  // empty
+  _oracleFactory.desiredOracle(OFactory::KD_TREE);
 }
 
-PointCloud StatisticalOutlierRemoval::
-operator()(const PointCloud &inCloud) const {
-  auto bb_min = inCloud.charMin();
-  auto bb_max = inCloud.charMax();
-  auto bb_size = bb_max - bb_min;
+PointCloudView StatisticalOutlierRemoval::
+operator()(const PointCloudView &inCloud) const {
+  typedef OFactory::PointList PointList;
+  PointList pts = inCloud.positions();
 
-  // division arbitrary, heuristic for better choice?
-  BOOST_LOG_TRIVIAL(debug) << "grid maxR: " << bb_size.maxCoeff()
-                           << ", grid cell size: " << bb_size.minCoeff() / 50.0;
-  UniformGrid3d ug(bb_size.maxCoeff(), bb_size.minCoeff() / 50.0);
-
-  typedef UniformGrid3d::PointList PointList;
-  PointList pts(3, inCloud.size());
-  for (size_t i = 0; i < inCloud.size(); ++i) {
-    auto p = inCloud[i];
-    pts(0, i) = p.x();
-    pts(1, i) = p.x();
-    pts(2, i) = p.x();
+  std::unique_ptr<OFactory::Oracle> oracle;
+  {
+    OFactory::Query q;
+    q.example_data = &pts;
+    q.dimensions = pts.rows();
+    q.k = k();
+    oracle = oracleFactory().forQuery(q);
   }
-  ug.compute(pts);
-  auto outliers =
-      statisticalOutlierDetection<PointList, Precision>(pts, &ug, alpha(), k());
+  oracle->compute(pts);
+  auto outliers = statisticalOutlierDetection<PointList, Coordinate>(
+      pts, oracle.get(), alpha(), k());
 
-  PointCloud outCloud;
-  outCloud.resize(inCloud.size() - outliers.size(), inCloud.labelsDim());
-  size_t next_insert = 0;
-  size_t o = 0;
-  for (size_t i = 0; i < inCloud.size(); ++i) {
-    if (o < outliers.size() && outliers[o] == i) {
-      // skip
-      ++o;
-      continue;
-    }
-    outCloud[next_insert] = inCloud[i];
-    ++next_insert;
+  std::vector<bool> inliers(inCloud.size(), true);
+  for (size_t o : outliers) {
+    inliers[o] = false;
   }
   BOOST_LOG_TRIVIAL(debug) << "Removed " << outliers.size()
                            << " outliers from point cloud.";
-  return outCloud;
+  return inCloud.selectMask(inliers);
 }
 
 // setter/getter
@@ -65,4 +53,14 @@ void StatisticalOutlierRemoval::alpha(double _new) { _alpha = _new; }
 
 double StatisticalOutlierRemoval::alpha() const { return _alpha; }
 
+StatisticalOutlierRemoval::OFactory &
+StatisticalOutlierRemoval::oracleFactory() {
+  return _oracleFactory;
+}
+
+const StatisticalOutlierRemoval::OFactory &
+StatisticalOutlierRemoval::oracleFactory() const {
+  return _oracleFactory;
+}
+
 } // namespace MouseTrack
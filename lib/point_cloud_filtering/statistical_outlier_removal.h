@@ -5,6 +5,7 @@
 #pragma once
 
 #include "point_cloud_filtering.h"
+#include "spatial/oracle_factory.h"
 
 namespace MouseTrack {
 /// Based on: Towards 3D point cloud based object maps for household
@@ -22,13 +23,17 @@ namespace MouseTrack {
 /// sigma: standard deviation of nearest neighbors
 ///
 /// alpha: decides how much variance we want to allow
+///
+/// The neighbor queries use an exact KdTree by default.
 class StatisticalOutlierRemoval : public PointCloudFiltering {
 public:
-  StatisticalOutlierRemoval() = default;
+  typedef OracleFactory<Coordinate> OFactory;
+
+  StatisticalOutlierRemoval();
   StatisticalOutlierRemoval(double alpha, int k);
   virtual ~StatisticalOutlierRemoval() = default;
 
-  virtual PointCloud operator()(const PointCloud &inCloud) const;
+  virtual PointCloudView operator()(const PointCloudView &inCloud) const;
 
   void k(int _new);
   int k() const;
@@ -36,9 +41,16 @@ public:
   void alpha(double _new);
   double alpha() const;
 
+  /// modify factory settings
+  OFactory &oracleFactory();
+
+  /// query the factory
+  const OFactory &oracleFactory() const;
+
 private:
   int _k = 30;
   double _alpha = 1.0;
+  OFactory _oracleFactory;
 };
 
 } // namespace MouseTrack
@@ -0,0 +1,34 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "statistical_outlier_removal.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace MouseTrack;
+
+BOOST_AUTO_TEST_CASE(statistical_outlier_removal_default_matches_brute_force) {
+  srand(13);
+  auto cloud = std::make_shared<PointCloud>();
+  cloud->resize(2000, 0);
+  for (PointIndex i = 0; i < 2000; ++i) {
+    // a dense blob with a sparse halo
+    const double scale = i % 10 == 0 ? 5.0 : 1.0;
+    (*cloud)[i].x(scale * (rand() / double(RAND_MAX) - 0.5));
+    (*cloud)[i].y(scale * (rand() / double(RAND_MAX) - 0.5));
+    (*cloud)[i].z(scale * (rand() / double(RAND_MAX) - 0.5));
+  }
+  PointCloudView in(cloud);
+
+  StatisticalOutlierRemoval defaultRemoval(1.0, 30);
+  StatisticalOutlierRemoval bruteForceRemoval(1.0, 30);
+  bruteForceRemoval.oracleFactory().desiredOracle(
+      StatisticalOutlierRemoval::OFactory::BRUTE_FORCE);
+
+  PointCloudView expected = bruteForceRemoval(in);
+  PointCloudView actual = defaultRemoval(in);
+  BOOST_CHECK_LT(expected.size(), in.size());
+  BOOST_CHECK(actual.indices() == expected.indices());
+}
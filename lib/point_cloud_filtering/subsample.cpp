@@ -17,10 +17,15 @@ void SubSample::desiredMaxPoints(int _new) { _desiredMaxPoints = _new; }
 
 int SubSample::desiredMaxPoints() const { return _desiredMaxPoints; }
 
-PointCloud SubSample::operator()(const PointCloud &inCloud) const {
-  PointCloud cloud = random_sample(inCloud, _desiredMaxPoints);
-  auto min = cloud.posMin();
-  auto max = cloud.posMax();
+PointCloudView SubSample::operator()(const PointCloudView &inCloud) const {
+  if (inCloud.size() <= (size_t)_desiredMaxPoints) {
+    return inCloud;
+  }
+  PointCloudView cloud = inCloud.select(
+      random_sample_indices(inCloud.size(), _desiredMaxPoints));
+  const PointCloud::Statistics stats = cloud.statistics();
+  const auto &min = stats.min;
+  const auto &max = stats.max;
 
   BOOST_LOG_TRIVIAL(debug) << "Subsampled point cloud to " << cloud.size()
                            << " points, xyz-min: [" << min[0] << ", " << min[1]
@@ -10,13 +10,13 @@ namespace MouseTrack {
 
 /// Samples points randomly (without repetition) from a point cloud.
 ///
-/// This creates a new point cloud that holds less data, but has the same statistical properties as the old point cloud.
+/// This creates a view on fewer points, but with the same statistical properties as the old point cloud.
 class SubSample : public PointCloudFiltering {
 public:
   SubSample() = default;
   SubSample(int desiredMaxPoints);
   virtual ~SubSample() = default;
-  virtual PointCloud operator()(const PointCloud &inCloud) const;
+  virtual PointCloudView operator()(const PointCloudView &inCloud) const;
   void desiredMaxPoints(int _new);
   int desiredMaxPoints() const;
 
@@ -0,0 +1,191 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "prefetching_reader.h"
+
+#include <boost/log/trivial.hpp>
+
+namespace MouseTrack {
+
+namespace {
+
+template <typename Matrix> size_t matrixBytes(const Matrix &m) {
+  return m.size() * sizeof(typename Matrix::Scalar);
+}
+
+/// Approximate memory occupied by the pixel data of a frame window
+size_t frameWindowBytes(const FrameWindow &window) {
+  size_t bytes = 0;
+  for (const Frame &frame : window.frames()) {
+    bytes += matrixBytes(frame.normalizedDisparityMap);
+    bytes += matrixBytes(frame.rawDisparityMap);
+    bytes += matrixBytes(frame.referencePicture);
+    for (const auto &label : frame.labels) {
+      bytes += matrixBytes(label);
+    }
+  }
+  return bytes;
+}
+
+} // namespace
+
+PrefetchingReader::PrefetchingReader(std::unique_ptr<Reader> reader,
+                                     size_t depth, size_t memoryCap)
+    : _reader(std::move(reader)), _depth(depth == 0 ? 1 : depth),
+      _memoryCap(memoryCap), _bytes(0), _lastWindowBytes(0),
+      _exhausted(false), _shouldRun(false) {
+  if (_reader == nullptr) {
+    throw "PrefetchingReader needs a reader to wrap.";
+  }
+}
+
+PrefetchingReader::~PrefetchingReader() { stopWorker(); }
+
+bool PrefetchingReader::valid() const {
+  std::lock_guard<std::mutex> lock(_readerMutex);
+  return _reader->valid();
+}
+
+bool PrefetchingReader::hasNextFrame() const {
+  ensureStarted();
+  std::unique_lock<std::mutex> lock(_mutex);
+  _changed.wait(lock,
+                [this]() { return !_queue.empty() || _exhausted || !_shouldRun; });
+  return !_queue.empty();
+}
+
+FrameNumber PrefetchingReader::nextFrame() {
+  ensureStarted();
+  std::unique_lock<std::mutex> lock(_mutex);
+  _changed.wait(lock,
+                [this]() { return !_queue.empty() || _exhausted || !_shouldRun; });
+  if (_queue.empty()) {
+    // nothing prefetched, let the wrapped reader decide what to do
+    lock.unlock();
+    std::lock_guard<std::mutex> readerLock(_readerMutex);
+    return _reader->nextFrame();
+  }
+  Prefetched p = std::move(_queue.front());
+  _queue.pop_front();
+  FrameNumber f = p.frame;
+  _bytes -= p.bytes;
+  _delivered[f] = std::move(p);
+  lock.unlock();
+  _changed.notify_all();
+  return f;
+}
+
+FrameWindow PrefetchingReader::operator()(FrameNumber f) {
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto match = _delivered.find(f);
+    if (match != _delivered.end()) {
+      Prefetched p = std::move(match->second);
+      _delivered.erase(match);
+      lock.unlock();
+      if (p.valid) {
+        return std::move(p.window);
+      }
+    }
+  }
+  // not prefetched or prefetching failed: read synchronously, any error
+  // reaches the caller this way
+  std::lock_guard<std::mutex> readerLock(_readerMutex);
+  return (*_reader)(f);
+}
+
+bool PrefetchingReader::threadSafe() const { return true; }
+
+void PrefetchingReader::reconfigure(std::function<void(Reader &)> change) {
+  stopWorker();
+  {
+    std::lock_guard<std::mutex> readerLock(_readerMutex);
+    change(*_reader);
+  }
+  // the worker restarts with the next `hasNextFrame()`/`nextFrame()` and
+  // appends to the frames prefetched so far
+  std::lock_guard<std::mutex> lock(_mutex);
+  _exhausted = false;
+}
+
+size_t PrefetchingReader::depth() const { return _depth; }
+
+size_t PrefetchingReader::memoryCap() const { return _memoryCap; }
+
+size_t PrefetchingReader::prefetchedBytes() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _bytes;
+}
+
+void PrefetchingReader::ensureStarted() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_worker.joinable() || _exhausted) {
+    return;
+  }
+  _shouldRun = true;
+  _worker = std::thread([this]() { prefetch(); });
+}
+
+void PrefetchingReader::stopWorker() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _shouldRun = false;
+  }
+  _changed.notify_all();
+  if (_worker.joinable()) {
+    _worker.join();
+  }
+}
+
+void PrefetchingReader::prefetch() const {
+  BOOST_LOG_TRIVIAL(debug) << "Prefetching thread started";
+  while (true) {
+    {
+      // one window is always allowed if none is waiting, even if it exceeds
+      // the cap
+      std::unique_lock<std::mutex> lock(_mutex);
+      _changed.wait(lock, [this]() {
+        return !_shouldRun ||
+               (_queue.size() < _depth &&
+                (_queue.empty() || _bytes + _lastWindowBytes <= _memoryCap));
+      });
+      if (!_shouldRun) {
+        break;
+      }
+    }
+
+    Prefetched p;
+    {
+      std::lock_guard<std::mutex> readerLock(_readerMutex);
+      if (!_reader->hasNextFrame()) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _exhausted = true;
+        _changed.notify_all();
+        break;
+      }
+      p.frame = _reader->nextFrame();
+      try {
+        p.window = (*_reader)(p.frame);
+        p.valid = true;
+      } catch (...) {
+        BOOST_LOG_TRIVIAL(debug) << "Prefetching frame " << p.frame
+                                 << " failed, deferring to consumer.";
+        p.valid = false;
+      }
+    }
+    p.bytes = frameWindowBytes(p.window);
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _bytes += p.bytes;
+      _lastWindowBytes = p.bytes;
+      _queue.push_back(std::move(p));
+    }
+    _changed.notify_all();
+  }
+  BOOST_LOG_TRIVIAL(debug) << "Prefetching thread terminated";
+}
+
+} // namespace MouseTrack
@@ -0,0 +1,119 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#pragma once
+
+#include "reader.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace MouseTrack {
+
+/// Decorator that reads the frame windows of the wrapped reader ahead of time
+/// on a background thread.
+///
+/// The background thread follows the `hasNextFrame()`/`nextFrame()` iteration
+/// of the wrapped reader and keeps up to `depth` frame windows in memory.
+/// `nextFrame()` and `operator()` then hand out the prefetched data. Frames
+/// that were not prefetched are read synchronously.
+///
+/// Windows count towards `memoryCap` from the moment they are read until they
+/// are handed out by `nextFrame()`, what the consumer does with them later
+/// never blocks prefetching. The next window is only read if it fits within
+/// the cap, assuming it is as large as the last one. If no window is waiting,
+/// one window is always read, even if it exceeds the cap.
+///
+/// The background thread starts with the first call to `hasNextFrame()` or
+/// `nextFrame()`: configure the frame range of the wrapped reader (e.g.
+/// `setBeginFrame`/`setEndFrame`) before that, or use `reconfigure()` to
+/// change it later.
+///
+/// The wrapped reader is never called concurrently, the decorator itself is
+/// thread-safe.
+class PrefetchingReader : public Reader {
+public:
+  PrefetchingReader(std::unique_ptr<Reader> reader, size_t depth = 4,
+                    size_t memoryCap = 1024ul * 1024 * 1024);
+
+  /// Stops the background thread
+  ~PrefetchingReader();
+
+  virtual bool valid() const;
+
+  virtual bool hasNextFrame() const;
+
+  virtual FrameNumber nextFrame();
+
+  /// Returns the prefetched frame window if available, reads synchronously
+  /// otherwise.
+  virtual FrameWindow operator()(FrameNumber f);
+
+  /// The wrapped reader is serialized internally
+  virtual bool threadSafe() const;
+
+  /// Stops the background thread, calls `change` with the wrapped reader
+  /// (e.g. to change its frame range) and continues prefetching with its new
+  /// state. Frames that were already prefetched are still handed out.
+  void reconfigure(std::function<void(Reader &)> change);
+
+  /// Maximum number of frame windows to read ahead
+  size_t depth() const;
+
+  /// Maximum number of bytes occupied by prefetched frame windows
+  size_t memoryCap() const;
+
+  /// Bytes occupied by prefetched frame windows not handed out by
+  /// `nextFrame()` yet
+  size_t prefetchedBytes() const;
+
+private:
+  struct Prefetched {
+    FrameNumber frame;
+    FrameWindow window;
+    size_t bytes;
+    /// false if reading failed, `operator()` retries synchronously
+    bool valid;
+  };
+
+  std::unique_ptr<Reader> _reader;
+  /// serializes access to `_reader`
+  mutable std::mutex _readerMutex;
+
+  const size_t _depth;
+  const size_t _memoryCap;
+
+  /// guards all members below
+  mutable std::mutex _mutex;
+  mutable std::condition_variable _changed;
+  /// read ahead, not handed out by `nextFrame()` yet
+  mutable std::deque<Prefetched> _queue;
+  /// handed out by `nextFrame()`, waiting for `operator()`
+  std::map<FrameNumber, Prefetched> _delivered;
+  /// bytes held in `_queue`, limited by `_memoryCap`
+  mutable size_t _bytes;
+  /// bytes of the last window read, estimate for the next one
+  mutable size_t _lastWindowBytes;
+  /// the wrapped reader has no frames left
+  mutable bool _exhausted;
+  mutable bool _shouldRun;
+  mutable std::thread _worker;
+
+  /// Starts the background thread if it is not running yet
+  void ensureStarted() const;
+
+  /// Stops and joins the background thread
+  void stopWorker();
+
+  /// Loop of background thread
+  void prefetch() const;
+};
+
+} // namespace MouseTrack
@@ -0,0 +1,162 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "prefetching_reader.h"
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <thread>
+
+namespace utf = boost::unit_test;
+
+namespace MouseTrack {
+namespace {
+
+/// Delivers every second frame in [begin, end), the frame number is stored in
+/// the focal length, frame 7 can not be read.
+class StepReader : public Reader {
+public:
+  StepReader(FrameNumber begin, FrameNumber end)
+      : _next(begin), _end(end), _reads(0) {
+    // empty
+  }
+  bool valid() const { return true; }
+  bool hasNextFrame() const { return _next < _end; }
+  FrameNumber nextFrame() {
+    FrameNumber f = _next;
+    _next += 2;
+    return f;
+  }
+  FrameWindow operator()(FrameNumber f) {
+    _reads += 1;
+    if (f == 7) {
+      throw "broken frame";
+    }
+    Frame frame;
+    frame.focallength = f;
+    frame.normalizedDisparityMap = DisparityMap::Zero(10, 10);
+    return FrameWindow(std::vector<Frame>{frame});
+  }
+  void setEnd(FrameNumber end) { _end = end; }
+  int reads() const { return _reads; }
+
+private:
+  FrameNumber _next;
+  FrameNumber _end;
+  int _reads;
+};
+
+} // namespace
+} // namespace MouseTrack
+
+using MouseTrack::PrefetchingReader;
+using MouseTrack::StepReader;
+
+BOOST_AUTO_TEST_CASE(prefetching_reader_follows_iteration) {
+  PrefetchingReader reader(
+      std::unique_ptr<MouseTrack::Reader>(new StepReader(1, 12)), 3);
+
+  std::vector<int> frames;
+  while (reader.hasNextFrame()) {
+    int f = reader.nextFrame();
+    frames.push_back(f);
+    if (f == 7) {
+      BOOST_CHECK_THROW(reader(f), const char *);
+      continue;
+    }
+    MouseTrack::FrameWindow window = reader(f);
+    BOOST_REQUIRE_EQUAL(window.frames().size(), 1);
+    BOOST_CHECK_EQUAL(window.frames()[0].focallength, f);
+  }
+  std::vector<int> expected{1, 3, 5, 7, 9, 11};
+  BOOST_CHECK_EQUAL_COLLECTIONS(frames.begin(), frames.end(), expected.begin(),
+                                expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(prefetching_reader_memory_cap_progress) {
+  // the cap is smaller than a single window, prefetching must still progress
+  PrefetchingReader reader(
+      std::unique_ptr<MouseTrack::Reader>(new StepReader(0, 20)), 5, 1);
+  int count = 0;
+  while (reader.hasNextFrame()) {
+    int f = reader.nextFrame();
+    BOOST_CHECK_EQUAL(reader(f).frames()[0].focallength, f);
+    count += 1;
+  }
+  BOOST_CHECK_EQUAL(count, 10);
+}
+
+BOOST_AUTO_TEST_CASE(prefetching_reader_memory_cap) {
+  // room for two and a half windows
+  const size_t windowBytes = 10 * 10 * sizeof(MouseTrack::DisparityMap::Scalar);
+  const size_t cap = 2 * windowBytes + windowBytes / 2;
+  PrefetchingReader reader(
+      std::unique_ptr<MouseTrack::Reader>(new StepReader(0, 20)), 5, cap);
+  int count = 0;
+  while (reader.hasNextFrame()) {
+    // give the background thread time to fill up to the cap
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    BOOST_CHECK_LE(reader.prefetchedBytes(), cap);
+    int f = reader.nextFrame();
+    BOOST_CHECK_LE(reader.prefetchedBytes(), cap);
+    BOOST_CHECK_EQUAL(reader(f).frames()[0].focallength, f);
+    count += 1;
+  }
+  BOOST_CHECK_EQUAL(count, 10);
+  BOOST_CHECK_EQUAL(reader.prefetchedBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(prefetching_reader_unread_frames_dont_block,
+                     *utf::timeout(60)) {
+  // windows handed out by nextFrame() but never read don't count towards the
+  // cap, e.g. if the consumer stops early or reads on other threads
+  PrefetchingReader reader(
+      std::unique_ptr<MouseTrack::Reader>(new StepReader(0, 20)), 2, 1);
+  std::vector<int> frames;
+  while (reader.hasNextFrame()) {
+    frames.push_back(reader.nextFrame());
+  }
+  BOOST_CHECK_EQUAL(frames.size(), 10);
+  BOOST_CHECK_EQUAL(reader.prefetchedBytes(), 0);
+  BOOST_CHECK_EQUAL(reader(4).frames()[0].focallength, 4);
+}
+
+BOOST_AUTO_TEST_CASE(prefetching_reader_reconfigure) {
+  PrefetchingReader reader(
+      std::unique_ptr<MouseTrack::Reader>(new StepReader(0, 4)), 2);
+  BOOST_CHECK(reader.hasNextFrame());
+  BOOST_CHECK_EQUAL(reader.nextFrame(), 0);
+  BOOST_CHECK_EQUAL(reader.nextFrame(), 2);
+  BOOST_CHECK(!reader.hasNextFrame());
+
+  reader.reconfigure([](MouseTrack::Reader &r) {
+    static_cast<StepReader &>(r).setEnd(8);
+  });
+  BOOST_CHECK(reader.hasNextFrame());
+  BOOST_CHECK_EQUAL(reader.nextFrame(), 4);
+  BOOST_CHECK_EQUAL(reader.nextFrame(), 6);
+  BOOST_CHECK(!reader.hasNextFrame());
+}
+
+BOOST_AUTO_TEST_CASE(prefetching_reader_reconfigure_while_running) {
+  PrefetchingReader reader(
+      std::unique_ptr<MouseTrack::Reader>(new StepReader(0, 40)), 3);
+  BOOST_CHECK(reader.hasNextFrame());
+  BOOST_CHECK_EQUAL(reader.nextFrame(), 0);
+
+  // the background thread is reading ahead, frames it already pulled from the
+  // wrapped reader must not be skipped
+  reader.reconfigure([](MouseTrack::Reader &r) {
+    static_cast<StepReader &>(r).setEnd(12);
+  });
+  std::vector<int> frames;
+  while (reader.hasNextFrame()) {
+    frames.push_back(reader.nextFrame());
+  }
+  std::vector<int> expected{2, 4, 6, 8, 10};
+  BOOST_CHECK_EQUAL_COLLECTIONS(frames.begin(), frames.end(), expected.begin(),
+                                expected.end());
+}
@@ -21,6 +21,10 @@ public:
   /// get available. It might also block and wait for the next frame from the
   /// network. This is implementation dependent.
   virtual FrameWindow operator()(FrameNumber f) = 0;
+
+  /// true if all methods may be called concurrently, otherwise callers need
+  /// to serialize access to the reader
+  virtual bool threadSafe() const { return false; }
 };
 
 } // namespace MouseTrack
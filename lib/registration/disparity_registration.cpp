@@ -36,7 +36,8 @@ PointCloud DisparityRegistration::operator()(const FrameWindow &window) const {
   const int border = frameBorder();
   const double xshift = correctingXShift();
   const double yshift = correctingYShift();
-  const double minDisp = minDisparity();
+  // compare in pixel precision, disparity is stored between [0,1]
+  const DisparityMap::Scalar minDisp = minDisparity() / 255.0;
   // go through each frame, converting the disparity values to 3d points
   // relative to first camera
   for (size_t i = 0; i < frames.size(); i += 1) {
@@ -45,13 +46,13 @@ PointCloud DisparityRegistration::operator()(const FrameWindow &window) const {
     // convert each pixel
     for (int y = border - 1; y < disp.rows() - border; y += 1) {
       for (int x = border - 1; x < disp.cols() - border; x += 1) {
-        // disparity is returned between [0,1],
-        // but originally stored as [0,255]
-        double disparity = 255 * disp(y, x);
-        if (disparity < minDisp) {
+        if (disp(y, x) < minDisp) {
           // just skip those points
           continue;
         }
+        // disparity is returned between [0,1],
+        // but originally stored as [0,255]
+        double disparity = 255.0 * disp(y, x);
         const double invDisparity = 1.0 / disparity;
         auto p = cloud[next_insert];
         p.x((x + xshift - f.ccx) * f.baseline * invDisparity);
@@ -64,19 +65,19 @@ PointCloud DisparityRegistration::operator()(const FrameWindow &window) const {
         p.y(tmp[1]);
         p.z(tmp[2]);
         p.intensity(f.referencePicture(y, x));
-        PointCloud::LabelVec labels(f.labels.size());
         for (size_t l = 0; l < f.labels.size(); ++l) {
-          labels[l] = f.labels[l](y, x);
+          cloud.labelData()(l, next_insert) = f.labels[l](y, x);
         }
-        p.labels(std::move(labels));
         next_insert += 1;
       }
     }
   }
   cloud.resize(next_insert, labelsCount); // shrink to actual number of points
 
-  auto min = cloud.posMin();
-  auto max = cloud.posMax();
+  // also fills the cache of the cloud for later stages
+  const PointCloud::Statistics stats = cloud.statistics();
+  const auto &min = stats.min;
+  const auto &max = stats.max;
 
   BOOST_LOG_TRIVIAL(debug) << "Found point cloud with " << cloud.size()
                            << " points, xyz-min: [" << min[0] << ", " << min[1]
@@ -0,0 +1,116 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "disparity_registration_cached.h"
+#include "disparity_registration_cpu_optimized.h"
+
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <limits>
+#include <random>
+
+namespace MouseTrack {
+namespace {
+
+FrameWindow randomWindow(int streams, int rows, int cols, int labels) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> intensity(0, 255);
+  FrameWindow window;
+  for (int s = 0; s < streams; ++s) {
+    Frame frame;
+    frame.normalizedDisparityMap.resize(rows, cols);
+    frame.referencePicture.resize(rows, cols);
+    for (int y = 0; y < rows; ++y) {
+      for (int x = 0; x < cols; ++x) {
+        frame.normalizedDisparityMap(y, x) = intensity(gen) / 255.0f;
+        frame.referencePicture(y, x) = intensity(gen) / 255.0f;
+      }
+    }
+    for (int l = 0; l < labels; ++l) {
+      Picture label(rows, cols);
+      for (int i = 0; i < label.size(); ++i) {
+        label(i) = intensity(gen) / 255.0f;
+      }
+      frame.labels.push_back(label);
+    }
+    frame.focallength = 700 + s;
+    frame.baseline = 0.023;
+    frame.ccx = cols / 2;
+    frame.ccy = rows / 2;
+    frame.rotationCorrection = Eigen::Matrix4d::Identity();
+    frame.rotationCorrection.block<3, 1>(0, 3) << 0.1, -0.2, 0.3 * s;
+    frame.camChainPicture = Eigen::Matrix4d::Identity();
+    frame.camChainPicture(0, 3) = 0.05;
+    frame.camChainDisparity = Eigen::Matrix4d::Identity();
+    window.frames().push_back(std::move(frame));
+  }
+  return window;
+}
+
+void checkSameCloud(const PointCloud &cloud, const PointCloud &expected) {
+  BOOST_REQUIRE(expected.size() > 0);
+  BOOST_REQUIRE_EQUAL(cloud.size(), expected.size());
+  BOOST_REQUIRE_EQUAL(cloud.labelsDim(), expected.labelsDim());
+  for (size_t i = 0; i < cloud.size(); ++i) {
+    // float disparities are not exactly on 1/255 steps, compare absolute
+    // (scaled by the distance for single precision clouds)
+    const double tolerance =
+        (1e-6 + 32 * std::numeric_limits<Coordinate>::epsilon()) *
+        (1 + expected[i].pos().norm());
+    const double error = (cloud[i].pos() - expected[i].pos()).norm();
+    BOOST_CHECK_SMALL(error, tolerance);
+    BOOST_CHECK_EQUAL(cloud[i].r(), expected[i].r());
+    for (int l = 0; l < cloud.labelsDim(); ++l) {
+      BOOST_CHECK_EQUAL(cloud[i].labels()[l], expected[i].labels()[l]);
+    }
+  }
+}
+
+} // namespace
+} // namespace MouseTrack
+
+BOOST_AUTO_TEST_CASE(disparity_registration_cpu_optimized_matches_reference) {
+  MouseTrack::FrameWindow window = MouseTrack::randomWindow(3, 30, 40, 2);
+
+  MouseTrack::DisparityRegistration reference;
+  reference.frameBoder() = 3;
+  MouseTrack::DisparityRegistrationCpuOptimized optimized;
+  optimized.frameBoder() = 3;
+
+  MouseTrack::checkSameCloud(optimized(window), reference(window));
+}
+
+BOOST_AUTO_TEST_CASE(disparity_registration_cached_matches_reference) {
+  MouseTrack::FrameWindow window = MouseTrack::randomWindow(3, 30, 40, 2);
+  // not on a 1/255 step, as after smoothing
+  window.frames()[1].normalizedDisparityMap(10, 10) = 0.5001f;
+
+  MouseTrack::DisparityRegistration reference;
+  reference.frameBoder() = 3;
+  MouseTrack::DisparityRegistrationCached cached;
+  cached.frameBoder() = 3;
+
+  MouseTrack::checkSameCloud(cached(window), reference(window));
+  // second call uses the cache
+  MouseTrack::checkSameCloud(cached(window), reference(window));
+}
+
+BOOST_AUTO_TEST_CASE(disparity_registration_cached_calibration_change) {
+  MouseTrack::FrameWindow window = MouseTrack::randomWindow(2, 30, 40, 0);
+
+  MouseTrack::DisparityRegistration reference;
+  reference.frameBoder() = 3;
+  MouseTrack::DisparityRegistrationCached cached;
+  cached.frameBoder() = 3;
+
+  MouseTrack::checkSameCloud(cached(window), reference(window));
+  window.frames()[1].focallength += 10;
+  window.frames()[0].camChainDisparity(1, 3) = 0.1;
+  MouseTrack::checkSameCloud(cached(window), reference(window));
+  cached.correctingXShift() = 5;
+  reference.correctingXShift() = 5;
+  MouseTrack::checkSameCloud(cached(window), reference(window));
+}
@@ -0,0 +1,190 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+
+#include "disparity_registration_cached.h"
+#include <boost/log/trivial.hpp>
+#include <cmath>
+
+namespace MouseTrack {
+
+DisparityRegistrationCached::Calibration::Calibration(const Frame &frame)
+    : focallength(frame.focallength), baseline(frame.baseline),
+      ccx(frame.ccx), ccy(frame.ccy),
+      rotationCorrection(frame.rotationCorrection),
+      camChainPicture(frame.camChainPicture),
+      camChainDisparity(frame.camChainDisparity),
+      rows(frame.normalizedDisparityMap.rows()),
+      cols(frame.normalizedDisparityMap.cols()) {
+  // empty
+}
+
+bool DisparityRegistrationCached::Calibration::
+operator==(const Calibration &o) const {
+  return focallength == o.focallength && baseline == o.baseline &&
+         ccx == o.ccx && ccy == o.ccy &&
+         rotationCorrection == o.rotationCorrection &&
+         camChainPicture == o.camChainPicture &&
+         camChainDisparity == o.camChainDisparity && rows == o.rows &&
+         cols == o.cols;
+}
+
+PointCloud DisparityRegistrationCached::
+operator()(const FrameWindow &window) const {
+  const auto &frames = window.frames();
+  if (frames.empty()) {
+    return PointCloud();
+  }
+  const std::shared_ptr<const Cache> tables = cache(window);
+
+  const int border = frameBorder();
+  // compare in pixel precision, disparity is stored between [0,1]
+  const DisparityMap::Scalar minDisp = minDisparity() / 255.0;
+  const int labelsCount = frames[0].labels.size();
+
+  // same two passes as DisparityRegistrationCpuOptimized: count points per
+  // row, then write each row to its offset
+  struct Row {
+    int frame;
+    int y;
+    int xBegin;
+    int xEnd;
+    size_t offset;
+  };
+  std::vector<Row> rows;
+  for (size_t i = 0; i < frames.size(); i += 1) {
+    const auto &disp = frames[i].normalizedDisparityMap;
+    for (int y = border - 1; y < disp.rows() - border; y += 1) {
+      rows.push_back({(int)i, y, border - 1, (int)disp.cols() - border, 0});
+    }
+  }
+  const int rowsCount = rows.size();
+
+#pragma omp parallel for
+  for (int r = 0; r < rowsCount; ++r) {
+    Row &row = rows[r];
+    const auto &disp = frames[row.frame].normalizedDisparityMap;
+    if (row.xEnd <= row.xBegin) {
+      continue;
+    }
+    row.offset = (disp.row(row.y).segment(row.xBegin, row.xEnd - row.xBegin)
+                      .array() >= minDisp)
+                     .count();
+  }
+
+  size_t pointsCount = 0;
+  for (Row &row : rows) {
+    size_t count = row.offset;
+    row.offset = pointsCount;
+    pointsCount += count;
+  }
+
+  PointCloud cloud;
+  cloud.resize(pointsCount, labelsCount);
+  auto &pos = cloud.posData();
+  auto &col = cloud.colData();
+  auto &labels = cloud.labelData();
+
+#pragma omp parallel for schedule(dynamic, 8)
+  for (int r = 0; r < rowsCount; ++r) {
+    const Row &row = rows[r];
+    const Frame &f = frames[row.frame];
+    const StreamTables &t = tables->streams[row.frame];
+    const auto &disp = f.normalizedDisparityMap;
+    const auto &picture = f.referencePicture;
+    const bool hasPicture =
+        picture.rows() == disp.rows() && picture.cols() == disp.cols();
+    const int y = row.y;
+    const Eigen::Vector3d rowRay = t.rowRays.col(y);
+
+    size_t next = row.offset;
+    for (int x = row.xBegin; x < row.xEnd; x += 1) {
+      const double d = disp(y, x);
+      if (d < minDisp) {
+        continue;
+      }
+      const double level = 255.0 * d;
+      const long index = std::lround(level);
+      double depth;
+      if (std::abs(level - index) < 1e-3 && index < 256) {
+        depth = t.depth[index];
+      } else {
+        depth = f.baseline / level;
+      }
+      pos.col(next) =
+          (depth * (t.colRays.col(x) + rowRay) + t.translation)
+              .cast<Coordinate>();
+      col.col(next).setConstant(hasPicture ? picture(y, x) : 0);
+      for (int l = 0; l < labelsCount; ++l) {
+        labels(l, next) = f.labels[l](y, x);
+      }
+      next += 1;
+    }
+  }
+
+  BOOST_LOG_TRIVIAL(debug) << "Found point cloud with " << cloud.size()
+                           << " points" << std::flush;
+  return cloud;
+}
+
+std::shared_ptr<const DisparityRegistrationCached::Cache>
+DisparityRegistrationCached::cache(const FrameWindow &window) const {
+  const auto &frames = window.frames();
+  std::lock_guard<std::mutex> lock(_cacheMutex);
+  bool valid = _cache != nullptr &&
+               _cache->calibrations.size() == frames.size() &&
+               _cache->xshift == correctingXShift() &&
+               _cache->yshift == correctingYShift();
+  for (size_t i = 0; valid && i < frames.size(); ++i) {
+    valid = _cache->calibrations[i] == Calibration(frames[i]);
+  }
+  if (!valid) {
+    BOOST_LOG_TRIVIAL(debug) << "Calibration changed, rebuilding registration "
+                                "lookup tables";
+    _cache = buildCache(window);
+  }
+  return _cache;
+}
+
+std::shared_ptr<const DisparityRegistrationCached::Cache>
+DisparityRegistrationCached::buildCache(const FrameWindow &window) const {
+  const auto &frames = window.frames();
+  auto Ts = absoluteTransformations(window);
+
+  auto result = std::make_shared<Cache>();
+  result->xshift = correctingXShift();
+  result->yshift = correctingYShift();
+  result->streams.resize(frames.size());
+  for (size_t i = 0; i < frames.size(); i += 1) {
+    const Frame &f = frames[i];
+    result->calibrations.push_back(Calibration(f));
+
+    Eigen::Matrix4d mat = f.rotationCorrection * Ts[i];
+    const Inverse inv = prepareInverseTransformation(mat);
+    const Eigen::Matrix3d rotation = inv.topLeftCorner<3, 3>();
+
+    // camera coordinates of a point at depth 1:
+    // [x + xshift - ccx, y + yshift - ccy, focallength]
+    StreamTables &t = result->streams[i];
+    const int rows = f.normalizedDisparityMap.rows();
+    const int cols = f.normalizedDisparityMap.cols();
+    t.colRays.resize(3, cols);
+    for (int x = 0; x < cols; ++x) {
+      t.colRays.col(x) = (x + result->xshift - f.ccx) * rotation.col(0);
+    }
+    t.rowRays.resize(3, rows);
+    for (int y = 0; y < rows; ++y) {
+      t.rowRays.col(y) = (y + result->yshift - f.ccy) * rotation.col(1) +
+                         f.focallength * rotation.col(2);
+    }
+    t.translation = inv.topRightCorner<3, 1>();
+
+    // disparity is returned between [0,1], but originally stored as [0,255]
+    for (size_t level = 0; level < t.depth.size(); ++level) {
+      t.depth[level] = f.baseline / level;
+    }
+  }
+  return result;
+}
+
+} // namespace MouseTrack
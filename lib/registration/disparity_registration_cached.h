@@ -0,0 +1,83 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+
+#pragma once
+
+#include "disparity_registration.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+
+namespace MouseTrack {
+
+///
+/// Registration for a fixed camera rig: everything that only depends on the
+/// calibration is computed once and reused for the following frame windows.
+///
+/// Per stream, the rays through each pixel (already rotated into the
+/// coordinate system of the first camera) and the depth of each of the 256
+/// disparity levels are cached. A point then costs two table lookups, an
+/// addition and a multiplication.
+///
+/// The ray of pixel (x, y) is separable into a column and a row part, the
+/// tables therefore need (rows + cols) instead of (rows * cols) entries and
+/// stay in cache.
+///
+/// Disparities that are not a multiple of 1/255 (e.g. after smoothing) are
+/// computed exactly instead of looked up.
+///
+/// The cache is rebuilt as soon as the calibration of any frame, the frame
+/// size or one of the correcting shifts change. Safe to call concurrently.
+///
+class DisparityRegistrationCached : public DisparityRegistration {
+public:
+  virtual PointCloud operator()(const FrameWindow &window) const;
+
+private:
+  /// Everything the tables of a stream depend on
+  struct Calibration {
+    Precision focallength;
+    Precision baseline;
+    Precision ccx;
+    Precision ccy;
+    Eigen::Matrix4d rotationCorrection;
+    Eigen::Matrix4d camChainPicture;
+    Eigen::Matrix4d camChainDisparity;
+    int rows;
+    int cols;
+
+    Calibration(const Frame &frame);
+    bool operator==(const Calibration &other) const;
+  };
+
+  struct StreamTables {
+    /// column x holds the part of the ray depending on x
+    Eigen::Matrix<double, 3, Eigen::Dynamic> colRays;
+    /// column y holds the part of the ray depending on y
+    Eigen::Matrix<double, 3, Eigen::Dynamic> rowRays;
+    /// position of the camera relative to first camera
+    Eigen::Vector3d translation;
+    /// entry i holds depth of disparity i/255 along a ray
+    std::array<double, 256> depth;
+  };
+
+  struct Cache {
+    std::vector<Calibration> calibrations;
+    int xshift;
+    int yshift;
+    std::vector<StreamTables> streams;
+  };
+
+  mutable std::mutex _cacheMutex;
+  mutable std::shared_ptr<const Cache> _cache;
+
+  /// Returns the cache for `window`, rebuilds it if necessary
+  std::shared_ptr<const Cache> cache(const FrameWindow &window) const;
+
+  /// Computes all tables for `window`
+  std::shared_ptr<const Cache> buildCache(const FrameWindow &window) const;
+};
+
+} // namespace MouseTrack
@@ -11,6 +11,9 @@ namespace MouseTrack {
 PointCloud DisparityRegistrationCpuOptimized::
 operator()(const FrameWindow &window) const {
   const auto &frames = window.frames();
+  if (frames.empty()) {
+    return PointCloud();
+  }
 
   // absolute transformation matrix relative to first camera
   auto Ts = absoluteTransformations(window);
@@ -25,105 +28,125 @@ operator()(const FrameWindow &window) const {
   const int border = frameBorder();
   const double xshift = correctingXShift();
   const double yshift = correctingYShift();
-  const double minDisp = minDisparity() / 255.0;
-
-  // flexibility to easily change row/column major
-  typedef Eigen::Matrix<double, 4, Eigen::Dynamic, Eigen::RowMajor> Mat;
-  // name indices
-  const int X = 0;
-  const int Y = 1;
-  const int D = 2;
-  const int H = 3;
-
-  // collect data in "frame" vectors
-  std::vector<Mat> framePoints(frames.size());
-  // point index to (x,y) coordinate
-  std::vector<std::vector<std::pair<int, int>>> coordinates(frames.size());
-
-  // go through each frame, converting the disparity values to 3d points
-  // relative to first camera
-#pragma omp parallel for
+  // compare in pixel precision, disparity is stored between [0,1]
+  const DisparityMap::Scalar minDisp = minDisparity() / 255.0;
+  const int labelsCount = frames[0].labels.size();
+
+  // Every row of every frame is an independent job. A first pass counts the
+  // points per row, this way each job knows where to write its points and the
+  // second pass can write straight into the cloud, without any intermediate
+  // buffers per point.
+  struct Row {
+    int frame;
+    int y;
+    int xBegin;
+    int xEnd;
+    size_t offset;
+  };
+  std::vector<Row> rows;
+  int maxCols = 0;
   for (size_t i = 0; i < frames.size(); i += 1) {
-    const auto &f = frames[i];
-    const auto &disp = f.normalizedDisparityMap;
-    int next_insert = 0;
-    int expected = disp.size();
-    // [x,y,disparity, 1]
-    Mat pixels(4, expected);
-    std::vector<std::pair<int, int>> coordinate(expected);
-    // convert each pixel
+    const auto &disp = frames[i].normalizedDisparityMap;
+    maxCols = std::max(maxCols, (int)disp.cols());
     for (int y = border - 1; y < disp.rows() - border; y += 1) {
-      for (int x = border - 1; x < disp.cols() - border; x += 1) {
-        double disparity = disp(y, x);
-        if (disparity < minDisp) {
-          // just skip those points
-          continue;
-        }
-        pixels(X, next_insert) = x;
-        pixels(Y, next_insert) = y;
-        pixels(D, next_insert) = disparity;
-        coordinate[next_insert].first = x;
-        coordinate[next_insert].second = y;
-        next_insert += 1;
-      }
+      rows.push_back({(int)i, y, border - 1, (int)disp.cols() - border, 0});
     }
+  }
+  const int rowsCount = rows.size();
 
-    // shrink down/create view with correct size
-    auto hom = pixels.block(0, 0, 4, next_insert);
-    coordinate.resize(next_insert);
-
-    // disparity is returned between [0,1], but originally stored as [0,255]
-    // 255*(f.baseline / disparity)
-    hom.row(D) = (f.baseline / 255.0) / hom.row(D).array();
-
-    // p.x() = (x + xshift - f.ccx) * (f.baseline * invDisparity);
-    hom.row(X) = (hom.row(X).array() + (xshift - f.ccx)) * hom.row(D).array();
-
-    // p.y() = (y + yshift - f.ccy) * (f.baseline * invDisparity);
-    hom.row(Y) = (hom.row(Y).array() + (yshift - f.ccy)) * hom.row(D).array();
-
-    // p.z() = f.focallength * (f.baseline * invDisparity);
-    hom.row(D) = f.focallength * hom.row(D);
-
-    // homogeneous 1
-    hom.row(H).setConstant(1.0);
-
-    // hom now holds homogeneous coordinates, find 3D points
-    framePoints[i] = applyInverseTransformation(inverses[i], hom);
-    coordinates[i] = std::move(coordinate);
+#pragma omp parallel for
+  for (int r = 0; r < rowsCount; ++r) {
+    Row &row = rows[r];
+    const auto &disp = frames[row.frame].normalizedDisparityMap;
+    if (row.xEnd <= row.xBegin) {
+      continue;
+    }
+    row.offset = (disp.row(row.y).segment(row.xBegin, row.xEnd - row.xBegin)
+                      .array() >= minDisp)
+                     .count();
   }
 
-  // merge into single point cloud
-  int points_count = 0;
-  for (auto &i : coordinates) {
-    points_count += i.size();
+  // turn counts into offsets
+  size_t pointsCount = 0;
+  for (Row &row : rows) {
+    size_t count = row.offset;
+    row.offset = pointsCount;
+    pointsCount += count;
   }
+
   PointCloud cloud;
-  cloud.resize(points_count, frames[0].labels.size());
-  // copy to cloud
-  int next_insert = 0;
-  for (size_t f = 0; f < frames.size(); ++f) {
-    const Frame &frame = frames[f];
-#pragma omp parallel for
-    for (size_t i = 0; i < coordinates[f].size(); ++i) {
-      auto p = cloud[next_insert + i];
-      p.x(framePoints[f](X, i));
-      p.y(framePoints[f](Y, i));
-      p.z(framePoints[f](D, i));
-      const int x = coordinates[f][i].first;
-      const int y = coordinates[f][i].second;
-      p.intensity(frame.referencePicture(y, x));
-      PointCloud::LabelVec labels(frame.labels.size());
-      for (int l = 0; l < labels.size(); ++l) {
-        labels[l] = frame.labels[l](y, x);
+  cloud.resize(pointsCount, labelsCount);
+  auto &pos = cloud.posData();
+  auto &col = cloud.colData();
+  auto &labels = cloud.labelData();
+
+#pragma omp parallel
+  {
+    // scratch space of this thread, allocated once
+    std::vector<int> xs(maxCols);
+    Eigen::Matrix<Coordinate, 3, Eigen::Dynamic> scratch(3, maxCols);
+
+#pragma omp for schedule(dynamic, 8)
+    for (int r = 0; r < rowsCount; ++r) {
+      const Row &row = rows[r];
+      const Frame &f = frames[row.frame];
+      const auto &disp = f.normalizedDisparityMap;
+      const int y = row.y;
+
+      // collect valid pixels of this row
+      int n = 0;
+      for (int x = row.xBegin; x < row.xEnd; x += 1) {
+        if (disp(y, x) >= minDisp) {
+          xs[n] = x;
+          n += 1;
+        }
+      }
+      if (n == 0) {
+        continue;
+      }
+
+      // camera coordinates: [x, y, z] per column
+      auto cam = scratch.leftCols(n);
+      for (int k = 0; k < n; ++k) {
+        cam(0, k) = xs[k];
+        cam(2, k) = disp(y, xs[k]);
+      }
+      // disparity is returned between [0,1], but originally stored as [0,255]
+      // baseline / (255 * disparity)
+      cam.row(2) = Coordinate(f.baseline / 255.0) / cam.row(2).array();
+      cam.row(0) = (cam.row(0).array() + Coordinate(xshift - f.ccx)) *
+                   cam.row(2).array();
+      cam.row(1) = Coordinate(y + yshift - f.ccy) * cam.row(2);
+      cam.row(2) *= Coordinate(f.focallength);
+
+      // transform relative to first camera, the inverse is affine
+      const Inverse &inv = inverses[row.frame];
+      auto target = pos.middleCols(row.offset, n);
+      target.noalias() = inv.topLeftCorner<3, 3>().cast<Coordinate>() * cam;
+      target.colwise() += inv.topRightCorner<3, 1>().cast<Coordinate>();
+
+      // attributes
+      const auto &picture = f.referencePicture;
+      if (picture.rows() == disp.rows() && picture.cols() == disp.cols()) {
+        for (int k = 0; k < n; ++k) {
+          col.col(row.offset + k).setConstant(picture(y, xs[k]));
+        }
+      } else {
+        col.middleCols(row.offset, n).setZero();
+      }
+      for (int l = 0; l < labelsCount; ++l) {
+        const auto &label = f.labels[l];
+        for (int k = 0; k < n; ++k) {
+          labels(l, row.offset + k) = label(y, xs[k]);
+        }
       }
-      p.labels(std::move(labels));
     }
-    next_insert += coordinates[f].size();
   }
 
-  auto min = cloud.posMin();
-  auto max = cloud.posMax();
+  // also fills the cache of the cloud for later stages
+  const PointCloud::Statistics stats = cloud.statistics();
+  const auto &min = stats.min;
+  const auto &max = stats.max;
 
   BOOST_LOG_TRIVIAL(debug) << "Found point cloud with " << cloud.size()
                            << " points, xyz-min: [" << min[0] << ", " << min[1]
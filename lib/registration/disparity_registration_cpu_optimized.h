@@ -11,6 +11,10 @@ namespace MouseTrack {
 ///
 /// Tries to optimize the inner loops with eigen operations.
 ///
+/// Rows of all frames are processed in parallel, each row computes its points
+/// in a vectorized fashion and writes them directly into the storage of the
+/// point cloud. The points are in the same order as with
+/// DisparityRegistration.
 ///
 class DisparityRegistrationCpuOptimized : public DisparityRegistration {
 public:
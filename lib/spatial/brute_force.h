@@ -6,16 +6,22 @@
 
 #include "spatial_oracle.h"
 #include <Eigen/Core>
+#include <algorithm>
+#include <cassert>
 #include <limits>
-#include <queue>
+#include <vector>
 
 namespace MouseTrack {
 
-/// Reference implementation,
-/// performs queries in a naive, inefficient way
+/// Reference implementation, compares each query with all points.
 /// Expects points to be Eigen col vectors of size Dim x 1
 /// The point list is a Dim x #Points eigen matrix
-
+///
+/// Batches are processed in tiles of queries and points: the squared
+/// distances of a tile are ||p||^2 + ||q||^2 - 2 p^T q, so most of the work
+/// is one matrix product (GEMM). These distances suffer from cancellation,
+/// candidates close to the radius or the k-th neighbor are checked again
+/// with the exact distance: results are the same as with a naive loop.
 template <typename _Precision, int _Dim>
 class BruteForce
     : public SpatialOracle<Eigen::Matrix<_Precision, _Dim, Eigen::Dynamic,
@@ -25,45 +31,85 @@ public:
   typedef Eigen::Matrix<_Precision, _Dim, Eigen::Dynamic,
                         Eigen::ColMajor + Eigen::AutoAlign>
       PointList;
+  typedef _Precision Precision;
+  typedef Eigen::Matrix<_Precision, _Dim, 1> Point;
+  typedef typename SpatialOracle<PointList, Precision>::Visitor Visitor;
 
 private:
+  typedef Eigen::Matrix<Precision, Eigen::Dynamic, Eigen::Dynamic> Tile;
+  typedef Eigen::Matrix<Precision, Eigen::Dynamic, 1> Norms;
+  typedef std::pair<Precision, PointIndex> Candidate;
+
+  /// Queries per tile
+  static constexpr int queryBlock = 64;
+  /// Points per tile, a tile of distances fits into the L2 cache
+  static constexpr int pointBlock = 512;
+
   const PointList *_points = nullptr;
 
-  template <typename Point>
-  std::vector<PointIndex> find_closest_for_point(const Point &p,
-                                                 unsigned int k) const {
-    typedef std::pair<Precision, PointIndex> P;
-    std::priority_queue<P> candidates;
-    auto dists = (_points->colwise() - p).colwise().squaredNorm();
-    for (int i = 0; i < dists.cols(); i += 1) {
-      Precision d = dists(0, i);
-      candidates.push(P(d, i));
-      if (candidates.size() > k) {
-        candidates.pop();
-      }
-    }
-    std::vector<PointIndex> result;
-    while (candidates.size() > 0) {
-      result.push_back(candidates.top().second);
-      candidates.pop();
-    }
-    return result;
+  /// squared norms of the points
+  Norms _norms;
+
+  Precision _maxNorm = 0;
+
+  /// Upper bound of the rounding error of a tile distance to a query with
+  /// squared norm `queryNorm`
+  Precision tolerance(Precision queryNorm) const {
+    return 4 * (_points->rows() + 2) *
+           std::numeric_limits<Precision>::epsilon() * (_maxNorm + queryNorm);
   }
 
-  template <typename Point>
-  std::vector<PointIndex> find_in_range_for_point(const Point &p,
-                                                  const Precision r) const {
-    std::vector<PointIndex> in_range;
-    Precision r2 = r * r;
-    auto diffs = _points->colwise() - p;
-    auto dists = diffs.colwise().squaredNorm();
-    for (int i = 0; i < dists.cols(); i += 1) {
-      Precision d = dists(0, i);
-      if (d < r2) {
-        in_range.push_back(i);
+  /// `tile(i, j)` is the squared distance between point `i0 + i` and query
+  /// `q0 + j` up to `tolerance()`
+  void distances(const PointList &ps, const Norms &queryNorms, int q0,
+                 int qn, int i0, int in, Tile &tile) const {
+    tile.noalias() =
+        _points->middleCols(i0, in).transpose() * ps.middleCols(q0, qn);
+    tile = (Precision(-2) * tile).colwise() + _norms.segment(i0, in);
+    tile.rowwise() += queryNorms.segment(q0, qn).transpose();
+  }
+
+  /// Calls `scan(tile, q0, qn, i0, in)` for all tiles of the batch `ps`,
+  /// `init(q0, qn)` before the first tile of a block of queries and
+  /// `finish(q0, qn)` after its last
+  template <typename Init, typename Scan, typename Finish>
+  void forEachTile(const PointList &ps, const Norms &queryNorms,
+                   const Init &init, const Scan &scan,
+                   const Finish &finish) const {
+    const int n = _points->cols();
+    const int blocks = (ps.cols() + queryBlock - 1) / queryBlock;
+    const bool parallel = ps.cols() >= SpatialImpl::minParallelQueries;
+#pragma omp parallel if (parallel)
+    {
+      Tile tile;
+#pragma omp for schedule(dynamic)
+      for (int b = 0; b < blocks; ++b) {
+        const int q0 = b * queryBlock;
+        const int qn = std::min<int>(queryBlock, ps.cols() - q0);
+        init(q0, qn);
+        for (int i0 = 0; i0 < n; i0 += pointBlock) {
+          const int in = std::min(pointBlock, n - i0);
+          distances(ps, queryNorms, q0, qn, i0, in, tile);
+          scan(tile, q0, qn, i0, in);
+        }
+        finish(q0, qn);
       }
     }
-    return in_range;
+  }
+
+  /// Drops the candidates that can't be among the k closest: their exact
+  /// distance is larger than the exact distance of the k-th candidate, even
+  /// if both tile distances are off by `tolerance`
+  static void prune(std::vector<Candidate> &candidates, unsigned int k,
+                    Precision tolerance, Precision &bound) {
+    std::nth_element(candidates.begin(), candidates.begin() + (k - 1),
+                     candidates.end());
+    bound = candidates[k - 1].first + 2 * tolerance;
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                    [bound](const Candidate &c) {
+                                      return c.first > bound;
+                                    }),
+                     candidates.end());
   }
 
 public:
@@ -71,30 +117,108 @@ public:
     // empty
   }
 
-  void compute(const PointList &points) { _points = &points; }
+  void compute(const PointList &points) {
+    _points = &points;
+    _norms = points.colwise().squaredNorm().transpose();
+    _maxNorm = points.cols() > 0 ? _norms.maxCoeff() : 0;
+  }
 
   virtual std::vector<std::vector<PointIndex>>
   find_closest(const PointList &ps, unsigned int k) const {
     assert(_points != nullptr);
     assert(k >= 1);
-    std::vector<std::vector<PointIndex>> result;
-    result.reserve(ps.size());
-    for (int c = 0; c < ps.cols(); ++c) {
-      result.push_back(find_closest_for_point(ps.col(c), k));
-    }
+    std::vector<std::vector<PointIndex>> result(ps.cols());
+    const Norms queryNorms = ps.colwise().squaredNorm().transpose();
+    // per query: tile distances of possible neighbors
+    std::vector<std::vector<Candidate>> candidates(ps.cols());
+    std::vector<Precision> bounds(ps.cols());
+    forEachTile(
+        ps, queryNorms,
+        [&](int q0, int qn) {
+          for (int j = q0; j < q0 + qn; ++j) {
+            bounds[j] = std::numeric_limits<Precision>::max();
+            candidates[j].reserve(4 * k + pointBlock);
+          }
+        },
+        [&](const Tile &tile, int q0, int qn, int i0, int in) {
+          for (int j = 0; j < qn; ++j) {
+            auto &cands = candidates[q0 + j];
+            Precision &bound = bounds[q0 + j];
+            for (int i = 0; i < in; ++i) {
+              if (tile(i, j) <= bound) {
+                cands.push_back(Candidate(tile(i, j), i0 + i));
+              }
+            }
+            if (cands.size() >= 4 * k) {
+              prune(cands, k, tolerance(queryNorms[q0 + j]), bound);
+            }
+          }
+        },
+        [&](int q0, int qn) {
+          for (int j = q0; j < q0 + qn; ++j) {
+            // exact distances, the furthest neighbor first
+            auto &cands = candidates[j];
+            for (Candidate &c : cands) {
+              c.first = (_points->col(c.second) - ps.col(j)).squaredNorm();
+            }
+            const size_t m = std::min<size_t>(k, cands.size());
+            std::partial_sort(cands.begin(), cands.begin() + m, cands.end());
+            result[j].resize(m);
+            for (size_t c = 0; c < m; ++c) {
+              result[j][m - 1 - c] = cands[c].second;
+            }
+            std::vector<Candidate>().swap(cands);
+          }
+        });
     return result;
   }
 
   virtual std::vector<std::vector<PointIndex>>
   find_in_range(const PointList &ps, const Precision r) const {
     assert(_points != nullptr);
-    std::vector<std::vector<PointIndex>> in_range;
-    in_range.reserve(ps.cols());
-    for (int c = 0; c < ps.cols(); ++c) {
-      in_range.push_back(find_in_range_for_point(ps.col(c).eval(), r));
-    }
+    std::vector<std::vector<PointIndex>> in_range(ps.cols());
+    const Norms queryNorms = ps.colwise().squaredNorm().transpose();
+    const Precision r2 = r * r;
+    forEachTile(
+        ps, queryNorms, [](int, int) {},
+        [&](const Tile &tile, int q0, int qn, int i0, int in) {
+          for (int j = 0; j < qn; ++j) {
+            const Precision bound = r2 + tolerance(queryNorms[q0 + j]);
+            for (int i = 0; i < in; ++i) {
+              // confirm candidates with the exact distance
+              if (tile(i, j) < bound &&
+                  (_points->col(i0 + i) - ps.col(q0 + j)).squaredNorm() <
+                      r2) {
+                in_range[q0 + j].push_back(i0 + i);
+              }
+            }
+          }
+        },
+        [](int, int) {});
     return in_range;
   }
+
+  virtual void visit_closest(const Point &p, unsigned int k,
+                             Visitor &visitor) const {
+    assert(_points != nullptr);
+    assert(k >= 1);
+    const PointList ps = p;
+    for (PointIndex i : find_closest(ps, k)[0]) {
+      visitor(i, (_points->col(i) - p).squaredNorm());
+    }
+  }
+
+  virtual void visit_in_range(const Point &p, const Precision r,
+                              Visitor &visitor) const {
+    assert(_points != nullptr);
+    const Precision r2 = r * r;
+    for (int i = 0; i < _points->cols(); i += 1) {
+      const Precision d = (_points->col(i) - p).squaredNorm();
+      if (d < r2) {
+        visitor(i, d);
+      }
+    }
+  }
 };
 
 // some convenient typedefs
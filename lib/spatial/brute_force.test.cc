@@ -5,6 +5,7 @@
 
 #include "brute_force.h"
 #include <Eigen/Core>
+#include <algorithm>
 #include <set>
 
 #include <boost/test/unit_test.hpp>
@@ -151,3 +152,66 @@ BOOST_AUTO_TEST_CASE(brute_force_Xd_find_closestK) {
       expected == received,
       "Expected and received set do not contain same elements.");
 }
+
+BOOST_AUTO_TEST_CASE(brute_force_parallel_batch_matches_single_queries) {
+  typedef BruteForce3d Oracle;
+  Oracle::PointList all = Oracle::PointList::Random(3, 2000);
+  Oracle::PointList queries = Oracle::PointList::Random(3, 1000);
+  Oracle oracle;
+  oracle.compute(all);
+
+  auto ranges = oracle.find_in_range(queries, 0.2);
+  auto closest = oracle.find_closest(queries, 4);
+  BOOST_REQUIRE_EQUAL(ranges.size(), queries.cols());
+  BOOST_REQUIRE_EQUAL(closest.size(), queries.cols());
+  for (int q = 0; q < queries.cols(); ++q) {
+    const Vector3d p = queries.col(q);
+    BOOST_CHECK(ranges[q] == oracle.find_in_range(p, 0.2)[0]);
+    BOOST_CHECK(closest[q] == oracle.find_closest(p, 4)[0]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(brute_force_blocked_matches_naive_distances) {
+  // far from the origin: the tiled distances suffer from cancellation
+  typedef BruteForceXd Oracle;
+  Oracle::PointList all = Oracle::PointList::Random(36, 1500);
+  all.array() += 100;
+  // duplicates tie with their original
+  all.rightCols(100) = all.leftCols(100);
+  Oracle::PointList queries = all.leftCols(300);
+  queries.array() += 0.01;
+  Oracle oracle;
+  oracle.compute(all);
+
+  const unsigned int k = 7;
+  const double r = 0.4;
+  auto closest = oracle.find_closest(queries, k);
+  auto ranges = oracle.find_in_range(queries, r);
+  for (int q = 0; q < queries.cols(); ++q) {
+    std::vector<std::pair<double, PointIndex>> naive;
+    std::vector<PointIndex> expectedRange;
+    for (int i = 0; i < all.cols(); ++i) {
+      const double d = (all.col(i) - queries.col(q)).squaredNorm();
+      naive.push_back(std::make_pair(d, i));
+      if (d < r * r) {
+        expectedRange.push_back(i);
+      }
+    }
+    std::sort(naive.begin(), naive.end());
+    BOOST_REQUIRE_EQUAL(closest[q].size(), k);
+    // the furthest neighbor comes first
+    for (unsigned int n = 0; n < k; ++n) {
+      BOOST_CHECK_EQUAL(closest[q][k - 1 - n], naive[n].second);
+    }
+    BOOST_CHECK(ranges[q] == expectedRange);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(brute_force_k_larger_than_points) {
+  BruteForce3d::PointList all = BruteForce3d::PointList::Random(3, 5);
+  BruteForce3d oracle;
+  oracle.compute(all);
+  auto closest = oracle.find_closest(Vector3d(0, 0, 0), 10);
+  BOOST_REQUIRE_EQUAL(closest.size(), 1);
+  BOOST_CHECK_EQUAL(closest[0].size(), 5);
+}
@@ -23,6 +23,8 @@ public:
                         Eigen::ColMajor + Eigen::AutoAlign>
       PointList;
   typedef _Precision Precision;
+  typedef Eigen::Matrix<_Precision, _Dim, 1> Point;
+  typedef typename SpatialOracle<PointList, Precision>::Visitor Visitor;
 
 private:
   // make sure to store one point per row for flann
@@ -38,6 +40,18 @@ private:
     return converted;
   }
 
+  const flann::Matrix<Precision> flannFrom(const Point &p) const {
+    return flann::Matrix<Precision>((Precision *)p.data(), 1, p.rows());
+  }
+
+  void visit(const std::vector<std::vector<PointIndex>> &indices,
+             const std::vector<std::vector<Precision>> &dists,
+             Visitor &visitor) const {
+    for (size_t i = 0; i < indices[0].size(); ++i) {
+      visitor(indices[0][i], dists[0][i]);
+    }
+  }
+
 public:
   virtual void compute(const PointList &srcData) {
     _points = &srcData;
@@ -88,10 +102,30 @@ public:
     auto params = flann::SearchParams(128);
     // automatically parallelize
     params.cores = 0;
-    _index->radiusSearch(query, indices, dists, r, params);
+    // L2 works on squared distances, so does the radius
+    _index->radiusSearch(query, indices, dists, r * r, params);
 
     return std::move(indices);
   }
+
+  virtual void visit_closest(const Point &p, unsigned int k,
+                             Visitor &visitor) const {
+    assert(k >= 1);
+    std::vector<std::vector<PointIndex>> indices;
+    std::vector<std::vector<Precision>> dists;
+    _index->knnSearch(flannFrom(p), indices, dists, k,
+                      flann::SearchParams(128));
+    visit(indices, dists, visitor);
+  }
+
+  virtual void visit_in_range(const Point &p, const Precision r,
+                              Visitor &visitor) const {
+    std::vector<std::vector<PointIndex>> indices;
+    std::vector<std::vector<Precision>> dists;
+    _index->radiusSearch(flannFrom(p), indices, dists, r * r,
+                         flann::SearchParams(128));
+    visit(indices, dists, visitor);
+  }
 };
 
 typedef Flann<double, -1> FlannXd;
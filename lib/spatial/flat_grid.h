@@ -0,0 +1,509 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+
+#pragma once
+
+#include "cubic_neighborhood.h"
+#include "spatial_oracle.h"
+#include <Eigen/Core>
+#include <boost/log/trivial.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+
+namespace MouseTrack {
+
+using namespace SpatialImpl;
+
+/// Same idea as UniformGrid, but the grid is stored in flat arrays
+/// (compressed sparse row layout) instead of one vector per cell.
+///
+/// Each point gets the linear id of its cell, the point indices are then
+/// sorted by cell id: `_order[_offsets[c]] ... _order[_offsets[c + 1] - 1]`
+/// are the points in cell slot `c`. If the grid has few enough cells, the
+/// slot is the cell id itself and the points are counting sorted. Otherwise
+/// only occupied cells get a slot and are looked up with a binary search.
+///
+/// With `reorder` set, the point coordinates are copied in cell order, so
+/// the points of a cell are adjacent in memory during queries.
+template <typename _Precision, int _Dim>
+class FlatGrid
+    : public SpatialOracle<Eigen::Matrix<_Precision, _Dim, Eigen::Dynamic,
+                                         Eigen::ColMajor + Eigen::AutoAlign>,
+                           _Precision> {
+public:
+  typedef Eigen::Matrix<_Precision, _Dim, Eigen::Dynamic,
+                        Eigen::ColMajor + Eigen::AutoAlign>
+      PointList;
+  typedef Eigen::Matrix<_Precision, _Dim, 1> Point;
+  typedef _Precision Precision;
+  typedef typename SpatialOracle<PointList, Precision>::Visitor Visitor;
+
+private:
+  typedef std::int64_t CellId;
+  typedef CellCoordinate<_Dim> Cell;
+  typedef Eigen::Matrix<CellId, _Dim, 1> Strides;
+  typedef CubicNeighborhood<_Dim> _Neighborhood;
+
+  /// Points over which we perform queries
+  const PointList *points = nullptr;
+
+  /// `points` in cell order, only used with `reorder`
+  PointList sorted;
+
+  bool reorder;
+
+  Precision maxR;
+
+  int dims;
+
+  /// Minimum point of bounding box
+  Point bb_min;
+
+  /// Width of a cell as configured
+  Precision targetCellWidth;
+
+  /// Width of a cell used by the last `compute()`, coarser than
+  /// `targetCellWidth` if the bounding box needs too many cells
+  Precision cellWidth;
+
+  _Neighborhood neighborhood;
+
+  /// A neighborhood layer with precomputed cell id offsets
+  struct Layer {
+    /// minimal distance of a point in this layer to any point of the center
+    /// cell, measured in cell counts
+    double min;
+    /// cell id offsets of the cells in this layer
+    std::vector<CellId> ids;
+    /// relative cell coordinates, `dims` entries per cell
+    std::vector<int> coords;
+  };
+  std::vector<Layer> layers;
+
+  /// Rows are runs of cells along the first dimension, they are adjacent in
+  /// `_order`. A row is given by its cell id offset (without first
+  /// dimension) and coordinates in the remaining dimensions, sorted by
+  /// their largest coordinate magnitude.
+  std::vector<CellId> rowIds;
+  /// `dims - 1` entries per row
+  std::vector<int> rowCoords;
+  /// `rowsUpTo[l]`: number of rows with coordinates in [-l, l]
+  std::vector<size_t> rowsUpTo;
+
+  Cell resolution;
+
+  /// cell id = sum of cell coordinate times stride
+  Strides strides;
+
+  /// true: slot = cell id, false: slot = index in `_cellIds`
+  bool dense;
+
+  /// sorted ids of occupied cells, only if not `dense`
+  std::vector<CellId> _cellIds;
+
+  /// points of slot c: `_order[_offsets[c]]` to `_order[_offsets[c + 1]]`
+  std::vector<PointIndex> _offsets;
+
+  /// point indices sorted by cell id
+  std::vector<PointIndex> _order;
+
+  /// Upper limit of cells for `dense`: cells per point
+  static constexpr int denseCellsPerPoint = 4;
+
+  /// Supported dimensions for dynamic sized grids
+  static constexpr int maxDims = 16;
+
+  /// Like Cell, but never allocates memory
+  typedef Eigen::Matrix<int, _Dim, 1, Eigen::ColMajor,
+                        (_Dim == -1 ? maxDims : _Dim), 1>
+      QueryCell;
+
+  template <typename P> QueryCell indexOfPosition(const P &p) const {
+    QueryCell index =
+        ((p - bb_min) / cellWidth).array().floor().template cast<int>();
+    return index;
+  }
+
+  /// Is `cell` + `offset` inside the bounding box?
+  bool in_bb(const QueryCell &cell, const int *offset) const {
+    for (int d = 0; d < cell.rows(); d += 1) {
+      const int c = cell[d] + offset[d];
+      if (c < 0 || resolution[d] <= c) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <typename C> CellId cellId(const C &cell) const {
+    return cell.template cast<CellId>().dot(strides);
+  }
+
+  /// Range in `_order` of the points in the cells with ids in
+  /// [`first`, `last`]
+  std::pair<PointIndex, PointIndex> cellRange(CellId first,
+                                              CellId last) const {
+    if (dense) {
+      return std::make_pair(_offsets[first], _offsets[last + 1]);
+    }
+    auto begin = std::lower_bound(_cellIds.begin(), _cellIds.end(), first);
+    auto end = std::lower_bound(begin, _cellIds.end(), last + 1);
+    return std::make_pair(_offsets[begin - _cellIds.begin()],
+                          _offsets[end - _cellIds.begin()]);
+  }
+
+  /// Rows of cells in [-maxLayer, maxLayer] around the center cell
+  void createRows(int dim) {
+    const int maxLayer = neighborhood.size() - 1;
+    std::vector<std::pair<int, std::vector<int>>> rows;
+    std::vector<int> coord(dim - 1, -maxLayer);
+    while (true) {
+      int norm = 0;
+      for (int c : coord) {
+        norm = std::max(norm, std::abs(c));
+      }
+      rows.push_back(std::make_pair(norm, coord));
+      int d = 0;
+      for (; d < dim - 1; d += 1) {
+        if (coord[d] < maxLayer) {
+          coord[d] += 1;
+          break;
+        }
+        coord[d] = -maxLayer;
+      }
+      if (d == dim - 1) {
+        break;
+      }
+    }
+    std::stable_sort(rows.begin(), rows.end(),
+                     [](const std::pair<int, std::vector<int>> &a,
+                        const std::pair<int, std::vector<int>> &b) {
+                       return a.first < b.first;
+                     });
+    rowIds.resize(rows.size());
+    rowCoords.resize(rows.size() * (dim - 1));
+    rowsUpTo.assign(maxLayer + 1, 0);
+    for (size_t i = 0; i < rows.size(); i += 1) {
+      rowIds[i] = 0;
+      for (int d = 1; d < dim; d += 1) {
+        rowIds[i] += rows[i].second[d - 1] * strides[d];
+        rowCoords[i * (dim - 1) + d - 1] = rows[i].second[d - 1];
+      }
+      rowsUpTo[rows[i].first] += 1;
+    }
+    for (int l = 1; l <= maxLayer; l += 1) {
+      rowsUpTo[l] += rowsUpTo[l - 1];
+    }
+  }
+
+  /// Coordinates of the k-th point in cell order
+  typename PointList::ConstColXpr sortedPoint(PointIndex k) const {
+    return reorder ? sorted.col(k) : points->col(_order[k]);
+  }
+
+  void createNeighborhood() {
+    neighborhood = _Neighborhood(std::ceil(maxR / cellWidth) + 1, dims);
+  }
+
+  /// recache data
+  void _compute() {
+    assert(points != nullptr);
+    const PointIndex n = points->cols();
+    _cellIds.clear();
+    _offsets.assign(1, 0);
+    _order.clear();
+    if (n == 0) {
+      return;
+    }
+    bb_min = points->rowwise().minCoeff();
+    Point bb_max = points->rowwise().maxCoeff();
+    Point bb_size = bb_max - bb_min;
+
+    // add some buffer for rounding errors
+    bb_min -= bb_size * .1;
+    bb_max += bb_size * .1;
+    bb_size = bb_max - bb_min;
+
+    // the cell ids need to fit into CellId, coarsen the grid otherwise
+    const Precision previousCellWidth = cellWidth;
+    cellWidth = targetCellWidth;
+    while (true) {
+      double cells = 1;
+      for (int d = 0; d < bb_size.rows(); d += 1) {
+        cells *= std::max(1.0, std::ceil(double(bb_size[d]) / cellWidth));
+      }
+      if (cells < double(std::numeric_limits<CellId>::max() / 4)) {
+        break;
+      }
+      cellWidth *= 2;
+      BOOST_LOG_TRIVIAL(debug)
+          << "FlatGrid: too many cells, increasing cell width to "
+          << cellWidth;
+    }
+    if (cellWidth != previousCellWidth) {
+      createNeighborhood();
+    }
+
+    resolution.resize(bb_size.rows());
+    strides.resize(bb_size.rows());
+    CellId stride = 1;
+    for (int d = 0; d < bb_size.rows(); d += 1) {
+      resolution[d] =
+          std::max(Precision(1), std::ceil(bb_size[d] / cellWidth));
+      strides[d] = stride;
+      stride *= resolution[d];
+    }
+    const CellId cells = stride;
+
+    layers.resize(neighborhood.size());
+    for (int l = 0; l < neighborhood.size(); l += 1) {
+      const auto &layer = neighborhood[l];
+      // layer.min() is measured from the center of the center cell, but the
+      // query point can be anywhere in the center cell
+      layers[l].min = std::max(0.0, layer.min() - .5);
+      layers[l].ids.resize(layer.size());
+      layers[l].coords.resize(layer.size() * bb_size.rows());
+      for (int i = 0; i < layer.size(); i += 1) {
+        const Cell cell = layer[i];
+        layers[l].ids[i] = cellId(cell);
+        for (int d = 0; d < bb_size.rows(); d += 1) {
+          layers[l].coords[i * bb_size.rows() + d] = cell[d];
+        }
+      }
+    }
+
+    createRows(bb_size.rows());
+
+    std::vector<CellId> ids(n);
+    for (PointIndex i = 0; i < n; i += 1) {
+      ids[i] = cellId(indexOfPosition(points->col(i)));
+    }
+
+    _order.resize(n);
+    dense = cells <= double(denseCellsPerPoint) * n + 1024;
+    if (dense) {
+      // counting sort
+      _offsets.assign(cells + 1, 0);
+      for (PointIndex i = 0; i < n; i += 1) {
+        _offsets[ids[i] + 1] += 1;
+      }
+      for (size_t c = 1; c < _offsets.size(); c += 1) {
+        _offsets[c] += _offsets[c - 1];
+      }
+      std::vector<PointIndex> next(_offsets.begin(), _offsets.end() - 1);
+      for (PointIndex i = 0; i < n; i += 1) {
+        _order[next[ids[i]]++] = i;
+      }
+    } else {
+      std::vector<std::pair<CellId, PointIndex>> keyed(n);
+      for (PointIndex i = 0; i < n; i += 1) {
+        keyed[i] = std::make_pair(ids[i], i);
+      }
+      std::sort(keyed.begin(), keyed.end());
+      for (PointIndex i = 0; i < n; i += 1) {
+        _order[i] = keyed[i].second;
+        if (i == 0 || keyed[i].first != keyed[i - 1].first) {
+          if (i != 0) {
+            _offsets.push_back(i);
+          }
+          _cellIds.push_back(keyed[i].first);
+        }
+      }
+      _offsets.push_back(n);
+    }
+
+    if (reorder) {
+      sorted.resize(points->rows(), n);
+      for (PointIndex i = 0; i < n; i += 1) {
+        sorted.col(i) = points->col(_order[i]);
+      }
+    } else {
+      sorted.resize(points->rows(), 0);
+    }
+  }
+
+public:
+  /// Create a grid with a cell size of `cellWidth` and support
+  /// for range queries of up to `maxR`.
+  ///
+  /// `reorder`: keep a copy of the points in cell order
+  FlatGrid(Precision maxR, Precision cellWidth, int dims = -1,
+           bool reorder = true)
+      : reorder(reorder), maxR(maxR), dims(dims), targetCellWidth(cellWidth),
+        cellWidth(cellWidth) {
+    assert(cellWidth > 0);
+    if (_Dim == -1 && dims > maxDims) {
+      throw "FlatGrid supports at most 16 dimensions.";
+    }
+    createNeighborhood();
+  }
+
+  virtual void compute(const PointList &src) {
+    points = &src;
+    _compute();
+  }
+
+  /// Cell width used by the last `compute()`, might be coarser than
+  /// configured for huge bounding boxes
+  Precision currentCellWidth() const { return cellWidth; }
+
+  virtual std::vector<std::vector<PointIndex>>
+  find_closest(const PointList &ps, unsigned int k) const {
+    assert(points != nullptr);
+    assert(k >= 1);
+    std::vector<std::vector<PointIndex>> results(ps.cols());
+    const bool parallel = ps.cols() >= minParallelQueries;
+#pragma omp parallel for schedule(dynamic, 16) if (parallel)
+    for (int pi = 0; pi < ps.cols(); ++pi) {
+      auto neighbors = closest(ps.col(pi), k);
+      while (neighbors.size() > 0) {
+        auto i = neighbors.top().second;
+        if (i != (PointIndex)-1) {
+          results[pi].push_back(i);
+        }
+        neighbors.pop();
+      }
+    }
+    return results;
+  }
+
+  virtual std::vector<std::vector<PointIndex>>
+  find_in_range(const PointList &ps, const Precision r) const {
+    assert(points != nullptr);
+    std::vector<std::vector<PointIndex>> ranges(ps.cols());
+    const bool parallel = ps.cols() >= minParallelQueries;
+#pragma omp parallel for schedule(dynamic, 16) if (parallel)
+    for (int pi = 0; pi < ps.cols(); ++pi) {
+      auto &range = ranges[pi];
+      forEachInRange(ps.col(pi), r,
+                     [&range](PointIndex c, Precision) { range.push_back(c); });
+    }
+    return ranges;
+  }
+
+  virtual void visit_closest(const Point &p, unsigned int k,
+                             Visitor &visitor) const {
+    assert(points != nullptr);
+    assert(k >= 1);
+    auto neighbors = closest(p, k);
+    while (neighbors.size() > 0) {
+      if (neighbors.top().second != (PointIndex)-1) {
+        visitor(neighbors.top().second, neighbors.top().first);
+      }
+      neighbors.pop();
+    }
+  }
+
+  virtual void visit_in_range(const Point &p, const Precision r,
+                              Visitor &visitor) const {
+    assert(points != nullptr);
+    forEachInRange(p, r, [&visitor](PointIndex c, Precision dist) {
+      visitor(c, dist);
+    });
+  }
+
+private:
+  typedef std::pair<Precision, PointIndex> Candidate;
+
+  /// The `k` closest points to `p` with their squared distances, the
+  /// furthest on top. Contains a placeholder with index -1 if there are less
+  /// than `k` points in the neighborhood.
+  template <typename P>
+  std::priority_queue<Candidate> closest(const P &p, unsigned int k) const {
+    std::priority_queue<Candidate> neighbors;
+    neighbors.push(
+        Candidate(std::numeric_limits<Precision>::max(), (PointIndex)-1));
+    if (_order.empty()) {
+      return neighbors;
+    }
+    // search the cube shaped layers around the cell of p from the inside
+    // to the outside, see UniformGrid
+    const QueryCell zeroCell = indexOfPosition(p);
+    const CellId zeroId = cellId(zeroCell);
+    for (const Layer &layer : layers) {
+      double layerDist = layer.min * cellWidth;
+      if (neighbors.top().first < layerDist * layerDist) {
+        break;
+      }
+      for (size_t i = 0; i < layer.ids.size(); ++i) {
+        if (!in_bb(zeroCell, &layer.coords[i * zeroCell.rows()])) {
+          continue;
+        }
+        const CellId id = zeroId + layer.ids[i];
+        const auto range = cellRange(id, id);
+        for (PointIndex c = range.first; c < range.second; ++c) {
+          Precision dist = (sortedPoint(c) - p).squaredNorm();
+          if (dist < neighbors.top().first) {
+            neighbors.push(Candidate(dist, _order[c]));
+            if (neighbors.size() > k) {
+              neighbors.pop();
+            }
+          }
+        }
+      }
+    }
+    return neighbors;
+  }
+
+  /// Calls `f(index, squaredDistance)` for all points within distance `r`
+  /// around `p`
+  template <typename P, typename F>
+  void forEachInRange(const P &p, const Precision r, const F &f) const {
+    if (_order.empty()) {
+      return;
+    }
+    const Precision r2 = r * r;
+    // cells further than `layer` cells away don't contain points within r
+    const int maxLayer = rowsUpTo.size() - 1;
+    const int layer =
+        std::min<double>(maxLayer, std::floor(r / cellWidth) + 1);
+    const int dim = resolution.rows();
+    const QueryCell zeroCell = indexOfPosition(p);
+    // scan rows of cells along the first dimension in one go
+    const int first = std::max(0, zeroCell[0] - layer);
+    const int last = std::min(resolution[0] - 1, zeroCell[0] + layer);
+    if (last < first) {
+      return;
+    }
+    const CellId rowStart = cellId(zeroCell) - zeroCell[0];
+    for (size_t row = 0; row < rowsUpTo[layer]; row += 1) {
+      const int *coords = &rowCoords[row * (dim - 1)];
+      bool inside = true;
+      for (int d = 1; d < dim && inside; d += 1) {
+        const int c = zeroCell[d] + coords[d - 1];
+        inside = 0 <= c && c < resolution[d];
+      }
+      if (!inside) {
+        continue;
+      }
+      const CellId rowId = rowStart + rowIds[row];
+      const auto range = cellRange(rowId + first, rowId + last);
+      for (PointIndex c = range.first; c < range.second; ++c) {
+        const Precision dist = (sortedPoint(c) - p).squaredNorm();
+        if (dist <= r2) {
+          f(_order[c], dist);
+        }
+      }
+    }
+  }
+};
+
+typedef FlatGrid<double, -1> FlatGridXd;
+typedef FlatGrid<double, 1> FlatGrid1d;
+typedef FlatGrid<double, 2> FlatGrid2d;
+typedef FlatGrid<double, 3> FlatGrid3d;
+typedef FlatGrid<double, 4> FlatGrid4d;
+typedef FlatGrid<double, 5> FlatGrid5d;
+
+typedef FlatGrid<float, -1> FlatGridXf;
+typedef FlatGrid<float, 1> FlatGrid1f;
+typedef FlatGrid<float, 2> FlatGrid2f;
+typedef FlatGrid<float, 3> FlatGrid3f;
+typedef FlatGrid<float, 4> FlatGrid4f;
+typedef FlatGrid<float, 5> FlatGrid5f;
+
+} // namespace MouseTrack
@@ -0,0 +1,102 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "flat_grid.h"
+#include "oracle_test_util.h"
+#include <Eigen/Core>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+namespace utf = boost::unit_test;
+
+using namespace MouseTrack;
+using namespace Eigen;
+using namespace MouseTrack::OracleTest;
+
+namespace {
+
+FlatGrid4d::PointList flatGridTestPoints() {
+  FlatGrid4d::PointList all(4, 5);
+  all.col(0) = Vector4d(0.0, 0.0, 0.0, 0.0);
+  all.col(1) = Vector4d(2.0, 2.0, 2.0, 2.0);
+  all.col(2) = Vector4d(10.0, 0.0, 0.0, 0.0);
+  all.col(3) = Vector4d(0.0, -1.0, -1.0, -1.0);
+  all.col(4) = Vector4d(10.0, 1.0, 1.0, 1.0);
+  return all;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(flat_grid_4d_in_range) {
+  const auto all = flatGridTestPoints();
+  FlatGrid4d oracle(2, 10.0 / 20);
+  oracle.compute(all);
+
+  Matrix<double, 4, 2> query;
+  query.col(0) = Vector4d(9.5, 0, 0, 0);
+  query.col(1) = Vector4d(0.1, 0.0, 0, 0);
+  auto result = oracle.find_in_range(query, 2);
+
+  std::multiset<PointIndex> received0(result[0].begin(), result[0].end());
+  std::multiset<PointIndex> received1(result[1].begin(), result[1].end());
+  BOOST_CHECK(received0 == std::multiset<PointIndex>({2, 4}));
+  BOOST_CHECK(received1 == std::multiset<PointIndex>({0, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(flat_grid_4d_find_closest) {
+  const auto all = flatGridTestPoints();
+  FlatGrid4d oracle(2, 10.0 / 20, -1, false);
+  oracle.compute(all);
+
+  Matrix<double, 4, 2> query;
+  query.col(0) = Vector4d(10.1, 0.9, 0.9, 0.9);
+  query.col(1) = Vector4d(0.1, 0.1, 0.1, 0.1);
+
+  auto result = oracle.find_closest(query, 1);
+  BOOST_REQUIRE_EQUAL(result[0].size(), 1);
+  BOOST_CHECK_EQUAL(result[0][0], 4);
+  BOOST_REQUIRE_EQUAL(result[1].size(), 1);
+  BOOST_CHECK_EQUAL(result[1][0], 0);
+}
+
+BOOST_AUTO_TEST_CASE(flat_grid_empty) {
+  FlatGrid3d::PointList none(3, 0);
+  FlatGrid3d oracle(1, 0.5);
+  oracle.compute(none);
+  auto result = oracle.find_in_range(Vector3d(0, 0, 0), 1);
+  BOOST_REQUIRE_EQUAL(result.size(), 1);
+  BOOST_CHECK(result[0].empty());
+}
+
+BOOST_AUTO_TEST_CASE(flat_grid_coarsening_is_per_compute) {
+  FlatGrid3d oracle(1, 0.5);
+  FlatGrid3d::PointList huge(3, 2);
+  huge.col(0) = Vector3d(0, 0, 0);
+  huge.col(1) = Vector3d(1e9, 1e9, 1e9);
+  oracle.compute(huge);
+  BOOST_CHECK_GT(oracle.currentCellWidth(), 0.5);
+
+  // the next frame uses the configured width again
+  FlatGrid3d::PointList small(3, 2);
+  small.col(0) = Vector3d(0, 0, 0);
+  small.col(1) = Vector3d(0.9, 0, 0);
+  oracle.compute(small);
+  BOOST_CHECK_EQUAL(oracle.currentCellWidth(), 0.5);
+  auto result = oracle.find_in_range(Vector3d(0, 0, 0), 1);
+  BOOST_REQUIRE_EQUAL(result.size(), 1);
+  BOOST_CHECK_EQUAL(result[0].size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(flat_grid_matches_brute_force_dense) {
+  FlatGrid3d grid(0.3, 0.1);
+  compareWithBruteForce(grid, 3, 2000, 0.3, 3);
+}
+
+BOOST_AUTO_TEST_CASE(flat_grid_matches_brute_force_sparse) {
+  // many more cells than points: occupied cells are binary searched
+  FlatGridXf grid(1.0, 0.5, 5, false);
+  compareWithBruteForce(grid, 5, 500, 0.4, 3);
+}
@@ -0,0 +1,195 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+
+#pragma once
+
+#include "flat_grid.h"
+#include "spatial_oracle.h"
+#include <Eigen/Core>
+#include <cassert>
+#include <limits>
+#include <queue>
+
+namespace MouseTrack {
+
+using namespace SpatialImpl;
+
+/// Grid over the first three (spatial) coordinates only, the remaining
+/// dimensions (intensity, labels, ...) are checked on the candidates.
+///
+/// The number of cells a grid visits grows exponentially with the number of
+/// dimensions, the spatial part of a point cloud however is well separated
+/// by three dimensions already. The spatial distance is a lower bound of the
+/// full distance, so all points within distance r are among the points
+/// within spatial distance r: results are exact.
+///
+/// Like the other grids, range queries are supported up to `maxR`. A knn
+/// query falls back to a linear scan if the k-th neighbor is further away.
+template <typename _Precision, int _Dim>
+class HybridGrid
+    : public SpatialOracle<Eigen::Matrix<_Precision, _Dim, Eigen::Dynamic,
+                                         Eigen::ColMajor + Eigen::AutoAlign>,
+                           _Precision> {
+public:
+  typedef Eigen::Matrix<_Precision, _Dim, Eigen::Dynamic,
+                        Eigen::ColMajor + Eigen::AutoAlign>
+      PointList;
+  typedef Eigen::Matrix<_Precision, _Dim, 1> Point;
+  typedef _Precision Precision;
+  typedef typename SpatialOracle<PointList, Precision>::Visitor Visitor;
+
+  /// Number of indexed dimensions
+  static constexpr int spatialDims = 3;
+
+  /// Create a grid over the spatial coordinates with a cell size of
+  /// `cellWidth` and support for range queries of up to `maxR`.
+  HybridGrid(Precision maxR, Precision cellWidth)
+      : maxR(maxR), grid(maxR, cellWidth) {
+    // empty
+  }
+
+  virtual void compute(const PointList &src) {
+    if (src.rows() < spatialDims) {
+      throw "HybridGrid needs at least three dimensions.";
+    }
+    points = &src;
+    spatial = src.topRows(spatialDims);
+    grid.compute(spatial);
+  }
+
+  virtual std::vector<std::vector<PointIndex>>
+  find_closest(const PointList &ps, unsigned int k) const {
+    assert(points != nullptr);
+    assert(k >= 1);
+    std::vector<std::vector<PointIndex>> results(ps.cols());
+    const bool parallel = ps.cols() >= minParallelQueries;
+#pragma omp parallel for schedule(dynamic, 16) if (parallel)
+    for (int pi = 0; pi < ps.cols(); ++pi) {
+      auto neighbors = closest(ps.col(pi), k);
+      results[pi].reserve(neighbors.size());
+      while (neighbors.size() > 0) {
+        results[pi].push_back(neighbors.top().second);
+        neighbors.pop();
+      }
+    }
+    return results;
+  }
+
+  virtual std::vector<std::vector<PointIndex>>
+  find_in_range(const PointList &ps, const Precision r) const {
+    assert(points != nullptr);
+    std::vector<std::vector<PointIndex>> ranges(ps.cols());
+    const bool parallel = ps.cols() >= minParallelQueries;
+#pragma omp parallel for schedule(dynamic, 16) if (parallel)
+    for (int pi = 0; pi < ps.cols(); ++pi) {
+      auto &range = ranges[pi];
+      forEachInRange(ps.col(pi), r,
+                     [&range](PointIndex c, Precision) { range.push_back(c); });
+    }
+    return ranges;
+  }
+
+  virtual void visit_closest(const Point &p, unsigned int k,
+                             Visitor &visitor) const {
+    assert(points != nullptr);
+    assert(k >= 1);
+    auto neighbors = closest(p, k);
+    while (neighbors.size() > 0) {
+      visitor(neighbors.top().second, neighbors.top().first);
+      neighbors.pop();
+    }
+  }
+
+  virtual void visit_in_range(const Point &p, const Precision r,
+                              Visitor &visitor) const {
+    assert(points != nullptr);
+    forEachInRange(p, r, [&visitor](PointIndex c, Precision dist) {
+      visitor(c, dist);
+    });
+  }
+
+private:
+  typedef FlatGrid<Precision, spatialDims> SpatialGrid;
+  typedef std::pair<Precision, PointIndex> Candidate;
+
+  /// Completes the spatial distance of the grid's candidates with the
+  /// remaining dimensions, forwards the points within `r2`
+  template <typename P, typename F>
+  class Filter : public SpatialGrid::Visitor {
+  public:
+    Filter(const PointList &points, const P &p, Precision r2, const F &f)
+        : points(points), p(p), r2(r2), f(f) {}
+    void operator()(PointIndex i, Precision spatialDist) {
+      const Precision dist =
+          spatialDist + (points.col(i).tail(points.rows() - spatialDims) -
+                         p.tail(points.rows() - spatialDims))
+                            .squaredNorm();
+      if (dist <= r2) {
+        f(i, dist);
+      }
+    }
+
+  private:
+    const PointList &points;
+    const P &p;
+    const Precision r2;
+    const F &f;
+  };
+
+  Precision maxR;
+
+  /// Points over which we perform queries
+  const PointList *points = nullptr;
+
+  /// spatial coordinates of `points`
+  typename SpatialGrid::PointList spatial;
+
+  SpatialGrid grid;
+
+  /// Calls `f(index, squaredDistance)` for all points within distance `r`
+  /// around `p`
+  template <typename P, typename F>
+  void forEachInRange(const P &p, const Precision r, const F &f) const {
+    const typename SpatialGrid::Point spatialP = p.head(spatialDims);
+    Filter<P, F> filter(*points, p, r * r, f);
+    grid.visit_in_range(spatialP, r, filter);
+  }
+
+  /// The `k` closest points to `p` with their squared distances, the
+  /// furthest on top.
+  template <typename P>
+  std::priority_queue<Candidate> closest(const P &p, unsigned int k) const {
+    std::priority_queue<Candidate> neighbors;
+    auto add = [&neighbors, k](PointIndex i, Precision dist) {
+      if (neighbors.size() < k || dist < neighbors.top().first) {
+        neighbors.push(Candidate(dist, i));
+        if (neighbors.size() > k) {
+          neighbors.pop();
+        }
+      }
+    };
+    forEachInRange(p, maxR, add);
+    if (neighbors.size() == k || PointIndex(points->cols()) == 0) {
+      // every point closer than the k-th neighbor is within maxR
+      return neighbors;
+    }
+    neighbors = std::priority_queue<Candidate>();
+    for (PointIndex i = 0; i < PointIndex(points->cols()); i += 1) {
+      add(i, (points->col(i) - p).squaredNorm());
+    }
+    return neighbors;
+  }
+};
+
+typedef HybridGrid<double, -1> HybridGridXd;
+typedef HybridGrid<double, 3> HybridGrid3d;
+typedef HybridGrid<double, 4> HybridGrid4d;
+typedef HybridGrid<double, 5> HybridGrid5d;
+
+typedef HybridGrid<float, -1> HybridGridXf;
+typedef HybridGrid<float, 3> HybridGrid3f;
+typedef HybridGrid<float, 4> HybridGrid4f;
+typedef HybridGrid<float, 5> HybridGrid5f;
+
+} // namespace MouseTrack
@@ -0,0 +1,85 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "brute_force.h"
+#include "hybrid_grid.h"
+#include "oracle_factory.h"
+#include <Eigen/Core>
+#include <map>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+namespace utf = boost::unit_test;
+
+using namespace MouseTrack;
+using namespace Eigen;
+
+BOOST_AUTO_TEST_CASE(hybrid_grid_matches_brute_force) {
+  typedef HybridGridXd Oracle;
+  // three spatial dimensions, intensity and two labels
+  Oracle::PointList points = Oracle::PointList::Random(6, 2000);
+  Oracle::PointList queries = Oracle::PointList::Random(6, 300);
+  Oracle oracle(0.5, 0.1);
+  oracle.compute(points);
+  BruteForceXd reference;
+  reference.compute(points);
+
+  auto ranges = oracle.find_in_range(queries, 0.5);
+  auto expectedRanges = reference.find_in_range(queries, 0.5);
+  // k large enough that some queries need the linear fallback
+  auto closest = oracle.find_closest(queries, 20);
+  auto expectedClosest = reference.find_closest(queries, 20);
+  for (int q = 0; q < queries.cols(); ++q) {
+    std::set<PointIndex> received(ranges[q].begin(), ranges[q].end());
+    BOOST_CHECK_EQUAL(received.size(), ranges[q].size());
+    BOOST_CHECK(received == std::set<PointIndex>(expectedRanges[q].begin(),
+                                                 expectedRanges[q].end()));
+    BOOST_CHECK(std::set<PointIndex>(closest[q].begin(), closest[q].end()) ==
+                std::set<PointIndex>(expectedClosest[q].begin(),
+                                     expectedClosest[q].end()));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(hybrid_grid_visitor_distances) {
+  HybridGrid5d::PointList points(5, 3);
+  points.col(0) << 0, 0, 0, 0, 0;
+  points.col(1) << 0, 0, 0, 3, 0;
+  points.col(2) << 1, 0, 0, 0, 1;
+  HybridGrid5d oracle(2, 0.5);
+  oracle.compute(points);
+
+  struct Recorder : public HybridGrid5d::Visitor {
+    std::map<PointIndex, double> visited;
+    void operator()(PointIndex i, double d) { visited[i] = d; }
+  };
+  Recorder inRange;
+  HybridGrid5d::Point p;
+  p << 0, 0, 0, 0, 0.5;
+  oracle.visit_in_range(p, 2, inRange);
+  // point 1 is spatially close, but not in the remaining dimensions
+  BOOST_REQUIRE_EQUAL(inRange.visited.size(), 2);
+  BOOST_CHECK_CLOSE(inRange.visited[0], 0.25, 1e-6);
+  BOOST_CHECK_CLOSE(inRange.visited[2], 1.25, 1e-6);
+
+  Recorder closest;
+  oracle.visit_closest(p, 3, closest);
+  BOOST_REQUIRE_EQUAL(closest.visited.size(), 3);
+  BOOST_CHECK_CLOSE(closest.visited[1], 9.25, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(oracle_factory_picks_hybrid_grid) {
+  OracleFactoryXd factory;
+  factory.desiredOracle(OracleFactoryXd::UNIFORM_GRID);
+  OracleFactoryXd::Query query;
+  query.maxR = 0.5;
+  query.dimensions = 6;
+  auto oracle = factory.forQuery(query);
+  BOOST_CHECK(dynamic_cast<HybridGridXd *>(oracle.get()) != nullptr);
+
+  query.dimensions = 4;
+  oracle = factory.forQuery(query);
+  BOOST_CHECK(dynamic_cast<UniformGridXd *>(oracle.get()) != nullptr);
+}
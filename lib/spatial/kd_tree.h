@@ -0,0 +1,297 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+
+#pragma once
+
+#include "spatial_oracle.h"
+#include <Eigen/Core>
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <numeric>
+#include <queue>
+
+namespace MouseTrack {
+
+using namespace SpatialImpl;
+
+/// Exact KD-tree for low dimensional data (in the spirit of nanoflann).
+///
+/// Every inner node splits its points at the median of the dimension with
+/// the largest spread, leaves hold up to `leafSize` points. Nodes are stored
+/// in one vector, the points in leaf order (copied, for cache locality).
+///
+/// Queries track the squared distance from the query to the region of the
+/// current node incrementally, a subtree is skipped as soon as its region
+/// is further away than the search radius or the current k-th neighbor.
+///
+/// `compute()` reuses the memory of the previous tree.
+template <typename _Precision, int _Dim>
+class KdTree
+    : public SpatialOracle<Eigen::Matrix<_Precision, _Dim, Eigen::Dynamic,
+                                         Eigen::ColMajor + Eigen::AutoAlign>,
+                           _Precision> {
+public:
+  typedef Eigen::Matrix<_Precision, _Dim, Eigen::Dynamic,
+                        Eigen::ColMajor + Eigen::AutoAlign>
+      PointList;
+  typedef Eigen::Matrix<_Precision, _Dim, 1> Point;
+  typedef _Precision Precision;
+  typedef typename SpatialOracle<PointList, Precision>::Visitor Visitor;
+
+  /// `leafSize`: maximum number of points in a leaf
+  KdTree(int leafSize = 16) : _leafSize(std::max(1, leafSize)) {
+    // empty
+  }
+
+  virtual void compute(const PointList &points) {
+    if (_Dim == -1 && points.rows() > maxDims) {
+      throw "KdTree supports at most 16 dimensions.";
+    }
+    _points = &points;
+    _nodes.clear();
+    _order.resize(points.cols());
+    std::iota(_order.begin(), _order.end(), 0);
+    if (points.cols() == 0) {
+      _sorted.resize(points.rows(), 0);
+      return;
+    }
+    _bbMin = points.rowwise().minCoeff();
+    _bbMax = points.rowwise().maxCoeff();
+    Point min = _bbMin;
+    Point max = _bbMax;
+    build(0, points.cols(), min, max);
+    _sorted.resize(points.rows(), points.cols());
+    for (int i = 0; i < points.cols(); i += 1) {
+      _sorted.col(i) = points.col(_order[i]);
+    }
+  }
+
+  virtual std::vector<std::vector<PointIndex>>
+  find_closest(const PointList &ps, unsigned int k) const {
+    assert(_points != nullptr);
+    assert(k >= 1);
+    std::vector<std::vector<PointIndex>> results(ps.cols());
+    const bool parallel = ps.cols() >= minParallelQueries;
+#pragma omp parallel for schedule(dynamic, 16) if (parallel)
+    for (int pi = 0; pi < ps.cols(); ++pi) {
+      Closest closest(k);
+      search(ps.col(pi), closest);
+      auto &result = results[pi];
+      result.reserve(closest.candidates.size());
+      while (!closest.candidates.empty()) {
+        result.push_back(closest.candidates.top().second);
+        closest.candidates.pop();
+      }
+    }
+    return results;
+  }
+
+  virtual std::vector<std::vector<PointIndex>>
+  find_in_range(const PointList &ps, const Precision r) const {
+    assert(_points != nullptr);
+    std::vector<std::vector<PointIndex>> ranges(ps.cols());
+    const bool parallel = ps.cols() >= minParallelQueries;
+#pragma omp parallel for schedule(dynamic, 16) if (parallel)
+    for (int pi = 0; pi < ps.cols(); ++pi) {
+      auto &range = ranges[pi];
+      auto collect = [&range](PointIndex i, Precision) { range.push_back(i); };
+      InRange<decltype(collect)> inRange(r * r, collect);
+      search(ps.col(pi), inRange);
+    }
+    return ranges;
+  }
+
+  virtual void visit_closest(const Point &p, unsigned int k,
+                             Visitor &visitor) const {
+    assert(_points != nullptr);
+    assert(k >= 1);
+    Closest closest(k);
+    search(p, closest);
+    while (!closest.candidates.empty()) {
+      visitor(closest.candidates.top().second, closest.candidates.top().first);
+      closest.candidates.pop();
+    }
+  }
+
+  virtual void visit_in_range(const Point &p, const Precision r,
+                              Visitor &visitor) const {
+    assert(_points != nullptr);
+    auto forward = [&visitor](PointIndex i, Precision d) { visitor(i, d); };
+    InRange<decltype(forward)> inRange(r * r, forward);
+    search(p, inRange);
+  }
+
+private:
+  /// Supported dimensions for dynamic sized trees
+  static constexpr int maxDims = 16;
+
+  /// Per dimension distances, never allocates memory
+  typedef Eigen::Array<Precision, _Dim, 1, Eigen::ColMajor,
+                       (_Dim == -1 ? maxDims : _Dim), 1>
+      Offsets;
+
+  struct Node {
+    /// split dimension, -1 for leaves
+    int dim;
+    /// inner nodes: largest coordinate of the left child and smallest
+    /// coordinate of the right child in `dim`
+    Precision low, high;
+    /// leaves: range in `_order`, inner nodes: indices of the children
+    PointIndex first, second;
+  };
+
+  /// Collects the points within a fixed squared radius
+  template <typename F> struct InRange {
+    InRange(Precision r2, const F &f) : r2(r2), f(f) {}
+    Precision worst() const { return r2; }
+    void add(PointIndex i, Precision d) {
+      if (d <= r2) {
+        f(i, d);
+      }
+    }
+    const Precision r2;
+    const F &f;
+  };
+
+  /// Keeps the k closest points, the furthest on top
+  struct Closest {
+    Closest(unsigned int k) : k(k) {}
+    Precision worst() const {
+      return candidates.size() < k ? std::numeric_limits<Precision>::max()
+                                   : candidates.top().first;
+    }
+    void add(PointIndex i, Precision d) {
+      if (d < worst()) {
+        candidates.push(std::make_pair(d, i));
+        if (candidates.size() > k) {
+          candidates.pop();
+        }
+      }
+    }
+    const unsigned int k;
+    std::priority_queue<std::pair<Precision, PointIndex>> candidates;
+  };
+
+  const int _leafSize;
+  const PointList *_points = nullptr;
+  /// points in leaf order
+  PointList _sorted;
+  /// `_sorted.col(i)` is `_points->col(_order[i])`
+  std::vector<PointIndex> _order;
+  std::vector<Node> _nodes;
+  Point _bbMin;
+  Point _bbMax;
+
+  /// Builds the subtree of the points `_order[begin]` to `_order[end - 1]`
+  /// within the bounding box [min, max], returns the node index
+  PointIndex build(PointIndex begin, PointIndex end, Point &min, Point &max) {
+    const PointIndex index = _nodes.size();
+    _nodes.push_back(Node());
+    if (end - begin <= PointIndex(_leafSize)) {
+      _nodes[index].dim = -1;
+      _nodes[index].first = begin;
+      _nodes[index].second = end;
+      return index;
+    }
+    int dim;
+    (max - min).maxCoeff(&dim);
+    const PointIndex middle = begin + (end - begin) / 2;
+    const PointList &points = *_points;
+    auto less = [&points, dim](PointIndex a, PointIndex b) {
+      return points(dim, a) < points(dim, b);
+    };
+    std::nth_element(_order.begin() + begin, _order.begin() + middle,
+                     _order.begin() + end, less);
+    Precision low = points(dim, _order[begin]);
+    for (PointIndex i = begin + 1; i < middle; ++i) {
+      low = std::max(low, points(dim, _order[i]));
+    }
+    const Precision high = points(dim, _order[middle]);
+
+    const Precision oldMax = max[dim];
+    max[dim] = low;
+    const PointIndex left = build(begin, middle, min, max);
+    max[dim] = oldMax;
+    const Precision oldMin = min[dim];
+    min[dim] = high;
+    const PointIndex right = build(middle, end, min, max);
+    min[dim] = oldMin;
+
+    Node &node = _nodes[index];
+    node.dim = dim;
+    node.low = low;
+    node.high = high;
+    node.first = left;
+    node.second = right;
+    return index;
+  }
+
+  template <typename P, typename Result>
+  void search(const P &p, Result &result) const {
+    if (_nodes.empty()) {
+      return;
+    }
+    // distance to the bounding box of all points
+    Offsets offsets = (_bbMin - p).cwiseMax(p - _bbMax).cwiseMax(0).array();
+    offsets = offsets * offsets;
+    searchNode(0, p, offsets.sum(), offsets, result);
+  }
+
+  /// `minDist`: squared distance from `p` to the region of `node`,
+  /// `offsets`: its contribution per dimension
+  template <typename P, typename Result>
+  void searchNode(PointIndex nodeIndex, const P &p, Precision minDist,
+                  Offsets &offsets, Result &result) const {
+    const Node &node = _nodes[nodeIndex];
+    if (node.dim == -1) {
+      for (PointIndex i = node.first; i < node.second; ++i) {
+        result.add(_order[i], (_sorted.col(i) - p).squaredNorm());
+      }
+      return;
+    }
+    const int dim = node.dim;
+    const Precision toLow = p[dim] - node.low;
+    const Precision toHigh = p[dim] - node.high;
+    PointIndex nearChild, farChild;
+    Precision cut;
+    if (toLow + toHigh < 0) {
+      // p is closer to the left child
+      nearChild = node.first;
+      farChild = node.second;
+      cut = toHigh * toHigh;
+    } else {
+      nearChild = node.second;
+      farChild = node.first;
+      cut = toLow * toLow;
+    }
+    searchNode(nearChild, p, minDist, offsets, result);
+
+    const Precision old = offsets[dim];
+    const Precision farDist = minDist - old + cut;
+    if (farDist <= result.worst()) {
+      offsets[dim] = cut;
+      searchNode(farChild, p, farDist, offsets, result);
+      offsets[dim] = old;
+    }
+  }
+};
+
+typedef KdTree<double, -1> KdTreeXd;
+typedef KdTree<double, 1> KdTree1d;
+typedef KdTree<double, 2> KdTree2d;
+typedef KdTree<double, 3> KdTree3d;
+typedef KdTree<double, 4> KdTree4d;
+typedef KdTree<double, 5> KdTree5d;
+typedef KdTree<double, 6> KdTree6d;
+
+typedef KdTree<float, -1> KdTreeXf;
+typedef KdTree<float, 1> KdTree1f;
+typedef KdTree<float, 2> KdTree2f;
+typedef KdTree<float, 3> KdTree3f;
+typedef KdTree<float, 4> KdTree4f;
+typedef KdTree<float, 5> KdTree5f;
+typedef KdTree<float, 6> KdTree6f;
+
+} // namespace MouseTrack
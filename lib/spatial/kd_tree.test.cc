@@ -0,0 +1,77 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "kd_tree.h"
+#include "oracle_test_util.h"
+#include <Eigen/Core>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+namespace utf = boost::unit_test;
+
+using namespace MouseTrack;
+using namespace Eigen;
+using namespace MouseTrack::OracleTest;
+
+BOOST_AUTO_TEST_CASE(kd_tree_4d_queries) {
+  KdTree4d::PointList all(4, 5);
+  all.col(0) = Vector4d(0.0, 0.0, 0.0, 0.0);
+  all.col(1) = Vector4d(2.0, 2.0, 2.0, 2.0);
+  all.col(2) = Vector4d(10.0, 0.0, 0.0, 0.0);
+  all.col(3) = Vector4d(0.0, -1.0, -1.0, -1.0);
+  all.col(4) = Vector4d(10.0, 1.0, 1.0, 1.0);
+  KdTree4d oracle(1);
+  oracle.compute(all);
+
+  Matrix<double, 4, 2> query;
+  query.col(0) = Vector4d(9.5, 0, 0, 0);
+  query.col(1) = Vector4d(0.1, 0.0, 0, 0);
+  auto result = oracle.find_in_range(query, 2);
+  std::multiset<PointIndex> received0(result[0].begin(), result[0].end());
+  std::multiset<PointIndex> received1(result[1].begin(), result[1].end());
+  BOOST_CHECK(received0 == std::multiset<PointIndex>({2, 4}));
+  BOOST_CHECK(received1 == std::multiset<PointIndex>({0, 3}));
+
+  query.col(0) = Vector4d(10.1, 0.9, 0.9, 0.9);
+  auto closest = oracle.find_closest(query, 1);
+  BOOST_REQUIRE_EQUAL(closest[0].size(), 1);
+  BOOST_CHECK_EQUAL(closest[0][0], 4);
+  BOOST_REQUIRE_EQUAL(closest[1].size(), 1);
+  BOOST_CHECK_EQUAL(closest[1][0], 0);
+}
+
+BOOST_AUTO_TEST_CASE(kd_tree_empty) {
+  KdTree3d::PointList none(3, 0);
+  KdTree3d oracle;
+  oracle.compute(none);
+  auto result = oracle.find_in_range(Vector3d(0, 0, 0), 1);
+  BOOST_REQUIRE_EQUAL(result.size(), 1);
+  BOOST_CHECK(result[0].empty());
+  result = oracle.find_closest(Vector3d(0, 0, 0), 1);
+  BOOST_REQUIRE_EQUAL(result.size(), 1);
+  BOOST_CHECK(result[0].empty());
+}
+
+BOOST_AUTO_TEST_CASE(kd_tree_duplicates) {
+  // more identical points than fit into a leaf
+  KdTree3d::PointList same = KdTree3d::PointList::Ones(3, 100);
+  KdTree3d oracle(4);
+  oracle.compute(same);
+  auto result = oracle.find_in_range(Vector3d(1, 1, 1.5), 0.6);
+  BOOST_CHECK_EQUAL(result[0].size(), 100);
+  result = oracle.find_closest(Vector3d(0, 0, 0), 7);
+  BOOST_CHECK_EQUAL(result[0].size(), 7);
+}
+
+BOOST_AUTO_TEST_CASE(kd_tree_matches_brute_force_3d) {
+  KdTree3d tree;
+  compareWithBruteForce(tree, 3, 2000, 0.2, 5);
+}
+
+BOOST_AUTO_TEST_CASE(kd_tree_matches_brute_force_dynamic) {
+  KdTreeXf tree(1);
+  compareWithBruteForce(tree, 6, 1000, 0.6, 5);
+}
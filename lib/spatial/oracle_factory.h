@@ -8,18 +8,36 @@
 
 #include "brute_force.h"
 #include "flann.h"
+#include "flat_grid.h"
+#include "hybrid_grid.h"
+#include "kd_tree.h"
 #include "uniform_grid.h"
 
 #include <boost/log/trivial.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
 
 namespace MouseTrack {
 
 /// Chooses and creates an implementation for a SpatialOracle based on given
 /// parameters.
 ///
-/// At the moment, it only chooses an implementation according to the value
-/// set to `desiredOracle()`.
+/// At the moment, it mostly chooses an implementation according to the value
+/// set to `desiredOracle()`. Grids for queries with more than four dimensions
+/// are replaced by a HybridGrid.
+///
+/// With AUTOTUNE, `forQuery()` benchmarks the oracles on a subsample of the
+/// query's example data and returns the fastest. The choice is remembered
+/// for the rest of the run, for queries with the same dimensions, `maxR`,
+/// `k`, `approximate` and a similar number of points. Approximate oracles
+/// (Flann) are only candidates if the query accepts approximate results.
 ///
 /// You have two options to request an oracle:
 ///
@@ -32,7 +50,15 @@ namespace MouseTrack {
 /// If you don't know a certain metric, leave it to the default value.
 template <typename Precision, int Dim = -1> class OracleFactory {
 public:
-  enum Oracles { BRUTE_FORCE, FLANN, UNIFORM_GRID };
+  enum Oracles {
+    BRUTE_FORCE,
+    FLANN,
+    UNIFORM_GRID,
+    FLAT_GRID,
+    KD_TREE,
+    HYBRID_GRID,
+    AUTOTUNE
+  };
 
   Oracles desiredOracle() const { return _desiredOracle; }
 
@@ -52,9 +78,13 @@ public:
     /// Dimensions of bounding box (bb_max - bb_min)
     Point *bb_size = nullptr;
     /// Characteristic data
-    PointList *example_data = nullptr;
+    const PointList *example_data = nullptr;
     /// Dimensionality of data points
     int dimensions = -1;
+    /// number of neighbors you intend to query (if you don't know `maxR`)
+    unsigned int k = 0;
+    /// whether approximate neighbors are good enough for your queries
+    bool approximate = false;
   };
 
   /// Fill a Query with the parameters you know.
@@ -65,39 +95,33 @@ public:
   /// the method.
   std::unique_ptr<Oracle> forQuery(const Query query) const {
     switch (desiredOracle()) {
+    case Oracles::AUTOTUNE:
+      return autotune(query);
     case Oracles::BRUTE_FORCE:
       return getBruteForce();
     case Oracles::FLANN:
       return getFlann();
+    case Oracles::KD_TREE:
+      return getKdTree();
     case Oracles::UNIFORM_GRID:
-      Precision maxR, cellSize;
+    case Oracles::FLAT_GRID:
+    case Oracles::HYBRID_GRID:
+      Precision maxR;
       if (query.maxR > 0) {
         maxR = query.maxR;
       } else if (query.bb_size != nullptr) {
         maxR = query.bb_size->norm() * 2;
       } else if (query.example_data != nullptr) {
-        auto max = query.example_data->array().colwise().maxCoeff();
-        auto min = query.example_data->array().colwise().minCoeff();
+        auto max = query.example_data->array().rowwise().maxCoeff();
+        auto min = query.example_data->array().rowwise().minCoeff();
         Point size = max - min;
         maxR = size.norm() * 2.0;
       } else {
         BOOST_LOG_TRIVIAL(info) << "Query contains not enought data to create "
-                                   "a UniformGrid, falling back to BruteForce";
+                                   "a grid, falling back to BruteForce";
         return getBruteForce();
       }
-      // maxR is known at this point, refine cellSize if possible
-      cellSize = maxR / 2;
-      if (query.bb_size != nullptr) {
-        Precision candidate = query.bb_size->minCoeff() / 10;
-        cellSize = std::min(candidate, cellSize);
-      } else if (query.example_data != nullptr) {
-        auto max = query.example_data->array().colwise().maxCoeff();
-        auto min = query.example_data->array().colwise().minCoeff();
-        auto size = max - min;
-        Precision candidate = size.minCoeff() / 10;
-        cellSize = std::min(candidate, cellSize);
-      }
-      int dimensions = -1;
+      int dimensions = Dim;
       if (query.dimensions != -1) {
         dimensions = query.dimensions;
       } else if (query.bb_size != nullptr) {
@@ -107,10 +131,25 @@ public:
       }
       if (Dim == -1 && dimensions == -1) {
         throw "Dynamic sized spatial oracle needs to know the data "
-              "dimensionality for UniformGrid.";
+              "dimensionality for a grid.";
       }
 
-      return getUniformGrid(maxR, cellSize, dimensions);
+      // the number of visited cells grows exponentially with the
+      // dimensions, index only the spatial coordinates of larger points
+      if (desiredOracle() == Oracles::HYBRID_GRID ||
+          dimensions > maxGridDimensions) {
+        if (dimensions >= HybridGrid<Precision, Dim>::spatialDims) {
+          return getHybridGrid(
+              maxR, cellSize(query, maxR,
+                             HybridGrid<Precision, Dim>::spatialDims));
+        }
+      }
+      if (desiredOracle() == Oracles::FLAT_GRID) {
+        return getFlatGrid(maxR, cellSize(query, maxR, dimensions),
+                           dimensions);
+      }
+      return getUniformGrid(maxR, cellSize(query, maxR, dimensions),
+                            dimensions);
     }
 
     return notFoundFallback();
@@ -123,8 +162,13 @@ public:
       return getBruteForce();
     case Oracles::FLANN:
       return std::make_unique<Flann<Precision, Dim>>();
+    case Oracles::KD_TREE:
+    case Oracles::AUTOTUNE:
+      return getKdTree();
     case Oracles::UNIFORM_GRID:
-      BOOST_LOG_TRIVIAL(info) << "UniformGrid not supported for general "
+    case Oracles::FLAT_GRID:
+    case Oracles::HYBRID_GRID:
+      BOOST_LOG_TRIVIAL(info) << "Grids are not supported for general "
                                  "request, falling back to BruteForce.";
       return getBruteForce();
     }
@@ -137,6 +181,188 @@ private:
   /// BruteForce always works but is slow.
   Oracles _desiredOracle = BRUTE_FORCE;
 
+  /// Grids over more dimensions only index the spatial coordinates
+  static constexpr int maxGridDimensions = 4;
+
+  /// Points and queries used to benchmark the candidates of `autotune()`
+  static constexpr int autotuneSamples = 4096;
+  static constexpr int autotuneQueries = 256;
+
+  /// An oracle with its parameters
+  struct Choice {
+    Oracles oracle;
+    /// cell size of grids relative to maxR
+    Precision cellSize;
+  };
+
+  /// Autotuning results per (dimensions, maxR, k, approximate, log2 of the
+  /// point count)
+  typedef std::tuple<int, Precision, unsigned int, bool, int> AutotuneKey;
+
+  /// Shared by all factories, so every setting is only tuned once per run
+  static std::map<AutotuneKey, Choice> &autotuned() {
+    static std::map<AutotuneKey, Choice> choices;
+    return choices;
+  }
+  static std::mutex &autotunedMutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  static const char *name(Oracles oracle) {
+    switch (oracle) {
+    case Oracles::BRUTE_FORCE:
+      return "BruteForce";
+    case Oracles::FLANN:
+      return "Flann";
+    case Oracles::UNIFORM_GRID:
+      return "UniformGrid";
+    case Oracles::FLAT_GRID:
+      return "FlatGrid";
+    case Oracles::KD_TREE:
+      return "KdTree";
+    case Oracles::HYBRID_GRID:
+      return "HybridGrid";
+    case Oracles::AUTOTUNE:
+      break;
+    }
+    return "unknown";
+  }
+
+  std::unique_ptr<Oracle> create(const Choice &choice, Precision maxR,
+                                 int dimensions) const {
+    switch (choice.oracle) {
+    case Oracles::FLANN:
+      return getFlann();
+    case Oracles::KD_TREE:
+      return getKdTree();
+    case Oracles::UNIFORM_GRID:
+      return getUniformGrid(maxR, choice.cellSize * maxR, dimensions);
+    case Oracles::FLAT_GRID:
+      return getFlatGrid(maxR, choice.cellSize * maxR, dimensions);
+    case Oracles::HYBRID_GRID:
+      return getHybridGrid(maxR, choice.cellSize * maxR);
+    default:
+      return getBruteForce();
+    }
+  }
+
+  /// Times the candidate oracles on a subsample of `query.example_data` and
+  /// returns the fastest. Grids are only candidates if `query.maxR` is known,
+  /// they can't answer knn queries beyond it. Flann is only a candidate if
+  /// `query.approximate` is set.
+  ///
+  /// The subsample is sparser than the data, range queries on it use a
+  /// larger radius, such that they find about as many points.
+  std::unique_ptr<Oracle> autotune(const Query &query) const {
+    if (query.example_data == nullptr || query.example_data->cols() == 0) {
+      BOOST_LOG_TRIVIAL(info) << "Autotuning needs example data, falling "
+                                 "back to KdTree.";
+      return getKdTree();
+    }
+    const PointList &data = *query.example_data;
+    const int dimensions = data.rows();
+    const Precision maxR = query.maxR;
+    const unsigned int k = query.k > 0 ? query.k : 8;
+    const AutotuneKey key(dimensions, maxR, maxR > 0 ? 0 : k,
+                          query.approximate,
+                          int(std::log2(double(data.cols()))));
+    {
+      std::lock_guard<std::mutex> lock(autotunedMutex());
+      auto found = autotuned().find(key);
+      if (found != autotuned().end()) {
+        return create(found->second, maxR, dimensions);
+      }
+    }
+
+    // evenly spread subsample, queries are a subset of it
+    const int n = std::min<int>(autotuneSamples, data.cols());
+    const int m = std::min(autotuneQueries, n);
+    PointList sample(dimensions, n);
+    for (int i = 0; i < n; i += 1) {
+      sample.col(i) = data.col(int64_t(i) * data.cols() / n);
+    }
+    PointList queries(dimensions, m);
+    for (int i = 0; i < m; i += 1) {
+      queries.col(i) = sample.col(int64_t(i) * n / m);
+    }
+    const Precision sampleR =
+        maxR * std::pow(double(data.cols()) / n, 1.0 / dimensions);
+
+    std::vector<Choice> candidates = {{Oracles::BRUTE_FORCE, 0},
+                                      {Oracles::KD_TREE, 0}};
+    if (query.approximate) {
+      candidates.push_back({Oracles::FLANN, 0});
+    }
+    if (maxR > 0) {
+      for (Precision cellSize : {0.25, 0.5, 1.0}) {
+        if (dimensions <= maxGridDimensions) {
+          candidates.push_back({Oracles::UNIFORM_GRID, cellSize});
+          candidates.push_back({Oracles::FLAT_GRID, cellSize});
+        } else if (dimensions >= HybridGrid<Precision, Dim>::spatialDims) {
+          candidates.push_back({Oracles::HYBRID_GRID, cellSize});
+        }
+      }
+    }
+
+    Choice best = candidates[0];
+    double bestTime = std::numeric_limits<double>::max();
+    for (const Choice &candidate : candidates) {
+      double time;
+      try {
+        auto start = std::chrono::steady_clock::now();
+        auto oracle = create(candidate, sampleR, dimensions);
+        oracle->compute(sample);
+        if (maxR > 0) {
+          oracle->find_in_range(queries, sampleR);
+        } else {
+          oracle->find_closest(queries, k);
+        }
+        auto end = std::chrono::steady_clock::now();
+        time = std::chrono::duration<double>(end - start).count();
+      } catch (const char *error) {
+        BOOST_LOG_TRIVIAL(debug) << "Autotuning: skipping oracle "
+                                 << name(candidate.oracle) << ": " << error;
+        continue;
+      }
+      BOOST_LOG_TRIVIAL(debug)
+          << "Autotuning: oracle " << name(candidate.oracle)
+          << " with cell size " << candidate.cellSize << " * maxR took " << time
+          << "s";
+      if (time < bestTime) {
+        bestTime = time;
+        best = candidate;
+      }
+    }
+    BOOST_LOG_TRIVIAL(info) << "Autotuning chose oracle " << name(best.oracle)
+                            << " with cell size " << best.cellSize << " * maxR"
+                            << " for " << dimensions << " dimensions, maxR "
+                            << maxR << " and " << data.cols() << " points";
+    {
+      std::lock_guard<std::mutex> lock(autotunedMutex());
+      autotuned().emplace(key, best);
+    }
+    return create(best, maxR, dimensions);
+  }
+
+  /// Cell size for a grid over the first `dims` dimensions of the data
+  Precision cellSize(const Query &query, Precision maxR, int dims) const {
+    Precision cellSize = maxR / 2;
+    Precision candidate = 0;
+    if (query.bb_size != nullptr) {
+      candidate = query.bb_size->head(dims).minCoeff() / 10;
+    } else if (query.example_data != nullptr) {
+      auto data = query.example_data->topRows(dims).array();
+      auto size = data.rowwise().maxCoeff() - data.rowwise().minCoeff();
+      candidate = size.minCoeff() / 10;
+    }
+    // flat data (e.g. a constant dimension) doesn't tell anything
+    if (candidate > 0) {
+      cellSize = std::min(candidate, cellSize);
+    }
+    return cellSize;
+  }
+
   std::unique_ptr<Oracle> notFoundFallback() const {
     BOOST_LOG_TRIVIAL(warning)
         << "Unknown desiredOracle encountered, falling back to BruteForce.";
@@ -151,10 +377,28 @@ private:
     return std::make_unique<UniformGrid<Precision, Dim>>(maxR, cellSize,
                                                          dimensions);
   }
+  std::unique_ptr<Oracle> getFlatGrid(Precision maxR, Precision cellSize,
+                                      int dimensions) const {
+    BOOST_LOG_TRIVIAL(debug)
+        << "creating FlatGrid oracle with maxR=" << maxR
+        << ", cellSize=" << cellSize << ", dimensions: " << dimensions;
+    return std::make_unique<FlatGrid<Precision, Dim>>(maxR, cellSize,
+                                                      dimensions);
+  }
+  std::unique_ptr<Oracle> getHybridGrid(Precision maxR,
+                                        Precision cellSize) const {
+    BOOST_LOG_TRIVIAL(debug) << "creating HybridGrid oracle with maxR=" << maxR
+                             << ", cellSize=" << cellSize;
+    return std::make_unique<HybridGrid<Precision, Dim>>(maxR, cellSize);
+  }
   std::unique_ptr<Oracle> getFlann() const {
     BOOST_LOG_TRIVIAL(debug) << "creating Flann oracle";
     return std::make_unique<Flann<Precision, Dim>>();
   }
+  std::unique_ptr<Oracle> getKdTree() const {
+    BOOST_LOG_TRIVIAL(debug) << "creating KdTree oracle";
+    return std::make_unique<KdTree<Precision, Dim>>();
+  }
   std::unique_ptr<Oracle> getBruteForce() const {
     BOOST_LOG_TRIVIAL(debug) << "creating Brute force oracle";
     return std::make_unique<BruteForce<Precision, Dim>>();
@@ -0,0 +1,63 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "oracle_factory.h"
+#include <Eigen/Core>
+#include <typeinfo>
+
+#include <boost/test/unit_test.hpp>
+
+namespace utf = boost::unit_test;
+
+using namespace MouseTrack;
+using namespace Eigen;
+
+BOOST_AUTO_TEST_CASE(oracle_factory_autotune_without_data) {
+  OracleFactoryXd factory;
+  factory.desiredOracle(OracleFactoryXd::AUTOTUNE);
+  OracleFactoryXd::Query query;
+  query.maxR = 0.1;
+  query.dimensions = 3;
+  auto oracle = factory.forQuery(query);
+  BOOST_CHECK(dynamic_cast<KdTreeXd *>(oracle.get()) != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(oracle_factory_autotune_memoizes) {
+  OracleFactoryXd factory;
+  factory.desiredOracle(OracleFactoryXd::AUTOTUNE);
+  const OracleFactoryXd::PointList data =
+      OracleFactoryXd::PointList::Random(6, 3000);
+  OracleFactoryXd::Query query;
+  query.maxR = 0.2;
+  query.example_data = &data;
+  auto first = factory.forQuery(query);
+  BOOST_REQUIRE(first != nullptr);
+  // grids over all dimensions are not considered for 6d data
+  BOOST_CHECK(dynamic_cast<UniformGridXd *>(first.get()) == nullptr);
+  BOOST_CHECK(dynamic_cast<FlatGridXd *>(first.get()) == nullptr);
+
+  // another factory with a similar query gets the same choice
+  OracleFactoryXd other;
+  other.desiredOracle(OracleFactoryXd::AUTOTUNE);
+  const OracleFactoryXd::PointList moreData =
+      OracleFactoryXd::PointList::Random(6, 3500);
+  query.example_data = &moreData;
+  auto second = other.forQuery(query);
+  BOOST_REQUIRE(second != nullptr);
+  BOOST_CHECK(typeid(*first) == typeid(*second));
+}
+
+BOOST_AUTO_TEST_CASE(oracle_factory_autotune_exact_by_default) {
+  OracleFactoryXd factory;
+  factory.desiredOracle(OracleFactoryXd::AUTOTUNE);
+  const OracleFactoryXd::PointList data =
+      OracleFactoryXd::PointList::Random(3, 5000);
+  OracleFactoryXd::Query query;
+  query.k = 30;
+  query.example_data = &data;
+  auto oracle = factory.forQuery(query);
+  BOOST_REQUIRE(oracle != nullptr);
+  BOOST_CHECK(dynamic_cast<FlannXd *>(oracle.get()) == nullptr);
+}
@@ -0,0 +1,95 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+/// Shared checks for the spatial oracle tests.
+///
+
+#pragma once
+
+#include "brute_force.h"
+#include <Eigen/Core>
+#include <cmath>
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+namespace MouseTrack {
+namespace OracleTest {
+
+/// Collects visited points and checks the reported distances
+template <typename Oracle> class CheckingVisitor : public Oracle::Visitor {
+public:
+  CheckingVisitor(const typename Oracle::PointList &points,
+                  const typename Oracle::Point &query)
+      : points(points), query(query) {}
+  void operator()(PointIndex i, typename Oracle::Precision d) {
+    BOOST_CHECK_SMALL(double((points.col(i) - query).squaredNorm() - d),
+                      1e-5);
+    visited.insert(i);
+  }
+  const typename Oracle::PointList &points;
+  const typename Oracle::Point query;
+  std::set<PointIndex> visited;
+};
+
+/// Removes the points that lie (numerically) on the sphere of radius `r`
+/// around `query`, oracles may disagree whether those are in range.
+template <typename PointList, typename Point>
+std::set<PointIndex> withoutTies(const std::set<PointIndex> &found,
+                                 const PointList &points, const Point &query,
+                                 double r) {
+  std::set<PointIndex> result;
+  for (PointIndex i : found) {
+    const double d = std::sqrt(double((points.col(i) - query).squaredNorm()));
+    if (std::abs(d - r) > 1e-9) {
+      result.insert(i);
+    }
+  }
+  return result;
+}
+
+/// Compares range and knn queries of `oracle` with BruteForce on random data
+template <typename Oracle>
+void compareWithBruteForce(Oracle &oracle, int dims, int n, double r, int k) {
+  typedef typename Oracle::PointList PointList;
+  PointList points = PointList::Random(dims, n);
+  // large enough to be processed in parallel
+  PointList queries = PointList::Random(dims, 300);
+  oracle.compute(points);
+  BruteForce<typename Oracle::Precision, -1> reference;
+  Eigen::Matrix<typename Oracle::Precision, -1, -1> ps = points;
+  Eigen::Matrix<typename Oracle::Precision, -1, -1> qs = queries;
+  reference.compute(ps);
+
+  auto inRange = oracle.find_in_range(queries, r);
+  auto expectedInRange = reference.find_in_range(qs, r);
+  BOOST_REQUIRE_EQUAL(inRange.size(), expectedInRange.size());
+  for (size_t q = 0; q < inRange.size(); ++q) {
+    std::set<PointIndex> received(inRange[q].begin(), inRange[q].end());
+    std::set<PointIndex> expected(expectedInRange[q].begin(),
+                                  expectedInRange[q].end());
+    BOOST_CHECK_EQUAL(received.size(), inRange[q].size());
+    BOOST_CHECK(withoutTies(expected, points, queries.col(q), r) ==
+                withoutTies(received, points, queries.col(q), r));
+
+    CheckingVisitor<Oracle> visitor(points, queries.col(q));
+    oracle.visit_in_range(queries.col(q), r, visitor);
+    BOOST_CHECK(visitor.visited == received);
+  }
+
+  auto closest = oracle.find_closest(queries, k);
+  auto expectedClosest = reference.find_closest(qs, k);
+  for (size_t q = 0; q < closest.size(); ++q) {
+    std::set<PointIndex> received(closest[q].begin(), closest[q].end());
+    std::set<PointIndex> expected(expectedClosest[q].begin(),
+                                  expectedClosest[q].end());
+    BOOST_CHECK(expected == received);
+
+    CheckingVisitor<Oracle> visitor(points, queries.col(q));
+    oracle.visit_closest(queries.col(q), k, visitor);
+    BOOST_CHECK(visitor.visited == received);
+  }
+}
+
+} // namespace OracleTest
+} // namespace MouseTrack
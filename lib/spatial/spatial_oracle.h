@@ -6,13 +6,26 @@
 
 #include "generic/types.h"
 #include <Eigen/Core>
+#include <vector>
 
 namespace MouseTrack {
 
+namespace SpatialImpl {
+
+/// Batched queries with at least this many query points are spread over
+/// all cores. Each query is answered by one thread, so the results don't
+/// depend on the number of threads.
+constexpr int minParallelQueries = 128;
+
+} // namespace SpatialImpl
+
 /// A spatial oracle takes a list of points via the `compute()` method,
 /// proecesses and stores it internally, and allows the client
 /// to perform spatial queries.
 ///
+/// Queries don't modify the oracle: once `compute()` returned, several
+/// threads may query the same oracle concurrently.
+///
 /// `PointList`:
 ///
 /// `Precision`: desired numerical precision (double, float)
@@ -25,6 +38,19 @@ public:
   /// Make available to client
   typedef _Precision Precision;
 
+  /// A single point, a column of `PointList`
+  typedef Eigen::Matrix<Precision, PointList::RowsAtCompileTime, 1> Point;
+
+  /// Receives the results of a `visit_*` query one by one, so the caller
+  /// can process them without collecting them first.
+  class Visitor {
+  public:
+    virtual ~Visitor() = default;
+
+    /// Point `index` is at squared distance `squaredDistance` to the query
+    virtual void operator()(PointIndex index, Precision squaredDistance) = 0;
+  };
+
   /// Set points you want to perform queries on.
   /// The spatial oracle is not responsible for the lifetime of `points`,
   /// you have to take care of that. `points` needs to exist as long as
@@ -34,13 +60,29 @@ public:
   virtual void compute(const PointList &points) = 0;
 
   /// Find `k` nearest points to `p`
+  ///
+  /// Large batches are processed in parallel.
   virtual std::vector<std::vector<PointIndex>>
   find_closest(const PointList &ps, unsigned int k = 1) const = 0;
 
   /// Give an index-list of all points within distance `r` around `p`
   /// The indexes are returned in random order.
+  ///
+  /// Large batches are processed in parallel.
   virtual std::vector<std::vector<PointIndex>>
   find_in_range(const PointList &ps, Precision r) const = 0;
+
+  /// Calls `visitor` for the `k` nearest points to `p` in no particular
+  /// order.
+  virtual void visit_closest(const Point &p, unsigned int k,
+                             Visitor &visitor) const = 0;
+
+  /// Calls `visitor` for all points within distance `r` around `p` in no
+  /// particular order.
+  ///
+  /// Unlike `find_in_range`, this doesn't allocate memory for the results.
+  virtual void visit_in_range(const Point &p, Precision r,
+                              Visitor &visitor) const = 0;
 };
 
 } // namespace MouseTrack
@@ -0,0 +1,153 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+
+#pragma once
+
+#include "cubic_neighborhood.h"
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace MouseTrack {
+
+namespace SpatialImpl {
+
+// declarations
+template <int _Dim> class SphericalNeighborhoodLayer;
+
+/// Like CubicNeighborhood, but only contains the cells that can hold points
+/// within a given distance of the center cell (a ball instead of a cube).
+///
+/// The gap of a cell is the minimal distance between any point of the
+/// center cell and any point of the cell, measured in cell counts. Layer 0
+/// holds all cells with gap 0 (the direct neighbors), layer l > 0 the cells
+/// with a gap in (l - 1, l].
+///
+/// For large radii, a cube of cells holds 2^d / (volume of the unit ball)
+/// times more cells than the ball: about 3x in 4d and 6x in 5d.
+template <int _Dim> class SphericalNeighborhood {
+  std::vector<SphericalNeighborhoodLayer<_Dim>> _layers;
+
+  /// Adds all cells with a squared gap of at most `maxGap2` to `cells`,
+  /// keyed by their squared gap
+  static void
+  collect(int d, int maxLayer, int gap2, int maxGap2,
+          CellCoordinate<_Dim> &cell,
+          std::vector<std::pair<int, CellCoordinate<_Dim>>> &cells) {
+    if (d == cell.rows()) {
+      cells.push_back(std::make_pair(gap2, cell));
+      return;
+    }
+    for (int c = -maxLayer - 1; c <= maxLayer + 1; c += 1) {
+      const int gap = std::max(0, std::abs(c) - 1);
+      if (gap2 + gap * gap > maxGap2) {
+        continue;
+      }
+      cell[d] = c;
+      collect(d + 1, maxLayer, gap2 + gap * gap, maxGap2, cell, cells);
+    }
+  }
+
+  void _createLayersUpTo(const int maxLayer, const int dims) {
+    assert(maxLayer >= 0);
+    CellCoordinate<_Dim> cell;
+    if (_Dim == -1) {
+      cell.resize(dims);
+    }
+    std::vector<std::pair<int, CellCoordinate<_Dim>>> cells;
+    collect(0, maxLayer, 0, maxLayer * maxLayer, cell, cells);
+    // closer cells first
+    std::stable_sort(cells.begin(), cells.end(),
+                     [](const std::pair<int, CellCoordinate<_Dim>> &a,
+                        const std::pair<int, CellCoordinate<_Dim>> &b) {
+                       return a.first < b.first;
+                     });
+
+    std::vector<std::vector<CellCoordinate<_Dim>>> layerCells(maxLayer + 1);
+    int layer = 0;
+    for (auto &c : cells) {
+      // smallest layer l with gap <= l
+      while (layer * layer < c.first) {
+        layer += 1;
+      }
+      layerCells[layer].push_back(std::move(c.second));
+    }
+
+    _layers.resize(maxLayer + 1);
+    for (int i = 0; i < maxLayer + 1; i += 1) {
+      _layers[i] =
+          SphericalNeighborhoodLayer<_Dim>(std::move(layerCells[i]), dims);
+    }
+  }
+
+public:
+  /// maxLayer: index of outtest layer you intend to access, the neighborhood
+  /// contains all cells with a gap of at most `maxLayer`.
+  ///
+  /// `dims`: number of dimensions, ignored if defined by template
+  SphericalNeighborhood(int maxLayer, int dims = -1) {
+    int d = _Dim == -1 ? dims : _Dim;
+    if (_Dim == -1 && dims <= 0) {
+      throw "Dynamic sized SphericalNeighborhood needs positive number of "
+            "dimensions.";
+    }
+    _createLayersUpTo(maxLayer, d);
+  }
+  /// creates empty neighborhood
+  SphericalNeighborhood() {
+    // empty
+  }
+  int size() const { return _layers.size(); }
+  const SphericalNeighborhoodLayer<_Dim> &operator[](int l) const {
+    return _layers[l];
+  }
+};
+
+template <int _Dim> class SphericalNeighborhoodLayer {
+  double minDist = 0;
+  double maxDist = 0;
+  /// cells of this layer, sorted by their gap
+  std::vector<CellCoordinate<_Dim>> coordinates;
+
+public:
+  SphericalNeighborhoodLayer() {
+    // empty
+  }
+  /// Construct a layer of `cells`
+  SphericalNeighborhoodLayer(std::vector<CellCoordinate<_Dim>> &&cells,
+                             int dims = -1) {
+    if (_Dim == -1 && dims <= 0) {
+      throw "Dynamic sized neighborhood layer needs positive number of "
+            "dimension.";
+    }
+    coordinates = std::move(cells);
+    if (coordinates.empty()) {
+      return;
+    }
+    minDist = std::numeric_limits<double>::max();
+    for (const auto &cell : coordinates) {
+      auto abs = cell.array().abs().template cast<double>();
+      minDist = std::min(minDist, (abs - 1).max(0).matrix().norm());
+      maxDist = std::max(maxDist, (abs + 1).matrix().norm());
+    }
+  }
+  const CellCoordinate<_Dim> &operator[](int i) const {
+    return coordinates[i];
+  }
+  int size() const { return coordinates.size(); }
+  /// minimal distance of a point in this layer to any point of the center
+  /// cell measured in cell counts
+  double min() const { return minDist; }
+  /// maximal distance of a point in this layer to any point of the center
+  /// cell measured in cell counts
+  double max() const { return maxDist; }
+};
+
+} // namespace SpatialImpl
+
+} // namespace MouseTrack
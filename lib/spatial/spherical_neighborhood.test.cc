@@ -0,0 +1,65 @@
+/// \file
+/// Maintainer: Felice Serena
+///
+///
+
+#include "cubic_neighborhood.h"
+#include "spherical_neighborhood.h"
+
+#include <boost/test/floating_point_comparison.hpp>
+#include <boost/test/unit_test.hpp>
+
+namespace utf = boost::unit_test;
+
+using namespace Eigen;
+using namespace MouseTrack::SpatialImpl;
+
+BOOST_AUTO_TEST_CASE(spherical_neighborhood_layers) {
+  SphericalNeighborhood<3> neigh(2);
+  BOOST_REQUIRE_EQUAL(neigh.size(), 3);
+
+  // all direct neighbors touch the center cell
+  BOOST_CHECK_EQUAL(neigh[0].size(), 27);
+  BOOST_CHECK_EQUAL(neigh[0][0], Vector3i(-1, -1, -1));
+  BOOST_CHECK_CLOSE(neigh[0].min(), 0.0, 0.00001);
+  BOOST_CHECK_CLOSE(neigh[0].max(), std::sqrt(3 * 2 * 2), 0.00001);
+
+  // one coordinate is +-2, the others in [-1, 1]
+  BOOST_CHECK_EQUAL(neigh[1].size(), 3 * 2 * 9);
+  BOOST_CHECK_CLOSE(neigh[1].min(), 1.0, 0.00001);
+
+  BOOST_CHECK_CLOSE(neigh[2].min(), std::sqrt(2.0), 0.00001);
+  BOOST_CHECK_CLOSE(neigh[2].max(), std::sqrt(3 * 3 * 3), 0.00001);
+}
+
+BOOST_AUTO_TEST_CASE(spherical_neighborhood_contains_ball) {
+  // every cell of the cube with a gap <= maxLayer is in the neighborhood,
+  // and nothing else
+  const int maxLayer = 3;
+  const int dims = 4;
+  SphericalNeighborhood<-1> spherical(maxLayer, dims);
+  CubicNeighborhood<-1> cubic(maxLayer + 1, dims);
+
+  int expected = 0;
+  for (int l = 0; l < cubic.size(); l += 1) {
+    for (int i = 0; i < cubic[l].size(); i += 1) {
+      ArrayXi gap = (cubic[l][i].array().abs() - 1).max(0);
+      if ((gap * gap).sum() <= maxLayer * maxLayer) {
+        expected += 1;
+      }
+    }
+  }
+  int received = 0;
+  for (int l = 0; l < spherical.size(); l += 1) {
+    for (int i = 0; i < spherical[l].size(); i += 1) {
+      ArrayXi gap = (spherical[l][i].array().abs() - 1).max(0);
+      const int gap2 = (gap * gap).sum();
+      BOOST_CHECK_LE(gap2, l * l);
+      BOOST_CHECK(l == 0 || (l - 1) * (l - 1) < gap2);
+      received += 1;
+    }
+  }
+  BOOST_CHECK_EQUAL(received, expected);
+  // the ball is a lot smaller than the cube
+  BOOST_CHECK_LT(received, std::pow(2 * maxLayer + 3, dims) / 2);
+}
@@ -4,11 +4,14 @@
 
 #pragma once
 
-#include "cubic_neighborhood.h"
 #include "spatial_oracle.h"
+#include "spherical_neighborhood.h"
 #include <Eigen/Core>
 #include <boost/log/trivial.hpp>
+#include <cstdint>
+#include <limits>
 #include <queue>
+#include <unordered_map>
 
 namespace std {
 
@@ -52,6 +55,7 @@ public:
       PointList;
   typedef Eigen::Matrix<_Precision, _Dim, 1> Point;
   typedef _Precision Precision;
+  typedef typename SpatialOracle<PointList, Precision>::Visitor Visitor;
 
 private:
   /// A word about coordiante systems, there are three:
@@ -61,17 +65,28 @@ private:
   /// - Bounding box grid: a grid from [0, resolution), it has
   ///   discrete indexes and is aligned with the `bb_` coordinates.
   ///
-  /// - Neighbor grid: relative indices in [-maxLayer, maxLayer] to
+  /// - Neighbor grid: relative indices in [-maxLayer - 1, maxLayer + 1] to
   ///   walk the neighborhood in the bounding box grid.
+  ///
+  /// Cells are stored by their linear id in the bounding box grid padded
+  /// with `padding` empty cells on each side. The neighbors of a cell inside
+  /// the bounding box never leave the padded grid, so their ids are the id
+  /// of the cell plus a precomputed offset, no bounds checks needed.
 
   /// type alias
   typedef Eigen::Matrix<int, _Dim, 1> GridCellIndex;
   typedef CellCoordinate<_Dim> Cell;
-  typedef CubicNeighborhood<_Dim> _Neighborhood;
+  typedef std::int64_t CellId;
+  typedef Eigen::Matrix<CellId, _Dim, 1> Strides;
+  typedef SphericalNeighborhood<_Dim> _Neighborhood;
 
   /// Points over which we perform queries
   const PointList *points = nullptr;
 
+  Precision maxR;
+
+  int dims;
+
   /// Minimum point of bounding box
   Point bb_min;
 
@@ -81,17 +96,30 @@ private:
   /// size of bounding box
   Point bb_size;
 
-  /// Width of a cell
+  /// Width of a cell as configured
+  Precision targetCellWidth;
+
+  /// Width of a cell used by the last `compute()`, coarser than
+  /// `targetCellWidth` if the bounding box needs too many cells
   Precision cellWidth;
 
   _Neighborhood neighborhood;
 
+  /// cell id offsets of the neighborhood, one vector per layer
+  std::vector<std::vector<CellId>> layerIds;
+
   GridCellIndex resolution;
 
+  /// empty cells on each side of the bounding box grid
+  int padding;
+
+  /// cell id = sum of padded cell coordinate times stride
+  Strides strides;
+
   /// largest dimension of grid
   int maxDiameter;
 
-  std::unordered_map<Cell, std::vector<PointIndex>> grid;
+  std::unordered_map<CellId, std::vector<PointIndex>> grid;
 
   Cell indexOfPosition(const Point &p) const {
     auto normalized = ((p - bb_min) / cellWidth).array().floor();
@@ -107,9 +135,20 @@ private:
     }
     return true;
   }
+
+  CellId cellId(const Cell &cell) const {
+    return (cell.array() + padding).template cast<CellId>().matrix().dot(
+        strides);
+  }
+
+  void createNeighborhood() {
+    neighborhood = _Neighborhood(std::ceil(maxR / cellWidth) + 1, dims);
+  }
+
   /// recache data
   void _compute() {
     assert(points != nullptr);
+    grid.clear();
     if (points->size() == 0) {
       return;
     }
@@ -124,32 +163,93 @@ private:
     bb_size = bb_max - bb_min;
     if (_Dim == -1) {
       resolution.resize(bb_size.rows());
+      strides.resize(bb_size.rows());
     }
 
+    // the cell ids need to fit into CellId, coarsen the grid otherwise
+    if (cellWidth != targetCellWidth) {
+      cellWidth = targetCellWidth;
+      createNeighborhood();
+    }
+    while (true) {
+      padding = neighborhood.size();
+      double cells = 1;
+      for (int d = 0; d < bb_size.rows(); d += 1) {
+        cells *= std::max(1.0, std::ceil(double(bb_size[d]) / cellWidth)) +
+                 2 * padding;
+      }
+      if (cells < double(std::numeric_limits<CellId>::max() / 4)) {
+        break;
+      }
+      cellWidth *= 2;
+      BOOST_LOG_TRIVIAL(debug)
+          << "UniformGrid: too many cells, increasing cell width to "
+          << cellWidth;
+      createNeighborhood();
+    }
+
+    CellId stride = 1;
     for (int d = 0; d < bb_size.rows(); d += 1) {
-      resolution[d] = std::max(1.0, std::ceil(bb_size[d] / cellWidth));
+      resolution[d] =
+          std::max(Precision(1), std::ceil(bb_size[d] / cellWidth));
+      strides[d] = stride;
+      stride *= resolution[d] + 2 * padding;
     }
 
     maxDiameter = resolution.array().maxCoeff();
 
-    // create grid
-    grid.erase(grid.begin(), grid.end());
+    layerIds.resize(neighborhood.size());
+    for (int l = 0; l < neighborhood.size(); l += 1) {
+      const auto &layer = neighborhood[l];
+      layerIds[l].resize(layer.size());
+      for (int i = 0; i < layer.size(); i += 1) {
+        layerIds[l][i] = layer[i].template cast<CellId>().dot(strides);
+      }
+    }
 
     // fill grid with indices
     for (int i = 0; i < points->cols(); i += 1) {
-      auto j = indexOfPosition(points->col(i));
-      auto &vec = grid[j];
+      auto &vec = grid[cellId(indexOfPosition(points->col(i)))];
       vec.push_back(i);
     }
   }
 
+  /// Calls `f(indices)` with the point indices of each occupied cell in
+  /// layer `l` around `zeroCell`
+  template <typename F>
+  void forEachCell(const Cell &zeroCell, int l, const F &f) const {
+    const auto &layer = neighborhood[l];
+    const auto &ids = layerIds[l];
+    const bool inside = in_bb(zeroCell);
+    const CellId zeroId = inside ? cellId(zeroCell) : 0;
+    for (int i = 0; i < layer.size(); i += 1) {
+      CellId id;
+      if (inside) {
+        id = zeroId + ids[i];
+      } else {
+        // the query is outside of the bounding box, only neighbors inside
+        // have valid ids
+        Cell cell = zeroCell + layer[i];
+        if (!in_bb(cell)) {
+          continue;
+        }
+        id = cellId(cell);
+      }
+      const auto candidates = grid.find(id);
+      if (candidates != grid.end()) {
+        f(candidates->second);
+      }
+    }
+  }
+
 public:
   /// Create a grid with a cell size of `cellWidth` and support
   /// for range queries of up to `maxR`.
   UniformGrid(Precision maxR, Precision cellWidth, int dims = -1)
-      : cellWidth(cellWidth) {
+      : maxR(maxR), dims(dims), targetCellWidth(cellWidth),
+        cellWidth(cellWidth) {
     assert(cellWidth > 0);
-    neighborhood = _Neighborhood(std::ceil(maxR / cellWidth) + 1, dims);
+    createNeighborhood();
   }
 
   virtual void compute(const PointList &src) {
@@ -157,55 +257,19 @@ public:
     _compute();
   }
 
+  /// Cell width used by the last `compute()`, might be coarser than
+  /// configured for huge bounding boxes
+  Precision currentCellWidth() const { return cellWidth; }
+
   virtual std::vector<std::vector<PointIndex>>
   find_closest(const PointList &ps, unsigned int k) const {
     assert(points != nullptr);
     assert(k >= 1);
     std::vector<std::vector<PointIndex>> results(ps.cols());
+    const bool parallel = ps.cols() >= minParallelQueries;
+#pragma omp parallel for schedule(dynamic, 16) if (parallel)
     for (int pi = 0; pi < ps.cols(); ++pi) {
-      // idea: we define hollow cubes around the cell containing p, called
-      // layers we search the layers from the inside to the outside if we have
-      // enough closest candidates, we stop as soon as our active layer's
-      // closest point is above our furthest candidate
-      auto p = ps.col(pi);
-      auto zeroCell = indexOfPosition(p);
-      typedef std::pair<Precision, PointIndex> P;
-      std::priority_queue<P> neighbors;
-      neighbors.push(P(std::numeric_limits<Precision>::max(), (PointIndex)-1));
-      // We only loop up to the largest bounding box dimension (assumes cube
-      // shells)
-      for (int l = 0; l < neighborhood.size(); l += 1) {
-        const auto &layer = neighborhood[l];
-        double layerDist = layer.min() * cellWidth;
-        if (neighbors.top().first < layerDist * layerDist) {
-          // the closest point in the layer is further away than our worst
-          // candidate we can stop
-          break;
-        }
-        for (int i = 0; i < layer.size(); ++i) {
-          Cell cell = zeroCell + layer[i];
-          // skip, if outside of bounding box
-          if (!in_bb(cell)) {
-            continue;
-          }
-          // we are inside the bounding box and have to check against all verts
-          // in the cell
-          const auto candidates = grid.find(cell);
-          if (candidates == grid.end()) {
-            // no points stored in this cell
-            continue;
-          }
-          for (PointIndex cIndex : candidates->second) {
-            double dist = (points->col(cIndex) - p).squaredNorm();
-            if (dist < neighbors.top().first) {
-              neighbors.push(P(dist, cIndex));
-              if (neighbors.size() > k) {
-                neighbors.pop();
-              }
-            }
-          }
-        }
-      }
+      auto neighbors = closest(ps.col(pi), k);
       while (neighbors.size() > 0) {
         auto i = neighbors.top().second;
         if (i != (PointIndex)-1) {
@@ -221,39 +285,100 @@ public:
   find_in_range(const PointList &ps, const Precision r) const {
     assert(points != nullptr);
     std::vector<std::vector<PointIndex>> ranges(ps.cols());
+    const bool parallel = ps.cols() >= minParallelQueries;
+#pragma omp parallel for schedule(dynamic, 16) if (parallel)
     for (int pi = 0; pi < ps.cols(); ++pi) {
-      auto p = ps.col(pi);
-      auto zeroCell = indexOfPosition(p);
-      const double r2 = r * r;
-      for (int l = 0; l <= neighborhood.size(); l += 1) {
-        const auto &layer = neighborhood[l];
-        if (r < layer.min() * cellWidth) {
-          break;
-        }
-        for (int i = 0; i < layer.size(); i += 1) {
-          Cell cell = zeroCell + layer[i];
-          // skip, if outside of bounding box
-          if (!in_bb(cell)) {
-            continue;
-          }
-          // we are inside the bounding box and have to check against all verts
-          // in the cell
-          const auto candidates = grid.find(cell);
-          if (candidates == grid.end()) {
-            // no points stored in this cell
-            continue;
-          }
-          for (PointIndex c : candidates->second) {
-            auto &v = points->col(c);
-            double dist = (v - p).squaredNorm();
-            if (dist <= r2) {
-              ranges[pi].push_back(c);
+      auto &range = ranges[pi];
+      forEachInRange(ps.col(pi), r,
+                     [&range](PointIndex c, Precision) { range.push_back(c); });
+    }
+    return ranges;
+  }
+
+  virtual void visit_closest(const Point &p, unsigned int k,
+                             Visitor &visitor) const {
+    assert(points != nullptr);
+    assert(k >= 1);
+    auto neighbors = closest(p, k);
+    while (neighbors.size() > 0) {
+      if (neighbors.top().second != (PointIndex)-1) {
+        visitor(neighbors.top().second, neighbors.top().first);
+      }
+      neighbors.pop();
+    }
+  }
+
+  virtual void visit_in_range(const Point &p, const Precision r,
+                              Visitor &visitor) const {
+    assert(points != nullptr);
+    forEachInRange(p, r, [&visitor](PointIndex c, Precision dist) {
+      visitor(c, dist);
+    });
+  }
+
+private:
+  typedef std::pair<Precision, PointIndex> Candidate;
+
+  /// The `k` closest points to `p` with their squared distances, the
+  /// furthest on top. Contains a placeholder with index -1 if there are less
+  /// than `k` points in the neighborhood.
+  template <typename P>
+  std::priority_queue<Candidate> closest(const P &p, unsigned int k) const {
+    // idea: we define shells around the cell containing p, called layers
+    // (see SphericalNeighborhood) we search the layers from the inside to
+    // the outside if we have enough closest candidates, we stop as soon as
+    // our active layer's closest point is above our furthest candidate
+    auto zeroCell = indexOfPosition(p);
+    std::priority_queue<Candidate> neighbors;
+    neighbors.push(
+        Candidate(std::numeric_limits<Precision>::max(), (PointIndex)-1));
+    if (grid.empty()) {
+      return neighbors;
+    }
+    for (int l = 0; l < neighborhood.size(); l += 1) {
+      double layerDist = neighborhood[l].min() * cellWidth;
+      if (neighbors.top().first < layerDist * layerDist) {
+        // the closest point in the layer is further away than our worst
+        // candidate we can stop
+        break;
+      }
+      forEachCell(zeroCell, l, [&](const std::vector<PointIndex> &cell) {
+        for (PointIndex cIndex : cell) {
+          Precision dist = (points->col(cIndex) - p).squaredNorm();
+          if (dist < neighbors.top().first) {
+            neighbors.push(Candidate(dist, cIndex));
+            if (neighbors.size() > k) {
+              neighbors.pop();
             }
           }
         }
+      });
+    }
+    return neighbors;
+  }
+
+  /// Calls `f(index, squaredDistance)` for all points within distance `r`
+  /// around `p`
+  template <typename P, typename F>
+  void forEachInRange(const P &p, const Precision r, const F &f) const {
+    if (grid.empty()) {
+      return;
+    }
+    auto zeroCell = indexOfPosition(p);
+    const Precision r2 = r * r;
+    for (int l = 0; l < neighborhood.size(); l += 1) {
+      if (r < neighborhood[l].min() * cellWidth) {
+        break;
       }
+      forEachCell(zeroCell, l, [&](const std::vector<PointIndex> &cell) {
+        for (PointIndex c : cell) {
+          Precision dist = (points->col(c) - p).squaredNorm();
+          if (dist <= r2) {
+            f(c, dist);
+          }
+        }
+      });
     }
-    return ranges;
   }
 };
 
@@ -3,8 +3,10 @@
 ///
 ///
 
+#include "brute_force.h"
 #include "uniform_grid.h"
 #include <Eigen/Core>
+#include <map>
 #include <set>
 
 #include <boost/test/unit_test.hpp>
@@ -139,3 +141,96 @@ BOOST_AUTO_TEST_CASE(uniform_grid_Xd_find_closestK) {
       expected == received,
       "Expected and received set do not contain same elements.");
 }
+
+BOOST_AUTO_TEST_CASE(uniform_grid_visit_in_range) {
+  typedef UniformGrid4d UG;
+  UG::PointList all(4, 3);
+  all.col(0) = Vector4d(0.0, 0.0, 0.0, 0.0);
+  all.col(1) = Vector4d(0.5, 0.0, 0.0, 0.0);
+  all.col(2) = Vector4d(3.0, 0.0, 0.0, 0.0);
+
+  UG oracle(2, 10.0 / 20);
+  oracle.compute(all);
+
+  class Recorder : public UG::Visitor {
+  public:
+    void operator()(PointIndex i, double d) { visited[i] = d; }
+    std::map<PointIndex, double> visited;
+  };
+  Recorder recorder;
+  oracle.visit_in_range(Vector4d(0.0, 0, 0, 0), 1, recorder);
+  BOOST_REQUIRE_EQUAL(recorder.visited.size(), 2);
+  BOOST_CHECK_EQUAL(recorder.visited[0], 0.0);
+  BOOST_CHECK_EQUAL(recorder.visited[1], 0.25);
+
+  Recorder closest;
+  oracle.visit_closest(Vector4d(2.9, 0, 0, 0), 1, closest);
+  BOOST_REQUIRE_EQUAL(closest.visited.size(), 1);
+  BOOST_CHECK_CLOSE(closest.visited[2], 0.01, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(uniform_grid_coarsening_is_per_compute) {
+  UniformGrid3d oracle(1, 0.5);
+  UniformGrid3d::PointList huge(3, 2);
+  huge.col(0) = Vector3d(0, 0, 0);
+  huge.col(1) = Vector3d(1e9, 1e9, 1e9);
+  oracle.compute(huge);
+  BOOST_CHECK_GT(oracle.currentCellWidth(), 0.5);
+
+  // the next frame uses the configured width again
+  UniformGrid3d::PointList small(3, 2);
+  small.col(0) = Vector3d(0, 0, 0);
+  small.col(1) = Vector3d(0.9, 0, 0);
+  oracle.compute(small);
+  BOOST_CHECK_EQUAL(oracle.currentCellWidth(), 0.5);
+  auto result = oracle.find_in_range(Vector3d(0, 0, 0), 1);
+  BOOST_REQUIRE_EQUAL(result.size(), 1);
+  BOOST_CHECK_EQUAL(result[0].size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(uniform_grid_parallel_batch_matches_single_queries) {
+  typedef UniformGrid3d Oracle;
+  Oracle::PointList all = Oracle::PointList::Random(3, 2000);
+  Oracle::PointList queries = Oracle::PointList::Random(3, 1000);
+  Oracle oracle(0.3, 0.1);
+  oracle.compute(all);
+
+  auto ranges = oracle.find_in_range(queries, 0.2);
+  auto closest = oracle.find_closest(queries, 4);
+  BOOST_REQUIRE_EQUAL(ranges.size(), queries.cols());
+  BOOST_REQUIRE_EQUAL(closest.size(), queries.cols());
+  for (int q = 0; q < queries.cols(); ++q) {
+    const Vector3d p = queries.col(q);
+    BOOST_CHECK(ranges[q] == oracle.find_in_range(p, 0.2)[0]);
+    BOOST_CHECK(closest[q] == oracle.find_closest(p, 4)[0]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(uniform_grid_5d_matches_brute_force) {
+  typedef UniformGridXd Oracle;
+  Oracle::PointList all = Oracle::PointList::Random(5, 2000);
+  // some queries lie outside of the bounding box
+  Oracle::PointList queries = Oracle::PointList::Random(5, 200) * 1.5;
+  Oracle oracle(0.6, 0.2, 5);
+  oracle.compute(all);
+  BruteForceXd reference;
+  reference.compute(all);
+
+  auto ranges = oracle.find_in_range(queries, 0.6);
+  auto expectedRanges = reference.find_in_range(queries, 0.6);
+  auto closest = oracle.find_closest(queries, 3);
+  auto expectedClosest = reference.find_closest(queries, 3);
+  for (int q = 0; q < queries.cols(); ++q) {
+    BOOST_CHECK(std::set<PointIndex>(ranges[q].begin(), ranges[q].end()) ==
+                std::set<PointIndex>(expectedRanges[q].begin(),
+                                     expectedRanges[q].end()));
+    // only guaranteed if the neighbors are within maxR, the furthest
+    // neighbor comes first
+    if ((all.col(expectedClosest[q][0]) - queries.col(q)).norm() < 0.6) {
+      BOOST_CHECK(
+          std::set<PointIndex>(closest[q].begin(), closest[q].end()) ==
+          std::set<PointIndex>(expectedClosest[q].begin(),
+                               expectedClosest[q].end()));
+    }
+  }
+}
@@ -11,7 +11,7 @@ namespace MouseTrack {
 /// descriptor
 Eigen::Vector3d CogTrajectoryBuilder::
 operator()(const std::shared_ptr<const ClusterDescriptor>,
-           const Cluster &cluster, const PointCloud &cloud) const {
+           const Cluster &cluster, const PointCloudView &cloud) const {
   Eigen::VectorXd cog4 = cluster.center_of_gravity(cloud);
   return Eigen::Vector3d(cog4[0], cog4[1], cog4[2]);
 }
@@ -19,7 +19,7 @@ public:
   /// descriptor
   Eigen::Vector3d
   operator()(const std::shared_ptr<const ClusterDescriptor> descriptor,
-             const Cluster &cluster, const PointCloud &cloud) const;
+             const Cluster &cluster, const PointCloudView &cloud) const;
 };
 
 } // namespace MouseTrack
@@ -36,7 +36,7 @@ BOOST_AUTO_TEST_CASE(two_points_cog) {
 
   MouseTrack::CogTrajectoryBuilder tb;
 
-  Eigen::Vector3d cog = tb(cd, cluster, pc);
+  Eigen::Vector3d cog = tb(cd, cluster, MouseTrack::PointCloudView(pc));
 
   BOOST_CHECK_EQUAL(cog, Eigen::Vector3d(2, 1, 3));
 }
@@ -18,7 +18,7 @@ public:
   /// descriptor
   virtual Eigen::Vector3d
   operator()(const std::shared_ptr<const ClusterDescriptor> descriptor,
-             const Cluster &cluster, const PointCloud &cloud) const = 0;
+             const Cluster &cluster, const PointCloudView &cloud) const = 0;
 };
 
 } // namespace MouseTrack